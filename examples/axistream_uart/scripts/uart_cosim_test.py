@@ -1,13 +1,30 @@
 from tinyrpc.protocols.jsonrpc import JSONRPCProtocol
 from tinyrpc.transports.http import HttpPostClientTransport
 from tinyrpc import RPCClient
+import pathlib
 import random
+import requests
+import sys
 import time
 
+repo_path = pathlib.Path(__file__).resolve().parent.parent.parent.parent
+
+# Shared helpers for the example clients
+sys.path.append(str(repo_path / "src" / "python"))
+
+from uvvm_cosim_port import get_server_port
+
+
 def main():
+    port = get_server_port()
+
+    # Post with a session so the connection is kept open between calls
+    session = requests.Session()
+
     rpc_client = RPCClient(
         JSONRPCProtocol(),
-        HttpPostClientTransport('http://localhost:8484/jsonrpc'))
+        HttpPostClientTransport(f'http://localhost:{port}/jsonrpc',
+                                post_method=session.post))
 
     rpc_client.call(method="StartSim", args=None, kwargs=None)
 
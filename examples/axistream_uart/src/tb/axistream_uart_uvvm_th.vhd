@@ -43,13 +43,14 @@ architecture th of axistream_uart_uvvm_th is
   constant C_CLK_PERIOD : time    := 20 ns;
   constant C_CLK_FREQ   : natural := 50000000;
   constant C_BAUDRATE   : natural := 115200;
+  constant C_AXIS_DATA_WIDTH : natural := 8;
   
   signal clk       : std_logic;
   signal clk_cosim : std_logic;
   signal dut_rxd   : std_logic;
   signal dut_txd   : std_logic;
 
-  subtype t_axistream_8b is t_axistream_if(tdata(7 downto 0),
+  subtype t_axistream_8b is t_axistream_if(tdata(C_AXIS_DATA_WIDTH-1 downto 0),
                                            tkeep(0 downto 0),
                                            tuser(0 downto 0),
                                            tstrb(0 downto 0),
@@ -95,7 +96,8 @@ begin
 
   i_uvvm_cosim: entity uvvm_cosim_lib.uvvm_cosim
     generic map (
-      GC_COSIM_EN => GC_COSIM_ENABLE)
+      GC_COSIM_EN         => GC_COSIM_ENABLE,
+      GC_AXIS_DATA_WIDTHS => (others => C_AXIS_DATA_WIDTH))
     port map (
       clk             => clk_cosim,
       vvc_config_done => vvc_config_done);
@@ -103,7 +105,7 @@ begin
   i_axistream_vvc_transmit : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => true,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
@@ -117,7 +119,7 @@ begin
   i_axistream_vvc_receive : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => false,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
@@ -1,54 +1,229 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <deque>
 #include <optional>
 #include <vector>
+#include "mapped_file.hpp"
+#include "sim_stamp.hpp"
 
 namespace uvvm_cosim {
 
 class ByteQueue {
 
-  std::deque<uint8_t> q;
+  // Bytes are stored contiguously from index head in buf, so the queue
+  // can be searched with memchr/memcmp. Space for consumed bytes at the
+  // front is reclaimed once it makes up more than half of the buffer.
+  static constexpr size_t C_COMPACT_MIN = 4096;
+
+  std::vector<uint8_t> buf;
+  size_t head = 0;
+
+  // Total number of bytes ever consumed from the queue. Lets callers
+  // keep track of positions in the stream across gets.
+  uint64_t consumed = 0;
+
+  // Largest size() since the queue was created or the mark was reset
+  size_t high_water = 0;
+
+  // Data put with put(ByteSpan) is only copied into buf a window at a
+  // time as it is consumed, so a large file can be queued without
+  // reading all of it into memory. Bytes put after a span are queued as
+  // spans as well to keep them in order.
+  static constexpr size_t C_REFILL_SIZE = 65536;
+
+  std::deque<ByteSpan> spans;
+  size_t spans_size = 0;
+
+  // Run-length encoded stamps for the bytes in the queue, in order.
+  // The counts always add up to size().
+  std::deque<SimStampRun> stamp_runs;
+
+  void add_stamp(size_t count, SimStamp stamp)
+  {
+    // Called by every put, before the data is added
+    high_water = std::max(high_water, size() + count);
+
+    if (!stamp_runs.empty() && stamp_runs.back().stamp == stamp) {
+      stamp_runs.back().count += count;
+    } else {
+      stamp_runs.push_back(SimStampRun{count, stamp});
+    }
+  }
+
+  // Remove the stamps for the first n bytes, optionally appending them to out
+  void take_stamps(size_t n, std::vector<SimStampRun>* out)
+  {
+    while (n > 0) {
+      SimStampRun& run = stamp_runs.front();
+      size_t count = std::min(n, run.count);
+
+      if (out) {
+        out->push_back(SimStampRun{count, run.stamp});
+      }
+
+      run.count -= count;
+      n -= count;
+
+      if (run.count == 0) {
+        stamp_runs.pop_front();
+      }
+    }
+  }
+
+  void put_span(ByteSpan span)
+  {
+    spans_size += span.size;
+    spans.push_back(std::move(span));
+  }
+
+  // Copy data from spans until there are at least n bytes in buf
+  void refill(size_t n)
+  {
+    while (buf.size() - head < n && !spans.empty()) {
+      ByteSpan& span = spans.front();
+      size_t len = std::min(span.size, std::max(C_REFILL_SIZE, n - (buf.size() - head)));
+
+      buf.insert(buf.end(), span.data(), span.data() + len);
+      span.consume(len);
+      spans_size -= len;
+
+      if (span.size == 0) {
+        spans.pop_front();
+      }
+    }
+  }
+
+  void consume(size_t n, std::vector<SimStampRun>* out_stamps = nullptr)
+  {
+    take_stamps(n, out_stamps);
+    head += n;
+    consumed += n;
+
+    if (head == buf.size()) {
+      buf.clear();
+      head = 0;
+    } else if (head > C_COMPACT_MIN && head > buf.size() / 2) {
+      buf.erase(buf.begin(), buf.begin() + head);
+      head = 0;
+    }
+  }
 
 public:
 
   bool empty(void) const {
-    return q.empty();
+    return head == buf.size() && spans.empty();
   }
 
   size_t size(void) const {
-    return q.size();
+    return buf.size() - head + spans_size;
   }
 
-  void put(uint8_t byte)
+  uint64_t consumed_count(void) const {
+    return consumed;
+  }
+
+  size_t high_water_mark(void) const {
+    return high_water;
+  }
+
+  // Restart the high-water mark from the current size
+  void reset_high_water_mark(void) {
+    high_water = size();
+  }
+
+  // Bytes can be stamped with the time they were put in the queue, which
+  // is returned by get() when requested
+  void put(uint8_t byte, SimStamp stamp = {})
   {
-    q.emplace_back(byte);
+    add_stamp(1, stamp);
+
+    if (spans.empty()) {
+      buf.push_back(byte);
+    } else {
+      put_span(ByteSpan::from_data({byte}));
+    }
   }
 
-  void put(const std::vector<uint8_t>& data) {
-    q.insert(q.end(), data.begin(), data.end());
+  void put(const std::vector<uint8_t>& data, SimStamp stamp = {}) {
+    if (data.empty()) {
+      return;
+    }
+
+    add_stamp(data.size(), stamp);
+
+    if (spans.empty()) {
+      buf.insert(buf.end(), data.begin(), data.end());
+    } else {
+      put_span(ByteSpan::from_data(data));
+    }
+  }
+
+  void put(ByteSpan span, SimStamp stamp = {}) {
+    if (span.size > 0) {
+      add_stamp(span.size, stamp);
+      put_span(std::move(span));
+    }
   }
 
   std::optional<uint8_t> get(void) {
-    if (q.empty()) {
+    if (empty()) {
       return {};
     } else {
-      uint8_t byte = q.front();
-      q.pop_front();
+      refill(1);
+      uint8_t byte = buf[head];
+      consume(1);
       return byte;
     }
   }
 
-  std::vector<uint8_t> get(size_t N) {
-    if (q.size() < N || N == 0) {
-      std::vector<uint8_t> data(q.begin(), q.end());
-      q.clear();
-      return data;
-    } else {
-      std::vector<uint8_t> data(q.begin(), q.begin()+N);
-      q.erase(q.begin(), q.begin()+N);
-      return data;
+  // Get up to N bytes (all bytes if N is zero). If stamps is given, the
+  // stamps for the returned bytes are appended to it.
+  std::vector<uint8_t> get(size_t N, std::vector<SimStampRun>* stamps = nullptr) {
+    if (size() < N || N == 0) {
+      N = size();
+    }
+
+    refill(N);
+
+    std::vector<uint8_t> data(buf.begin() + head, buf.begin() + head + N);
+    consume(N, stamps);
+    return data;
+  }
+
+  // Search for pattern starting at offset from the front of the queue.
+  // Returns the offset of the first byte of the first match, if any.
+  // Candidates are found with memchr on the first pattern byte before
+  // the rest of the pattern is compared. Any queued spans are copied
+  // into buf first.
+  std::optional<size_t> find(const std::vector<uint8_t>& pattern, size_t from = 0)
+  {
+    if (pattern.empty() || from >= size() || size() - from < pattern.size()) {
+      return {};
     }
+
+    refill(size());
+
+    const uint8_t* begin = buf.data() + head;
+    const uint8_t* last  = buf.data() + buf.size() - pattern.size();
+    const uint8_t* p     = begin + from;
+
+    while (p <= last) {
+      p = static_cast<const uint8_t*>(std::memchr(p, pattern[0], last - p + 1));
+
+      if (p == nullptr) {
+        break;
+      }
+
+      if (std::memcmp(p + 1, pattern.data() + 1, pattern.size() - 1) == 0) {
+        return p - begin;
+      }
+
+      p++;
+    }
+
+    return {};
   }
 
 };
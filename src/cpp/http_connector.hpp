@@ -0,0 +1,170 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <cpp-httplib/httplib.h>
+#include <jsonrpccxx/common.hpp>
+#include <jsonrpccxx/iclientconnector.hpp>
+#include <jsonrpccxx/server.hpp>
+
+// HTTP connectors for json-rpc-cxx based on cpp-httplib.
+//
+// Based on CppHttpLibServerConnector and CppHttpLibClientConnector from
+// the json-rpc-cxx examples. The server connector was extended to make
+// the bind address, thread pool and keep-alive behaviour configurable,
+// and both connectors keep connections open between requests and
+// disable Nagle's algorithm, since connection setup and delayed ACKs
+// make up a large part of the latency for the small requests used here.
+
+namespace uvvm_cosim {
+
+struct HttpServerConfig {
+  std::string bind_address = "localhost";
+
+  // Port 0 binds to any free port, which can be read with Port() after
+  // the server has started listening
+  int port = 8484;
+
+  // Number of worker threads, or 0 for cpp-httplib's default.
+  // Note that each open connection occupies a worker for as long as it is
+  // kept alive, and so does a blocking call such as WaitForPattern.
+  int threads = 0;
+
+  // How long an idle connection is kept open (in seconds), and how many
+  // requests can be sent on a connection before it is closed
+  int keepalive_timeout = 5;
+  int keepalive_max = 1000;
+};
+
+class HttpServerConnector {
+  jsonrpccxx::JsonRpcServer& server;
+  httplib::Server httpServer;
+  HttpServerConfig cfg;
+  std::thread thread;
+  int bound_port = 0;
+
+  // Set once the listen thread has entered the listen loop (or left it),
+  // since stop() has no effect before that
+  std::mutex listen_mtx;
+  std::condition_variable listen_cv;
+  bool listening = false;
+
+  void set_listening()
+  {
+    {
+      std::lock_guard<std::mutex> lock(listen_mtx);
+      listening = true;
+    }
+    listen_cv.notify_all();
+  }
+
+public:
+  HttpServerConnector(jsonrpccxx::JsonRpcServer& server, const HttpServerConfig& cfg)
+    : server(server)
+    , cfg(cfg)
+  {
+    // cpp-httplib creates the task queue after it has marked the server
+    // as running, right before it starts accepting connections
+    int threads = cfg.threads > 0 ? cfg.threads : CPPHTTPLIB_THREAD_POOL_COUNT;
+    httpServer.new_task_queue = [this, threads]() {
+      set_listening();
+      return new httplib::ThreadPool(threads);
+    };
+
+    httpServer.set_keep_alive_timeout(cfg.keepalive_timeout);
+    httpServer.set_keep_alive_max_count(cfg.keepalive_max);
+    httpServer.set_tcp_nodelay(true);
+
+    httpServer.Post("/jsonrpc", [this](const httplib::Request& req, httplib::Response& res) {
+      res.status = 200;
+      res.set_content(this->server.HandleRequest(req.body), "application/json");
+    });
+  }
+
+  ~HttpServerConnector()
+  {
+    StopListening();
+  }
+
+  // Bind to the configured address and serve requests on a background
+  // thread. Connections are accepted (queued in the listen backlog) as
+  // soon as this returns. Throws if the address can't be bound.
+  void StartListening()
+  {
+    if (thread.joinable()) {
+      return;
+    }
+
+    if (cfg.port == 0) {
+      bound_port = httpServer.bind_to_any_port(cfg.bind_address);
+    } else if (httpServer.bind_to_port(cfg.bind_address, cfg.port)) {
+      bound_port = cfg.port;
+    } else {
+      bound_port = -1;
+    }
+
+    if (bound_port < 0) {
+      bound_port = 0;
+      throw std::runtime_error("Failed to bind JSON-RPC server to " +
+                               cfg.bind_address + ":" + std::to_string(cfg.port));
+    }
+
+    listening = false;
+    thread = std::thread([this]() {
+      httpServer.listen_after_bind();
+      set_listening();
+    });
+  }
+
+  // Port the server is listening on, or 0 if it hasn't started
+  int Port() const
+  {
+    return bound_port;
+  }
+
+  void StopListening()
+  {
+    if (!thread.joinable()) {
+      return;
+    }
+
+    // The simulation can end right after the server was started, before
+    // the listen loop is running
+    {
+      std::unique_lock<std::mutex> lock(listen_mtx);
+      listen_cv.wait(lock, [this]() { return listening; });
+    }
+
+    httpServer.stop();
+    thread.join();
+  }
+};
+
+class HttpClientConnector : public jsonrpccxx::IClientConnector {
+  httplib::Client httpClient;
+
+public:
+  HttpClientConnector(const std::string& host, int port)
+    : httpClient(host, port)
+  {
+    httpClient.set_keep_alive(true);
+    httpClient.set_tcp_nodelay(true);
+  }
+
+  std::string Send(const std::string& request) override
+  {
+    auto res = httpClient.Post("/jsonrpc", request, "application/json");
+
+    if (!res || res->status != 200) {
+      throw jsonrpccxx::JsonRpcException(-32003, "client connector error, received status != 200");
+    }
+
+    return res->body;
+  }
+};
+
+} // namespace uvvm_cosim
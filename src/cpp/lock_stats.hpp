@@ -0,0 +1,202 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+namespace uvvm_cosim {
+
+enum LockOpKind { LOK_OTHER, LOK_FOREIGN, LOK_RPC };
+
+inline const char* to_string(LockOpKind kind)
+{
+  switch (kind) {
+  case LOK_FOREIGN: return "foreign";
+  case LOK_RPC:     return "rpc";
+  default:          return "other";
+  }
+}
+
+// Operation that lock statistics are attributed to
+struct LockOpTag {
+  LockOpKind kind = LOK_OTHER;
+  std::string_view name = "other";
+};
+
+// Names the operation the calling thread is doing for as long as it
+// exists, so lock statistics can be attributed to it. Nested scopes
+// override the outer scope. Locks taken outside any scope are counted
+// as "other".
+class LockOp {
+public:
+  // name must outlive the scope
+  LockOp(LockOpKind kind, std::string_view name) : prev(current)
+  {
+    current = LockOpTag{kind, name};
+  }
+
+  ~LockOp()
+  {
+    current = prev;
+  }
+
+  LockOp(const LockOp&) = delete;
+  LockOp& operator=(const LockOp&) = delete;
+
+  static LockOpTag tag()
+  {
+    return current;
+  }
+
+private:
+  inline static thread_local LockOpTag current;
+  LockOpTag prev;
+};
+
+// Histogram of durations with power of two buckets. Bucket i counts
+// durations from 2^i ns up to 2^(i+1) ns, except bucket 0 which starts
+// at 0 and the last bucket which has no upper bound.
+struct DurationHistogram {
+  static constexpr size_t NUM_BUCKETS = 32;
+
+  std::array<uint64_t, NUM_BUCKETS> buckets{};
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+  uint64_t max_ns = 0;
+
+  void add(uint64_t ns)
+  {
+    size_t bucket = ns < 2 ? 0 : std::bit_width(ns) - 1;
+
+    buckets[std::min(bucket, NUM_BUCKETS - 1)]++;
+    count++;
+    total_ns += ns;
+    max_ns = std::max(max_ns, ns);
+  }
+
+  // Upper bound of the bucket that contains the given fraction (0-1) of
+  // the durations, capped by the max
+  uint64_t percentile_ns(double fraction) const
+  {
+    uint64_t target = uint64_t(fraction * count);
+    uint64_t n = 0;
+
+    for (size_t i = 0; i < NUM_BUCKETS - 1; i++) {
+      n += buckets[i];
+
+      if (n > target || n == count) {
+        return std::min(uint64_t(2) << i, max_ns);
+      }
+    }
+
+    return max_ns;
+  }
+};
+
+struct LockOpStats {
+  LockOpKind kind;
+  DurationHistogram wait;
+  DurationHistogram hold;
+};
+
+using LockStatsReport = std::map<std::string, LockOpStats, std::less<>>;
+
+// Mutex that can record how long each acquisition waited for the lock
+// and how long the lock was then held, per LockOp. Recording is off
+// until enabled, and then costs two clock reads and a lookup by
+// operation name per acquisition. The statistics are only touched with
+// the mutex held, so they need no lock of their own.
+class InstrumentedMutex {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  void lock()
+  {
+    if (!enabled.load(std::memory_order_relaxed)) {
+      mtx.lock();
+      holder = nullptr;
+      return;
+    }
+
+    auto start = Clock::now();
+    mtx.lock();
+    acquired = Clock::now();
+
+    holder = &op_stats(LockOp::tag());
+    holder->wait.add(to_ns(acquired - start));
+  }
+
+  void unlock()
+  {
+    if (holder) {
+      holder->hold.add(to_ns(Clock::now() - acquired));
+      holder = nullptr;
+    }
+
+    mtx.unlock();
+  }
+
+  // Takes effect from the next acquisition
+  void set_enabled(bool enable)
+  {
+    enabled = enable;
+  }
+
+  bool is_enabled() const
+  {
+    return enabled;
+  }
+
+  // Statistics per operation so far. If reset is true, they start over
+  // after being read.
+  LockStatsReport report(bool reset)
+  {
+    std::lock_guard<InstrumentedMutex> lock(*this);
+
+    LockStatsReport copy = ops;
+
+    if (reset) {
+      // Cleared in place, since holder may point into ops
+      for (auto& [name, stats] : ops) {
+        stats.wait = DurationHistogram{};
+        stats.hold = DurationHistogram{};
+      }
+    }
+
+    return copy;
+  }
+
+private:
+  std::mutex mtx;
+  std::atomic<bool> enabled = false;
+
+  // Protected by mtx
+  LockStatsReport ops;
+  LockOpStats* holder = nullptr;
+  Clock::time_point acquired;
+
+  static uint64_t to_ns(Clock::duration d)
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+  }
+
+  LockOpStats& op_stats(const LockOpTag& tag)
+  {
+    auto it = ops.find(tag.name);
+
+    if (it == ops.end()) {
+      it = ops.emplace(std::string(tag.name), LockOpStats{.kind = tag.kind}).first;
+    }
+
+    return it->second;
+  }
+};
+
+} // namespace uvvm_cosim
@@ -0,0 +1,154 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace uvvm_cosim {
+
+// Read-only memory mapping of (part of) a file
+class MappedFile {
+  void* map_addr = MAP_FAILED;
+  size_t map_size = 0;
+
+  // Start of requested range within the mapping, which has to start
+  // on a page boundary
+  const uint8_t* begin = nullptr;
+  size_t length = 0;
+
+  static size_t page_size(void)
+  {
+    static const size_t size = sysconf(_SC_PAGESIZE);
+    return size;
+  }
+
+  MappedFile(const std::string& path, size_t offset, size_t len)
+  {
+    int fd = ::open(path.c_str(), O_RDONLY);
+
+    if (fd < 0) {
+      throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Failed to stat " + path + ": " + std::strerror(errno));
+    }
+
+    size_t file_size = st.st_size;
+
+    if (offset > file_size || (len != 0 && len > file_size - offset)) {
+      ::close(fd);
+      throw std::runtime_error("Range is outside of file " + path);
+    }
+
+    length = len == 0 ? file_size - offset : len;
+
+    if (length > 0) {
+      size_t map_offset = offset - offset % page_size();
+      map_size = length + (offset - map_offset);
+      map_addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, map_offset);
+
+      if (map_addr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+      }
+
+      madvise(map_addr, map_size, MADV_SEQUENTIAL);
+      begin = static_cast<const uint8_t*>(map_addr) + (offset - map_offset);
+    }
+
+    ::close(fd);
+  }
+
+public:
+
+  // Map length bytes of file at path, starting at offset.
+  // Length zero maps the rest of the file.
+  static std::shared_ptr<const MappedFile> open(const std::string& path,
+                                                size_t offset = 0, size_t length = 0)
+  {
+    return std::shared_ptr<const MappedFile>(new MappedFile(path, offset, length));
+  }
+
+  ~MappedFile()
+  {
+    if (map_addr != MAP_FAILED) {
+      munmap(map_addr, map_size);
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const uint8_t* data(void) const {
+    return begin;
+  }
+
+  size_t size(void) const {
+    return length;
+  }
+
+  // Called when the range [0, offset+len) of the file data has been
+  // consumed, so the pages below offset+len can be dropped from memory.
+  // They are read from the file again if they are accessed later.
+  void release(size_t offset, size_t len) const
+  {
+    uintptr_t start = reinterpret_cast<uintptr_t>(begin + offset);
+    uintptr_t end   = reinterpret_cast<uintptr_t>(begin + offset + len);
+
+    start -= start % page_size();
+    end   -= end % page_size();
+
+    if (end > start) {
+      madvise(reinterpret_cast<void*>(start), end - start, MADV_DONTNEED);
+    }
+  }
+};
+
+
+// Data that has been queued but not copied into a queue's own storage
+// yet. Either a range of a mapped file, or a buffer owned by the span.
+struct ByteSpan {
+  std::shared_ptr<const MappedFile> file;
+  std::vector<uint8_t> buf;
+
+  // Remaining data in file or buf
+  size_t offset = 0;
+  size_t size = 0;
+
+  static ByteSpan from_file(std::shared_ptr<const MappedFile> file)
+  {
+    size_t size = file->size();
+    return ByteSpan{.file = std::move(file), .size = size};
+  }
+
+  static ByteSpan from_data(std::vector<uint8_t> data)
+  {
+    size_t size = data.size();
+    return ByteSpan{.buf = std::move(data), .size = size};
+  }
+
+  const uint8_t* data(void) const {
+    return file ? file->data() + offset : buf.data() + offset;
+  }
+
+  void consume(size_t n)
+  {
+    if (file) {
+      file->release(offset, n);
+    }
+    offset += n;
+    size -= n;
+  }
+};
+
+} // namespace uvvm_cosim
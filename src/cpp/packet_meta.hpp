@@ -0,0 +1,17 @@
+#pragma once
+#include <cstdint>
+
+namespace uvvm_cosim {
+
+// AXI-Stream sideband signals for a packet. Kept once per packet next to
+// the packet data, so moving it costs nothing per byte, and packets
+// without sideband signals just carry the zero default.
+struct PacketMeta {
+  uint32_t tid = 0;
+  uint32_t tdest = 0;
+  uint32_t tuser = 0;
+
+  bool operator==(const PacketMeta&) const = default;
+};
+
+} // namespace uvvm_cosim
@@ -1,10 +1,14 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <optional>
 #include <stdexcept>
 #include <utility>
 #include <vector>
+#include "mapped_file.hpp"
+#include "packet_meta.hpp"
+#include "sim_stamp.hpp"
 
 namespace uvvm_cosim {
 
@@ -12,32 +16,108 @@ class PacketQueue {
 
   // Buffer used with put_byte until whole packet received
   std::vector<uint8_t> pkt_buff;
-  std::deque<std::deque<uint8_t>> q;
+  SimStamp pkt_buff_first;
+  PacketMeta pkt_buff_meta;
+
+  struct Packet {
+    std::deque<uint8_t> data;
+    PacketStamp stamp;
+    PacketMeta meta;
+  };
+
+  std::deque<Packet> q;
+
+  // Data put with put_pkts() is split into packets and copied into q one
+  // packet at a time as they are consumed. Packets put after a span are
+  // queued as spans as well to keep them in order.
+  struct PacketSpan {
+    ByteSpan span;
+    size_t packet_size;
+    PacketStamp stamp;
+    PacketMeta meta;
+  };
+
+  std::deque<PacketSpan> spans;
+  size_t spans_packets = 0;
+
+  // Bytes in q and spans
+  size_t num_bytes = 0;
+
+  // Largest size() and size_bytes() since the queue was created or the
+  // marks were reset
+  size_t high_water_packets = 0;
+  size_t high_water_bytes = 0;
+
+  void update_high_water(void)
+  {
+    high_water_packets = std::max(high_water_packets, size());
+    high_water_bytes = std::max(high_water_bytes, num_bytes);
+  }
+
+  void refill(void)
+  {
+    if (q.empty() && !spans.empty()) {
+      PacketSpan& s = spans.front();
+      size_t len = std::min(s.span.size, s.packet_size);
+
+      q.emplace_back(Packet{std::deque<uint8_t>(s.span.data(), s.span.data() + len),
+                            s.stamp, s.meta});
+      s.span.consume(len);
+      spans_packets--;
+
+      if (s.span.size == 0) {
+        spans.pop_front();
+      }
+    }
+  }
 
 public:
 
   bool empty(void) const {
-    return q.empty();
+    return q.empty() && spans.empty();
   }
 
   size_t size(void) const {
-    return q.size();
+    return q.size() + spans_packets;
+  }
+
+  // Number of bytes in the packets in the queue, not counting a packet
+  // that is still being put with put_byte/put_bytes
+  size_t size_bytes(void) const {
+    return num_bytes;
+  }
+
+  size_t high_water_mark(void) const {
+    return high_water_packets;
+  }
+
+  size_t high_water_mark_bytes(void) const {
+    return high_water_bytes;
+  }
+
+  // Restart the high-water marks from the current size
+  void reset_high_water_marks(void) {
+    high_water_packets = size();
+    high_water_bytes = num_bytes;
   }
 
   std::optional<std::pair<uint8_t, bool>> get_byte(void)
   {
+    refill();
+
     while (!q.empty()) {
 
-      if (q.front().empty()) {
+      if (q.front().data.empty()) {
 	throw std::runtime_error("PacketQueue::get_byte(): Empty packet in queue");
       }
 
       // Get and pop first byte from non-empty packet
-      uint8_t byte = q.front().front();
-      q.front().pop_front();
+      uint8_t byte = q.front().data.front();
+      q.front().data.pop_front();
+      num_bytes--;
 
       // Pop packet from queue if this was the last byte in packet
-      if (q.front().empty()) {
+      if (q.front().data.empty()) {
         q.pop_front();
 	return std::make_pair(byte, true);
       }
@@ -48,38 +128,154 @@ public:
     return {};
   }
 
-  std::vector<uint8_t> get_pkt(void)
+  // Get up to max_bytes from the packet at the front of the queue, but
+  // never past the end of it. eop is set if the last byte of the packet
+  // was returned. Returns an empty vector if there's no packet available.
+  std::vector<uint8_t> get_bytes(size_t max_bytes, bool& eop)
+  {
+    refill();
+
+    eop = false;
+
+    if (q.empty() || max_bytes == 0) {
+      return std::vector<uint8_t>();
+    }
+
+    std::deque<uint8_t>& pkt = q.front().data;
+    size_t len = std::min(max_bytes, pkt.size());
+
+    std::vector<uint8_t> data(pkt.begin(), pkt.begin() + len);
+    pkt.erase(pkt.begin(), pkt.begin() + len);
+    num_bytes -= len;
+
+    if (pkt.empty()) {
+      q.pop_front();
+      eop = true;
+    }
+
+    return data;
+  }
+
+  // Sideband signals of the packet at the front of the queue, which is
+  // the packet get_byte/get_bytes are reading from. Returns the zero
+  // default if there's no packet available.
+  PacketMeta get_meta(void)
+  {
+    refill();
+
+    return q.empty() ? PacketMeta{} : q.front().meta;
+  }
+
+  // If stamp or meta is given, it's set to the stamps or sideband
+  // signals of the packet
+  std::vector<uint8_t> get_pkt(PacketStamp* stamp = nullptr, PacketMeta* meta = nullptr)
   {
+    refill();
+
     if (q.empty()) {
       // Empty vector if there's no packet available
       return std::vector<uint8_t>();
     }
 
-    std::vector<uint8_t> pkt(q.front().begin(), q.front().end());
+    std::vector<uint8_t> pkt(q.front().data.begin(), q.front().data.end());
+
+    if (stamp) {
+      *stamp = q.front().stamp;
+    }
+
+    if (meta) {
+      *meta = q.front().meta;
+    }
 
     // Pop packet
     q.pop_front();
+    num_bytes -= pkt.size();
 
     return pkt;
   }
 
-  void put_byte(uint8_t byte, bool eop)
+  // Set the sideband signals for the packet being put with put_byte or
+  // put_bytes. Applies until the end of the packet.
+  void put_meta(PacketMeta meta)
   {
+    pkt_buff_meta = meta;
+  }
+
+  // Packets can be stamped with the time they were put in the queue.
+  // With put_byte, the packet gets the stamps of its first and last byte.
+  void put_byte(uint8_t byte, bool eop, SimStamp stamp = {})
+  {
+    if (pkt_buff.empty()) {
+      pkt_buff_first = stamp;
+    }
+
     pkt_buff.push_back(byte);
 
     if (eop) {
-      q.emplace_back(std::deque<uint8_t>(pkt_buff.begin(), pkt_buff.end()));
+      put_pkt(pkt_buff, PacketStamp{pkt_buff_first, stamp}, pkt_buff_meta);
+      pkt_buff.clear();
+      pkt_buff_meta = PacketMeta{};
+    }
+  }
+
+  // Same as put_byte for several bytes at a time
+  void put_bytes(const std::vector<uint8_t>& data, bool eop, SimStamp stamp = {})
+  {
+    if (pkt_buff.empty()) {
+      pkt_buff_first = stamp;
+    }
+
+    pkt_buff.insert(pkt_buff.end(), data.begin(), data.end());
+
+    if (eop) {
+      put_pkt(pkt_buff, PacketStamp{pkt_buff_first, stamp}, pkt_buff_meta);
       pkt_buff.clear();
+      pkt_buff_meta = PacketMeta{};
     }
   }
 
-  void put_pkt(const std::vector<uint8_t>& pkt)
+  void put_pkt(const std::vector<uint8_t>& pkt, SimStamp stamp = {}, PacketMeta meta = {})
+  {
+    put_pkt(pkt, PacketStamp{stamp, stamp}, meta);
+  }
+
+  void put_pkt(const std::vector<uint8_t>& pkt, PacketStamp stamp, PacketMeta meta = {})
   {
-    if (!pkt.empty()) {
-      q.emplace_back(std::deque<uint8_t>(pkt.begin(), pkt.end()));
+    if (pkt.empty()) {
+      return;
     }
+
+    num_bytes += pkt.size();
+
+    if (spans.empty()) {
+      q.emplace_back(Packet{std::deque<uint8_t>(pkt.begin(), pkt.end()), stamp, meta});
+    } else {
+      spans_packets++;
+      spans.push_back(PacketSpan{ByteSpan::from_data(pkt), pkt.size(), stamp, meta});
+    }
+
+    update_high_water();
   }
-  
+
+  // Queue the data in span as packets of packet_size bytes, where the
+  // last packet may be shorter. Packet size zero queues it as one packet.
+  void put_pkts(ByteSpan span, size_t packet_size, SimStamp stamp = {})
+  {
+    if (span.size == 0) {
+      return;
+    }
+
+    if (packet_size == 0) {
+      packet_size = span.size;
+    }
+
+    spans_packets += (span.size + packet_size - 1) / packet_size;
+    num_bytes += span.size;
+    spans.push_back(PacketSpan{std::move(span), packet_size, PacketStamp{stamp, stamp}, PacketMeta{}});
+
+    update_high_water();
+  }
+
 };
 
 
@@ -0,0 +1,266 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "receive_sink.hpp"
+
+namespace uvvm_cosim {
+
+// Bytes for byte-based VVCs are collected in pkt_buff until there's
+// this much, to avoid taking the lock for every byte
+static constexpr size_t C_RAW_CHUNK_SIZE = 4096;
+
+// How often the writer thread writes data that doesn't fill a batch
+static constexpr auto C_WRITE_INTERVAL = std::chrono::milliseconds(100);
+
+// pcapng block types and options
+static constexpr uint32_t C_PCAPNG_SHB = 0x0A0D0D0A;
+static constexpr uint32_t C_PCAPNG_IDB = 0x00000001;
+static constexpr uint32_t C_PCAPNG_EPB = 0x00000006;
+static constexpr uint32_t C_PCAPNG_BYTE_ORDER_MAGIC = 0x1A2B3C4D;
+static constexpr uint16_t C_PCAPNG_OPT_ENDOFOPT = 0;
+static constexpr uint16_t C_PCAPNG_OPT_IF_TSRESOL = 9;
+
+template <typename T>
+static void put_host(std::vector<uint8_t>& buf, T value)
+{
+  // pcapng is written in host byte order, which readers detect from
+  // the byte order magic in the section header block
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(&value);
+  buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+ReceiveSink::ReceiveSink(const std::string& path, Format format, bool packet_based,
+                         uint16_t link_type)
+  : format(format)
+  , packet_based(packet_based)
+{
+  if (format == RSF_PCAPNG && !packet_based) {
+    throw std::runtime_error("pcapng receive sink is only supported for packet-based VVCs");
+  }
+
+  fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+  if (fd < 0) {
+    throw std::runtime_error("Failed to open " + path + " for writing: " + std::strerror(errno));
+  }
+
+  if (format == RSF_PCAPNG) {
+    write_pcapng_header(link_type);
+  }
+
+  writer = std::thread(&ReceiveSink::writer_loop, this);
+}
+
+ReceiveSink::~ReceiveSink()
+{
+  close();
+}
+
+void ReceiveSink::close(void)
+{
+  std::lock_guard<std::mutex> put_lock(put_mtx);
+
+  if (closed) {
+    return;
+  }
+  closed = true;
+
+  // Partial packets are kept in raw files, but can't be written to pcapng
+  if (format == RSF_RAW && !pkt_buff.empty()) {
+    append(pkt_buff.data(), pkt_buff.size());
+    pkt_buff.clear();
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stop = true;
+  }
+  cv.notify_all();
+
+  writer.join();
+  ::close(fd);
+}
+
+auto ReceiveSink::parse_format(const std::string& format) -> Format
+{
+  if (format == "raw") {
+    return RSF_RAW;
+  } else if (format == "pcapng") {
+    return RSF_PCAPNG;
+  } else {
+    throw std::runtime_error("Unknown receive sink format " + format + ", expected raw or pcapng");
+  }
+}
+
+bool ReceiveSink::put_byte(uint8_t byte, bool eop, uint64_t sim_time_ns)
+{
+  std::lock_guard<std::mutex> put_lock(put_mtx);
+
+  if (closed) {
+    return false;
+  }
+
+  pkt_buff.push_back(byte);
+  num_bytes++;
+
+  if (packet_based ? eop : pkt_buff.size() >= C_RAW_CHUNK_SIZE) {
+    end_packet(sim_time_ns);
+  }
+
+  return true;
+}
+
+bool ReceiveSink::put(const std::vector<uint8_t>& data, bool eop, uint64_t sim_time_ns)
+{
+  std::lock_guard<std::mutex> put_lock(put_mtx);
+
+  if (closed) {
+    return false;
+  }
+
+  pkt_buff.insert(pkt_buff.end(), data.begin(), data.end());
+  num_bytes += data.size();
+
+  if (packet_based ? eop : pkt_buff.size() >= C_RAW_CHUNK_SIZE) {
+    end_packet(sim_time_ns);
+  }
+
+  return true;
+}
+
+std::string ReceiveSink::error(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return write_error;
+}
+
+void ReceiveSink::end_packet(uint64_t sim_time_ns)
+{
+  if (packet_based) {
+    num_packets++;
+  }
+
+  if (format == RSF_RAW) {
+    append(pkt_buff.data(), pkt_buff.size());
+    pkt_buff.clear();
+    return;
+  }
+
+  // Enhanced packet block, with the data padded to 32 bits
+  uint32_t pkt_len = pkt_buff.size();
+  uint32_t padding = (4 - pkt_len % 4) % 4;
+  uint32_t block_len = 32 + pkt_len + padding;
+
+  std::vector<uint8_t> epb;
+  epb.reserve(block_len);
+  put_host<uint32_t>(epb, C_PCAPNG_EPB);
+  put_host<uint32_t>(epb, block_len);
+  put_host<uint32_t>(epb, 0); // Interface ID
+  put_host<uint32_t>(epb, sim_time_ns >> 32);
+  put_host<uint32_t>(epb, sim_time_ns & 0xFFFFFFFF);
+  put_host<uint32_t>(epb, pkt_len); // Captured length
+  put_host<uint32_t>(epb, pkt_len); // Original length
+  epb.insert(epb.end(), pkt_buff.begin(), pkt_buff.end());
+  epb.insert(epb.end(), padding, 0);
+  put_host<uint32_t>(epb, block_len);
+
+  append(epb.data(), epb.size());
+  pkt_buff.clear();
+}
+
+void ReceiveSink::write_pcapng_header(uint16_t link_type)
+{
+  std::vector<uint8_t> hdr;
+
+  // Section header block
+  put_host<uint32_t>(hdr, C_PCAPNG_SHB);
+  put_host<uint32_t>(hdr, 28);
+  put_host<uint32_t>(hdr, C_PCAPNG_BYTE_ORDER_MAGIC);
+  put_host<uint16_t>(hdr, 1); // Major version
+  put_host<uint16_t>(hdr, 0); // Minor version
+  put_host<int64_t>(hdr, -1); // Section length not specified
+  put_host<uint32_t>(hdr, 28);
+
+  // Interface description block, with timestamp resolution 10^-9 s
+  put_host<uint32_t>(hdr, C_PCAPNG_IDB);
+  put_host<uint32_t>(hdr, 32);
+  put_host<uint16_t>(hdr, link_type);
+  put_host<uint16_t>(hdr, 0); // Reserved
+  put_host<uint32_t>(hdr, 0); // No snap length limit
+  put_host<uint16_t>(hdr, C_PCAPNG_OPT_IF_TSRESOL);
+  put_host<uint16_t>(hdr, 1);
+  hdr.insert(hdr.end(), {9, 0, 0, 0});
+  put_host<uint16_t>(hdr, C_PCAPNG_OPT_ENDOFOPT);
+  put_host<uint16_t>(hdr, 0);
+  put_host<uint32_t>(hdr, 32);
+
+  append(hdr.data(), hdr.size());
+}
+
+void ReceiveSink::append(const uint8_t* data, size_t size)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  cv.wait(lock, [&]() { return fill_buff.size() < C_MAX_BUFFERED; });
+
+  fill_buff.insert(fill_buff.end(), data, data + size);
+
+  if (fill_buff.size() >= C_WRITE_BATCH_SIZE) {
+    cv.notify_all();
+  }
+}
+
+void ReceiveSink::writer_loop(void)
+{
+  std::vector<uint8_t> write_buff;
+  std::unique_lock<std::mutex> lock(mtx);
+
+  while (true) {
+    cv.wait_for(lock, C_WRITE_INTERVAL, [&]() {
+      return stop || fill_buff.size() >= C_WRITE_BATCH_SIZE;
+    });
+
+    if (fill_buff.empty()) {
+      if (stop) {
+        break;
+      }
+      continue;
+    }
+
+    // Take the filled buffer and write it without holding the lock,
+    // waking up the simulator thread if it was waiting for space
+    write_buff.swap(fill_buff);
+    cv.notify_all();
+    lock.unlock();
+
+    const uint8_t* p = write_buff.data();
+    size_t remaining = write_buff.size();
+    std::string err;
+
+    while (remaining > 0 && err.empty()) {
+      ssize_t n = ::write(fd, p, remaining);
+
+      if (n < 0 && errno != EINTR) {
+        err = std::strerror(errno);
+      } else if (n > 0) {
+        p += n;
+        remaining -= n;
+      }
+    }
+
+    write_buff.clear();
+    lock.lock();
+
+    // Data is discarded after an error, so the simulator doesn't block
+    if (!err.empty() && write_error.empty()) {
+      write_error = "Write to receive sink failed: " + err;
+    }
+  }
+}
+
+} // namespace uvvm_cosim
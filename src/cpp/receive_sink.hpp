@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace uvvm_cosim {
+
+// Link type written to the pcapng interface description block
+constexpr uint16_t C_LINKTYPE_ETHERNET = 1;
+
+// Writes data received by a VVC directly to a file, instead of queueing
+// it up for a client.
+//
+// RSF_RAW:    The received bytes are written as they are.
+// RSF_PCAPNG: Each packet is written as an enhanced packet block with the
+//             simulation time (in ns) it was received at as timestamp.
+//             Only for packet-based VVCs.
+//
+// Data is put by the simulator thread into a buffer, which is written
+// to the file in large batches by a background thread. The simulator
+// thread blocks if the writer falls too far behind.
+class ReceiveSink {
+public:
+  enum Format { RSF_RAW, RSF_PCAPNG };
+
+  ReceiveSink(const std::string& path, Format format, bool packet_based,
+              uint16_t link_type = C_LINKTYPE_ETHERNET);
+
+  ~ReceiveSink();
+
+  ReceiveSink(const ReceiveSink&) = delete;
+  ReceiveSink& operator=(const ReceiveSink&) = delete;
+
+  static Format parse_format(const std::string& format);
+
+  // Write remaining data and close the file. No data can be put after
+  // this. Called by the destructor if it hasn't been called already.
+  void close(void);
+
+  // eop is ignored for VVCs that are not packet-based. Returns false,
+  // without taking the data, if the sink has been closed.
+  bool put_byte(uint8_t byte, bool eop, uint64_t sim_time_ns);
+
+  bool put(const std::vector<uint8_t>& data, bool eop, uint64_t sim_time_ns);
+
+  uint64_t bytes(void) const {
+    return num_bytes;
+  }
+
+  uint64_t packets(void) const {
+    return num_packets;
+  }
+
+  // Error message if writing to the file failed, empty otherwise
+  std::string error(void);
+
+private:
+  // Batch size for writes, and max amount of data buffered before the
+  // simulator thread has to wait for the writer
+  static constexpr size_t C_WRITE_BATCH_SIZE = 256 * 1024;
+  static constexpr size_t C_MAX_BUFFERED = 64 * 1024 * 1024;
+
+  int fd;
+  Format format;
+  bool packet_based;
+
+  // Serializes put against close, which may be called from another
+  // thread while the simulator thread is still holding the sink
+  std::mutex put_mtx;
+  bool closed = false;
+  std::vector<uint8_t> pkt_buff;
+
+  std::atomic<uint64_t> num_bytes = 0;
+  std::atomic<uint64_t> num_packets = 0;
+
+  // Shared with the writer thread
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::vector<uint8_t> fill_buff;
+  bool stop = false;
+  std::string write_error;
+
+  std::thread writer;
+
+  void append(const uint8_t* data, size_t size);
+
+  void end_packet(uint64_t sim_time_ns);
+
+  void write_pcapng_header(uint16_t link_type);
+
+  void writer_loop(void);
+};
+
+} // namespace uvvm_cosim
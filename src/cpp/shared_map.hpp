@@ -1,6 +1,9 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <mutex>
-#include <map>
+#include <type_traits>
 
 // Based on this StackOverflow answer to the question
 // "What's the proper way to associate a mutex with its data?"
@@ -9,14 +12,60 @@
 // Trimmed away most of it, leaving only operator() so we can
 // execute a function that works on the vector, but waiting for
 // a lock so two threads won't access the vector simultaneously.
+//
+// wait_for() and notify_all() were added so a thread can block until
+// another thread has changed the map in a way it is interested in.
+// notify_all() is called for every change to the queues, including from
+// the simulator thread, so it skips the condition variable when nobody
+// is waiting.
+//
+// The mutex type can be replaced, e.g. with one that keeps statistics.
+// Mutexes other than std::mutex are waited on with
+// std::condition_variable_any.
+
+// M: Map type
+// Mutex: Mutex type, must be BasicLockable
+template <typename M, typename Mutex = std::mutex> class shared_map {
+  using CondVar = std::conditional_t<std::is_same_v<Mutex, std::mutex>,
+                                     std::condition_variable,
+                                     std::condition_variable_any>;
 
-// K: Key, V: Value, C: Comparator clas
-template <typename K, typename V, typename C> class shared_map {
-  mutable std::mutex mtx;
-  mutable std::map<K, V, C> mp;
+  mutable Mutex mtx;
+  mutable CondVar cv;
+  mutable std::atomic<int> waiters = 0;
+  mutable M mp;
+
+  // Counts a waiting thread for as long as it exists, also when f throws
+  struct Waiter {
+    std::atomic<int>& n;
+    Waiter(std::atomic<int>& n) : n(n) { n++; }
+    ~Waiter() { n--; }
+  };
 
 public:
   template <typename F> auto operator()(F f) const -> decltype(f(mp)) {
-    return std::lock_guard<std::mutex>(mtx), f(mp);
+    return std::lock_guard<Mutex>(mtx), f(mp);
+  }
+
+  // Evaluate f with the lock held until it returns true, re-evaluating
+  // it each time notify_all() is called. Returns false on timeout.
+  template <typename Rep, typename Period, typename F>
+  bool wait_for(const std::chrono::duration<Rep, Period>& timeout, F f) const {
+    std::unique_lock<Mutex> lock(mtx);
+    Waiter waiter(waiters);
+    return cv.wait_for(lock, timeout, [&]() { return f(mp); });
+  }
+
+  // A waiter registers itself before it releases the lock to wait, so
+  // a change made under the lock is always followed by a notification
+  // it sees
+  void notify_all() const {
+    if (waiters > 0) {
+      cv.notify_all();
+    }
+  }
+
+  Mutex& mutex() const {
+    return mtx;
   }
 };
@@ -0,0 +1,132 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace uvvm_cosim {
+
+// Keeps track of how far the simulation has progressed, and implements
+// lockstep mode where the simulator only advances as far as it has been
+// granted by run_for().
+//
+// The simulator calls cycle() once per cycle of the cosim clock, with the
+// current time and the number of cycles counted so far. In
+// lockstep mode, cycle() blocks once the granted time or number of cycles
+// has been reached, until run_for() grants more. Since the simulator is
+// stopped while the client works between calls to run_for(), data the
+// client transmits and receives is applied at the quantum boundaries,
+// which makes the run independent of host load.
+class SimControl {
+public:
+  enum Unit { SCU_NS, SCU_CYCLES };
+
+  struct Progress {
+    uint64_t sim_time_ns = 0;
+    uint64_t cycles = 0;
+  };
+
+  static Unit parse_unit(const std::string& unit)
+  {
+    if (unit == "ns") {
+      return SCU_NS;
+    } else if (unit == "cycles") {
+      return SCU_CYCLES;
+    } else {
+      throw std::runtime_error("Unknown unit " + unit + ", expected ns or cycles");
+    }
+  }
+
+  void set_lockstep(bool enable)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      lockstep = enable;
+    }
+    cv.notify_all();
+  }
+
+  bool get_lockstep(void) const
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return lockstep;
+  }
+
+  // Called from the simulator for every cycle of the cosim clock
+  void cycle(uint64_t sim_time_ns, uint64_t cycles)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    progress.sim_time_ns = sim_time_ns;
+    progress.cycles = cycles;
+
+    if (lockstep && target_reached()) {
+      // Let run_for() return, and wait for the next quantum
+      stopped = true;
+      cv.notify_all();
+      cv.wait(lock, [&]() { return !lockstep || terminated || !target_reached(); });
+      stopped = false;
+    }
+  }
+
+  // Grant the simulator amount ns or cycles beyond the point it has
+  // reached, and wait until it gets there. The simulator stops at the
+  // first cycle at or after the target. Returns false if the simulation
+  // was terminated or lockstep mode was disabled before that.
+  bool run_for(uint64_t amount, Unit unit, Progress& reached)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    target_unit = unit;
+    target = (unit == SCU_NS ? progress.sim_time_ns : progress.cycles) + amount;
+    cv.notify_all();
+
+    cv.wait(lock, [&]() { return !lockstep || terminated || (stopped && target_reached()); });
+
+    reached = progress;
+    return lockstep && !terminated;
+  }
+
+  Progress get_progress(void) const
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return progress;
+  }
+
+  // Wake up the simulator and any client waiting in run_for()
+  void terminate(void)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      terminated = true;
+    }
+    cv.notify_all();
+  }
+
+private:
+  mutable std::mutex mtx;
+  std::condition_variable cv;
+
+  bool lockstep = false;
+  bool terminated = false;
+
+  // Set while the simulator is waiting in cycle(), so run_for() doesn't
+  // return before the simulator has actually stopped
+  bool stopped = false;
+
+  Progress progress;
+
+  // Target for current quantum. Starts at zero, so in lockstep mode the
+  // simulator stops at the first cycle until run_for() is called.
+  Unit target_unit = SCU_CYCLES;
+  uint64_t target = 0;
+
+  bool target_reached(void) const
+  {
+    return (target_unit == SCU_NS ? progress.sim_time_ns : progress.cycles) >= target;
+  }
+};
+
+} // namespace uvvm_cosim
@@ -0,0 +1,135 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace uvvm_cosim {
+
+// Keeps a history of simulation progress against wall time, for
+// reporting how fast the simulation runs over sliding windows.
+//
+// The simulator calls cycle() for every cycle of the cosim clock. A sample
+// is stored in a ring buffer at most once per interval, so the cost per
+// cycle is a clock read and a compare, and the mutex is only taken when a
+// sample is stored or a report is made.
+class SimProgress {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  struct Sample {
+    Clock::time_point wall;
+    uint64_t sim_time_ns = 0;
+    uint64_t cycles = 0;
+  };
+
+  struct Rate {
+    double window_s;
+    double cycles_per_s;
+    double sim_ns_per_s;
+  };
+
+  struct Report {
+    uint64_t sim_time_ns = 0;
+    uint64_t cycles = 0;
+    double wall_time_s = 0.0;
+    std::vector<Rate> rates;
+  };
+
+  // The default interval and capacity keep a bit more than a minute
+  SimProgress(std::chrono::milliseconds interval = std::chrono::milliseconds(100),
+              size_t capacity = 1024)
+    : interval(interval)
+    , samples(capacity)
+  {
+  }
+
+  void cycle(uint64_t sim_time_ns, uint64_t cycles, Clock::time_point now = Clock::now())
+  {
+    if (count > 0 && now < next_sample) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if (count == 0) {
+      start = now;
+    }
+
+    samples[head] = Sample{now, sim_time_ns, cycles};
+    head = (head + 1) % samples.size();
+    if (count < samples.size()) {
+      count++;
+    }
+
+    next_sample = now + interval;
+  }
+
+  // Report progress up to current, with rates over each of the windows
+  // (in seconds). The rate for a window is measured from the newest sample
+  // that is at least that old, or from the oldest sample if the history
+  // is shorter than the window.
+  Report report(const Sample& current, const std::vector<double>& windows) const
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    Report r;
+    r.sim_time_ns = current.sim_time_ns;
+    r.cycles = current.cycles;
+
+    if (count == 0) {
+      for (double window : windows) {
+        r.rates.push_back(Rate{window, 0.0, 0.0});
+      }
+      return r;
+    }
+
+    r.wall_time_s = seconds(current.wall - start);
+
+    for (double window : windows) {
+      auto limit = current.wall - std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(window));
+
+      // Search backwards from the newest sample
+      const Sample* from = nullptr;
+      for (size_t i = 1; i <= count; i++) {
+        from = &samples[(head + samples.size() - i) % samples.size()];
+        if (from->wall <= limit) {
+          break;
+        }
+      }
+
+      Rate rate{window, 0.0, 0.0};
+      double elapsed = seconds(current.wall - from->wall);
+
+      if (elapsed > 0.0) {
+        rate.cycles_per_s = (current.cycles - from->cycles) / elapsed;
+        rate.sim_ns_per_s = (current.sim_time_ns - from->sim_time_ns) / elapsed;
+      }
+
+      r.rates.push_back(rate);
+    }
+
+    return r;
+  }
+
+private:
+  mutable std::mutex mtx;
+
+  const Clock::duration interval;
+
+  // Only accessed from the simulator thread
+  Clock::time_point next_sample;
+
+  std::vector<Sample> samples;
+  size_t head = 0;
+  size_t count = 0;
+  Clock::time_point start;
+
+  static double seconds(Clock::duration d)
+  {
+    return std::chrono::duration<double>(d).count();
+  }
+};
+
+} // namespace uvvm_cosim
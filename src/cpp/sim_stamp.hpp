@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace uvvm_cosim {
+
+// Simulation time and cosim clock cycle at which data was put in a queue
+struct SimStamp {
+  uint64_t sim_time_ns = 0;
+  uint64_t cycle = 0;
+
+  bool operator==(const SimStamp&) const = default;
+};
+
+// Stamp for count consecutive bytes in a byte queue. Bytes put in the
+// same cycle share a run, so a burst of bytes costs a single stamp.
+struct SimStampRun {
+  size_t count;
+  SimStamp stamp;
+};
+
+// Stamps for the first and last byte of a packet
+struct PacketStamp {
+  SimStamp first;
+  SimStamp last;
+};
+
+} // namespace uvvm_cosim
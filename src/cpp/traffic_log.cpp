@@ -0,0 +1,447 @@
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "traffic_log.hpp"
+
+namespace uvvm_cosim {
+
+static constexpr size_t C_TRAFFIC_LOG_ALIGN = 8;
+static constexpr size_t C_TRAFFIC_LOG_MAX_RECORD = 1 << 20;
+
+static size_t padded_size(size_t size)
+{
+  return (size + C_TRAFFIC_LOG_ALIGN - 1) & ~(C_TRAFFIC_LOG_ALIGN - 1);
+}
+
+static uint64_t wall_time_ns(void)
+{
+  using namespace std::chrono;
+  return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+// ----------------------------------------------------------------------------
+// TrafficLogWriter
+// ----------------------------------------------------------------------------
+
+TrafficLogWriter::TrafficLogWriter(const std::string& path)
+{
+  file = std::fopen(path.c_str(), "wb");
+
+  if (file == nullptr) {
+    throw std::runtime_error("Failed to open traffic log " + path + " for writing: " + std::strerror(errno));
+  }
+
+  // Large stdio buffer so the log is written in big chunks
+  std::setvbuf(file, nullptr, _IOFBF, 1 << 20);
+
+  TrafficLogFileHeader hdr = {.version = C_TRAFFIC_LOG_VERSION};
+  std::memcpy(hdr.magic, C_TRAFFIC_LOG_MAGIC, sizeof(hdr.magic));
+  write_raw(&hdr, sizeof(hdr));
+}
+
+TrafficLogWriter::~TrafficLogWriter()
+{
+  close();
+}
+
+void TrafficLogWriter::close(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (file == nullptr) {
+    return;
+  }
+
+  flush_pending();
+
+  if (std::fclose(file) != 0) {
+    set_error(std::strerror(errno));
+  }
+
+  file = nullptr;
+}
+
+std::string TrafficLogWriter::error(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+  return write_error;
+}
+
+void TrafficLogWriter::set_error(const std::string& what)
+{
+  if (write_error.empty()) {
+    write_error = "Write to traffic log failed: " + what;
+  }
+}
+
+void TrafficLogWriter::write_raw(const void* data, size_t size)
+{
+  if (write_error.empty() && std::fwrite(data, 1, size, file) != size) {
+    set_error(std::strerror(errno));
+  }
+}
+
+uint32_t TrafficLogWriter::get_vvc_handle(const VvcInstanceKey& vvc)
+{
+  if (auto it = vvc_handles.find(vvc); it != vvc_handles.end()) {
+    return it->second;
+  }
+
+  uint32_t handle = vvc_handles.size();
+  vvc_handles.emplace(vvc, handle);
+
+  // Payload: Instance ID followed by null terminated type and channel strings
+  std::vector<uint8_t> payload(sizeof(int32_t));
+  int32_t instance_id = vvc.vvc_instance_id;
+  std::memcpy(payload.data(), &instance_id, sizeof(instance_id));
+  payload.insert(payload.end(), vvc.vvc_type.begin(), vvc.vvc_type.end());
+  payload.push_back(0);
+  payload.insert(payload.end(), vvc.vvc_channel.begin(), vvc.vvc_channel.end());
+  payload.push_back(0);
+
+  TrafficLogRecordHeader hdr = {
+    .payload_size = static_cast<uint32_t>(payload.size()),
+    .type         = TLR_VVC,
+    .vvc_handle   = handle,
+    .wall_time_ns = wall_time_ns()
+  };
+
+  write_record(hdr, payload.data());
+
+  return handle;
+}
+
+void TrafficLogWriter::write_record(const TrafficLogRecordHeader& hdr, const uint8_t* payload)
+{
+  static const uint8_t padding[C_TRAFFIC_LOG_ALIGN] = {0};
+
+  write_raw(&hdr, sizeof(hdr));
+  write_raw(payload, hdr.payload_size);
+  write_raw(padding, padded_size(hdr.payload_size) - hdr.payload_size);
+}
+
+void TrafficLogWriter::flush_pending(void)
+{
+  if (!pending_data.empty()) {
+    pending_hdr.payload_size = pending_data.size();
+    write_record(pending_hdr, pending_data.data());
+    pending_data.clear();
+  }
+}
+
+void TrafficLogWriter::write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+                             const std::vector<uint8_t>& data, uint8_t flags)
+{
+  write(qid, vvc, sim_time_ns, data.data(), data.size(), flags);
+}
+
+void TrafficLogWriter::write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+                             const uint8_t* data, size_t size, uint8_t flags)
+{
+  if (size == 0) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (file == nullptr || !write_error.empty()) {
+    return;
+  }
+
+  uint32_t handle = get_vvc_handle(vvc);
+
+  bool append = !pending_data.empty() &&
+                pending_hdr.vvc_handle == handle &&
+                pending_hdr.direction == qid &&
+                pending_hdr.sim_time_ns == sim_time_ns &&
+                (pending_hdr.flags & TLF_EOP) == 0 &&
+                (pending_hdr.flags & TLF_PACKET) == (flags & TLF_PACKET);
+
+  if (!append) {
+    flush_pending();
+
+    pending_hdr = TrafficLogRecordHeader{
+      .type         = TLR_DATA,
+      .direction    = static_cast<uint8_t>(qid),
+      .flags        = static_cast<uint8_t>(flags & TLF_PACKET),
+      .vvc_handle   = handle,
+      .sim_time_ns  = sim_time_ns,
+      .wall_time_ns = wall_time_ns()
+    };
+  }
+
+  // Split large writes into records of at most C_TRAFFIC_LOG_MAX_RECORD
+  // bytes. Packets continue in the next record until TLF_EOP is set.
+  while (pending_data.size() + size > C_TRAFFIC_LOG_MAX_RECORD) {
+    size_t len = C_TRAFFIC_LOG_MAX_RECORD - pending_data.size();
+    pending_data.insert(pending_data.end(), data, data + len);
+    data += len;
+    size -= len;
+    flush_pending();
+    pending_hdr.wall_time_ns = wall_time_ns();
+  }
+
+  pending_data.insert(pending_data.end(), data, data + size);
+
+  if (flags & TLF_EOP) {
+    pending_hdr.flags |= TLF_EOP;
+    flush_pending();
+  }
+}
+
+void TrafficLogWriter::write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+                             uint8_t byte, uint8_t flags)
+{
+  write(qid, vvc, sim_time_ns, std::vector<uint8_t>{byte}, flags);
+}
+
+void TrafficLogWriter::flush(void)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if (file == nullptr) {
+    return;
+  }
+
+  flush_pending();
+
+  if (std::fflush(file) != 0) {
+    set_error(std::strerror(errno));
+  }
+}
+
+// ----------------------------------------------------------------------------
+// TrafficLogReader
+// ----------------------------------------------------------------------------
+
+TrafficLogReader::TrafficLogReader(const std::string& path)
+  : file(MappedFile::open(path))
+  , base(file->data())
+  , size(file->size())
+{
+  if (size < sizeof(TrafficLogFileHeader)) {
+    throw std::runtime_error("Traffic log " + path + " is too small to be valid");
+  }
+
+  auto hdr = reinterpret_cast<const TrafficLogFileHeader*>(base);
+
+  if (std::memcmp(hdr->magic, C_TRAFFIC_LOG_MAGIC, sizeof(hdr->magic)) != 0 ||
+      hdr->version != C_TRAFFIC_LOG_VERSION) {
+    throw std::runtime_error("Traffic log " + path + " has unknown format or version");
+  }
+
+  pos = sizeof(TrafficLogFileHeader);
+}
+
+std::optional<TrafficLogRecord> TrafficLogReader::next(void)
+{
+  while (size - pos >= sizeof(TrafficLogRecordHeader)) {
+    auto hdr = reinterpret_cast<const TrafficLogRecordHeader*>(base + pos);
+    const uint8_t* payload = base + pos + sizeof(TrafficLogRecordHeader);
+
+    if (size - pos - sizeof(TrafficLogRecordHeader) < hdr->payload_size) {
+      // Truncated record, e.g. from a simulation that crashed
+      break;
+    }
+
+    pos += sizeof(TrafficLogRecordHeader) + padded_size(hdr->payload_size);
+
+    if (hdr->type == TLR_DATA) {
+      return TrafficLogRecord{.hdr = hdr, .payload = payload};
+    }
+
+    if (hdr->type == TLR_VVC && hdr->payload_size > sizeof(int32_t)) {
+      int32_t instance_id;
+      std::memcpy(&instance_id, payload, sizeof(instance_id));
+
+      // strnlen in case the strings are not terminated in a corrupt log
+      auto str = reinterpret_cast<const char*>(payload + sizeof(int32_t));
+      size_t max_len = hdr->payload_size - sizeof(int32_t);
+      size_t type_len = strnlen(str, max_len);
+      size_t channel_len = type_len < max_len ? strnlen(str + type_len + 1, max_len - type_len - 1) : 0;
+
+      vvcs[hdr->vvc_handle] = VvcInstanceKey{
+        .vvc_type = std::string(str, type_len),
+        .vvc_channel = std::string(str + type_len + 1, channel_len),
+        .vvc_instance_id = instance_id
+      };
+    }
+  }
+
+  return {};
+}
+
+const VvcInstanceKey& TrafficLogReader::vvc(uint32_t handle) const
+{
+  if (auto it = vvcs.find(handle); it != vvcs.end()) {
+    return it->second;
+  }
+
+  throw std::runtime_error("Traffic log has no VVC with handle " + std::to_string(handle));
+}
+
+// ----------------------------------------------------------------------------
+// TrafficReplay
+// ----------------------------------------------------------------------------
+
+TrafficReplay::TrafficReplay(const std::string& path, UvvmCosimData& cosim_data, uint64_t timeout_ns)
+  : reader(path)
+  , cosimData(cosim_data)
+  , timeout_ns(timeout_ns)
+{
+  while (auto rec = reader.next()) {
+    if (rec->hdr->direction == QID_TRANSMIT) {
+      transmit_records.push_back(rec.value());
+    } else {
+      expected[reader.vvc(rec->hdr->vvc_handle)].records.push_back(rec.value());
+    }
+
+    end_time_ns = std::max<uint64_t>(end_time_ns, rec->hdr->sim_time_ns);
+  }
+}
+
+void TrafficReplay::mismatch(const std::string& msg)
+{
+  // Don't flood the output if the streams got out of sync
+  constexpr size_t C_MAX_REPORTED = 10;
+
+  if (mismatches < C_MAX_REPORTED) {
+    std::cerr << "Replay mismatch: " << msg << std::endl;
+  }
+
+  mismatches++;
+}
+
+bool TrafficReplay::tick(uint64_t sim_time_ns)
+{
+  if (!started) {
+    // VVCs have been registered by the time the simulation starts
+    // running, so listening can be enabled for the receiving VVCs now
+    started = true;
+
+    for (auto &[vvc, stream] : expected) {
+      try {
+        cosimData.SetVvcListenEnable(vvc, true);
+      }
+      catch (const std::runtime_error& e) {
+        mismatch(e.what());
+      }
+    }
+  }
+
+  while (transmit_idx < transmit_records.size() &&
+         transmit_records[transmit_idx].hdr->sim_time_ns <= sim_time_ns) {
+    const TrafficLogRecord& rec = transmit_records[transmit_idx++];
+    const VvcInstanceKey& vvc = reader.vvc(rec.hdr->vvc_handle);
+    std::vector<uint8_t> data(rec.payload, rec.payload + rec.hdr->payload_size);
+
+    try {
+      if (rec.hdr->flags & TLF_PACKET) {
+        auto& pkt = transmit_pkt_buff[rec.hdr->vvc_handle];
+        pkt.insert(pkt.end(), data.begin(), data.end());
+
+        if (rec.hdr->flags & TLF_EOP) {
+          cosimData.packet_queue_put_pkt(QID_TRANSMIT, vvc, pkt);
+          pkt.clear();
+        }
+      } else {
+        cosimData.byte_queue_put(QID_TRANSMIT, vvc, data);
+      }
+      transmitted_bytes += data.size();
+    }
+    catch (const std::runtime_error& e) {
+      mismatch(e.what());
+    }
+  }
+
+  if (sim_time_ns > end_time_ns + timeout_ns) {
+    return true;
+  }
+
+  if (transmit_idx < transmit_records.size()) {
+    return false;
+  }
+
+  for (auto &[vvc, stream] : expected) {
+    if (!stream.records.empty()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void TrafficReplay::receive(const VvcInstanceKey& vvc, uint8_t byte, bool eop, bool packet_based)
+{
+  received_bytes++;
+
+  auto it = expected.find(vvc);
+
+  if (it == expected.end() || it->second.records.empty()) {
+    mismatch("Unexpected data received on VVC " + to_string(vvc));
+    return;
+  }
+
+  ExpectedStream& stream = it->second;
+  const TrafficLogRecord& rec = stream.records.front();
+  uint8_t expected_byte = rec.payload[stream.offset];
+  bool last_in_record = stream.offset + 1 == rec.hdr->payload_size;
+  bool expected_eop = packet_based && last_in_record && (rec.hdr->flags & TLF_EOP);
+
+  if (byte != expected_byte) {
+    mismatch("VVC " + to_string(vvc) + ": Received byte " + std::to_string(byte) +
+             ", expected " + std::to_string(expected_byte) +
+             " (recorded at " + std::to_string(rec.hdr->sim_time_ns) + " ns)");
+  } else if (eop != expected_eop) {
+    mismatch("VVC " + to_string(vvc) + ": End of packet " + (eop ? "received" : "missing") +
+             " (recorded at " + std::to_string(rec.hdr->sim_time_ns) + " ns)");
+  }
+
+  if (last_in_record) {
+    stream.records.pop_front();
+    stream.offset = 0;
+  } else {
+    stream.offset++;
+  }
+}
+
+bool TrafficReplay::passed(void) const
+{
+  if (mismatches > 0 || transmit_idx < transmit_records.size()) {
+    return false;
+  }
+
+  for (auto &[vvc, stream] : expected) {
+    if (!stream.records.empty()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::string TrafficReplay::summary(void) const
+{
+  size_t missing_bytes = 0;
+
+  for (auto &[vvc, stream] : expected) {
+    for (auto &rec : stream.records) {
+      missing_bytes += rec.hdr->payload_size;
+    }
+    if (!stream.records.empty()) {
+      missing_bytes -= stream.offset;
+    }
+  }
+
+  return std::string(passed() ? "Replay PASSED: " : "Replay FAILED: ") +
+         "transmitted " + std::to_string(transmitted_bytes) + " bytes, " +
+         "received " + std::to_string(received_bytes) + " bytes, " +
+         std::to_string(mismatches) + " mismatches, " +
+         std::to_string(missing_bytes) + " bytes not received.";
+}
+
+} // namespace uvvm_cosim
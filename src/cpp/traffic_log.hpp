@@ -0,0 +1,187 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "mapped_file.hpp"
+#include "uvvm_cosim_data.hpp"
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Binary log of cosim traffic.
+//
+// The file starts with a TrafficLogFileHeader, followed by records that
+// each consist of a TrafficLogRecordHeader and a payload padded to a
+// multiple of 8 bytes. Fields are stored in host byte order and are
+// naturally aligned, so the log can be memory mapped and read in place.
+//
+// A TLR_VVC record is written the first time a VVC appears in the log.
+// It maps a handle to the VVC's type, channel and instance ID, and the
+// TLR_DATA records that follow only refer to the VVC by its handle.
+
+constexpr char C_TRAFFIC_LOG_MAGIC[8] = {'U', 'V', 'C', 'O', 'S', 'L', 'O', 'G'};
+constexpr uint32_t C_TRAFFIC_LOG_VERSION = 1;
+
+enum TrafficLogRecordType : uint8_t { TLR_VVC, TLR_DATA };
+
+// Flags for TLR_DATA records
+enum TrafficLogFlags : uint8_t {
+  TLF_PACKET = 0x01, // Data for packet-based VVC
+  TLF_EOP    = 0x02  // Last byte in record is end of packet
+};
+
+struct TrafficLogFileHeader {
+  char     magic[8];
+  uint32_t version;
+  uint32_t reserved;
+};
+
+struct TrafficLogRecordHeader {
+  uint32_t payload_size;
+  uint8_t  type;       // TrafficLogRecordType
+  uint8_t  direction;  // QueueId
+  uint8_t  flags;      // TrafficLogFlags
+  uint8_t  reserved;
+  uint32_t vvc_handle;
+  uint32_t reserved2;
+  uint64_t sim_time_ns;
+  uint64_t wall_time_ns;
+};
+
+static_assert(sizeof(TrafficLogFileHeader) == 16);
+static_assert(sizeof(TrafficLogRecordHeader) == 32);
+
+// Points into the memory mapped log
+struct TrafficLogRecord {
+  const TrafficLogRecordHeader* hdr;
+  const uint8_t* payload;
+};
+
+
+class TrafficLogWriter {
+  std::mutex mtx;
+  std::FILE* file;
+
+  std::map<VvcInstanceKey, uint32_t, VvcCompare> vvc_handles;
+
+  // Consecutive writes for the same VVC, direction and sim time are
+  // coalesced into one record, so data received a byte at a time via
+  // the foreign calls doesn't get a record header per byte.
+  TrafficLogRecordHeader pending_hdr;
+  std::vector<uint8_t> pending_data;
+
+  // First write error. Data is discarded after an error.
+  std::string write_error;
+
+  uint32_t get_vvc_handle(const VvcInstanceKey& vvc);
+
+  // Records the error if write_error isn't set already
+  void set_error(const std::string& what);
+
+  void write_raw(const void* data, size_t size);
+
+  void write_record(const TrafficLogRecordHeader& hdr, const uint8_t* payload);
+
+  void flush_pending(void);
+
+public:
+  explicit TrafficLogWriter(const std::string& path);
+
+  ~TrafficLogWriter();
+
+  TrafficLogWriter(const TrafficLogWriter&) = delete;
+  TrafficLogWriter& operator=(const TrafficLogWriter&) = delete;
+
+  void write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+             const std::vector<uint8_t>& data, uint8_t flags);
+
+  void write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+             const uint8_t* data, size_t size, uint8_t flags);
+
+  void write(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+             uint8_t byte, uint8_t flags);
+
+  void flush(void);
+
+  // Write remaining data and close the file. No data is written after
+  // this. Called by the destructor if it hasn't been called already.
+  void close(void);
+
+  // Error message if writing to the file failed, empty otherwise
+  std::string error(void);
+};
+
+
+class TrafficLogReader {
+  std::shared_ptr<const MappedFile> file;
+  const uint8_t* base;
+  size_t size;
+  size_t pos = 0;
+
+  std::map<uint32_t, VvcInstanceKey> vvcs;
+
+public:
+  explicit TrafficLogReader(const std::string& path);
+
+  // Get next data record. TLR_VVC records are handled internally.
+  std::optional<TrafficLogRecord> next(void);
+
+  // Look up VVC for a handle used in the data records read so far
+  const VvcInstanceKey& vvc(uint32_t handle) const;
+};
+
+
+// Replays the transmit data in a traffic log into the transmit queues
+// at the sim times they were recorded at, and checks the data received
+// by the VVCs against the receive data in the log.
+// All methods are called from the simulator thread.
+class TrafficReplay {
+  TrafficLogReader reader;
+  UvvmCosimData& cosimData;
+
+  std::vector<TrafficLogRecord> transmit_records;
+  size_t transmit_idx = 0;
+
+  // Transmit data for packets that continue in a later record
+  std::map<uint32_t, std::vector<uint8_t>> transmit_pkt_buff;
+
+  struct ExpectedStream {
+    std::deque<TrafficLogRecord> records;
+    size_t offset = 0; // In front record
+  };
+
+  std::map<VvcInstanceKey, ExpectedStream, VvcCompare> expected;
+
+  uint64_t end_time_ns = 0;
+  uint64_t timeout_ns;
+  bool started = false;
+
+  size_t transmitted_bytes = 0;
+  size_t received_bytes = 0;
+  size_t mismatches = 0;
+
+  void mismatch(const std::string& msg);
+
+public:
+  TrafficReplay(const std::string& path, UvvmCosimData& cosim_data, uint64_t timeout_ns);
+
+  // Feed transmit data recorded up to sim_time_ns. Returns true when the
+  // replay is done, which is when all transmit data has been fed and all
+  // receive data has been checked, or when timeout_ns has passed since
+  // the last event in the log.
+  bool tick(uint64_t sim_time_ns);
+
+  void receive(const VvcInstanceKey& vvc, uint8_t byte, bool eop, bool packet_based);
+
+  bool passed(void) const;
+
+  std::string summary(void) const;
+};
+
+} // namespace uvvm_cosim
@@ -0,0 +1,329 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <jsonrpccxx/common.hpp>
+#include <jsonrpccxx/iclientconnector.hpp>
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Client that keeps several requests in flight, for test harnesses that
+// want to overlap transmits to several VVCs with receive polling.
+//
+// Each connection has its own worker thread and request queue. A call
+// returns immediately with a future (or calls a callback when the
+// response arrives), and responses are matched to requests by their id.
+//
+// Requests for the same VVC are always sent on the same connection, so
+// they are executed by the server in the order they were made. Requests
+// for different VVCs, and requests that aren't for a VVC, may overlap.
+// Note that a blocking call such as WaitForPattern holds up the other
+// VVCs that share its connection.
+//
+// All methods can be called from any thread.
+class UvvmCosimAsyncClient {
+public:
+  using ConnectorFactory = std::function<std::unique_ptr<jsonrpccxx::IClientConnector>()>;
+
+  // Called from a worker thread with the response, and must not throw.
+  // Transport and protocol errors are passed as an unsuccessful response
+  // with an error message.
+  using Callback = std::function<void(JsonResponse)>;
+
+  UvvmCosimAsyncClient(const ConnectorFactory& make_connector, int num_connections = 4)
+  {
+    if (num_connections < 1) {
+      throw std::runtime_error("UvvmCosimAsyncClient needs at least one connection");
+    }
+
+    for (int i = 0; i < num_connections; i++) {
+      connections.push_back(std::make_unique<Connection>(make_connector()));
+    }
+
+    for (auto& conn : connections) {
+      conn->thread = std::thread([&conn = *conn]() { conn.run(); });
+    }
+  }
+
+  // Waits for all requests that have been made to complete
+  ~UvvmCosimAsyncClient()
+  {
+    for (auto& conn : connections) {
+      conn->stop();
+    }
+  }
+
+  UvvmCosimAsyncClient(const UvvmCosimAsyncClient&) = delete;
+  UvvmCosimAsyncClient& operator=(const UvvmCosimAsyncClient&) = delete;
+
+  // --------------------------------------------------------------------------
+  // Generic calls
+  // --------------------------------------------------------------------------
+
+  // Call a procedure that isn't for a particular VVC. Transport and
+  // protocol errors are thrown from the future's get().
+  std::future<JsonResponse> Call(const std::string& method, json params)
+  {
+    return submit(next_connection(), method, std::move(params));
+  }
+
+  void Call(const std::string& method, json params, Callback done)
+  {
+    submit(next_connection(), method, std::move(params), std::move(done));
+  }
+
+  // Call a procedure for a VVC, ordered with the other calls for it.
+  // The VVC is only used for routing, params must include it as well.
+  std::future<JsonResponse> CallForVvc(const std::string& vvc_type, int vvc_id,
+                                       const std::string& method, json params)
+  {
+    return submit(vvc_connection(vvc_type, vvc_id), method, std::move(params));
+  }
+
+  void CallForVvc(const std::string& vvc_type, int vvc_id,
+                  const std::string& method, json params, Callback done)
+  {
+    submit(vvc_connection(vvc_type, vvc_id), method, std::move(params), std::move(done));
+  }
+
+  // --------------------------------------------------------------------------
+  // Same procedures as UvvmCosimClient
+  // --------------------------------------------------------------------------
+
+  std::future<JsonResponse> StartSim() {
+    return Call("StartSim", json::array());
+  }
+
+  std::future<JsonResponse> PauseSim() {
+    return Call("PauseSim", json::array());
+  }
+
+  std::future<JsonResponse> TerminateSim() {
+    return Call("TerminateSim", json::array());
+  }
+
+  std::future<JsonResponse> GetSimTime() {
+    return Call("GetSimTime", json::array());
+  }
+
+  std::future<JsonResponse> GetSimProgress() {
+    return Call("GetSimProgress", json::array());
+  }
+
+  std::future<JsonResponse> GetVvcList() {
+    return Call("GetVvcList", json::array());
+  }
+
+  std::future<JsonResponse> SetVvcListenEnable(std::string vvc_type, int vvc_id, bool enable) {
+    return CallForVvc(vvc_type, vvc_id, "SetVvcListenEnable", {vvc_type, vvc_id, enable});
+  }
+
+  std::future<JsonResponse> TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+  {
+    return CallForVvc(vvc_type, vvc_id, "TransmitBytes", {vvc_type, vvc_id, data});
+  }
+
+  std::future<JsonResponse> TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> pkt)
+  {
+    return CallForVvc(vvc_type, vvc_id, "TransmitPacket", {vvc_type, vvc_id, pkt});
+  }
+
+  std::future<JsonResponse> TransmitPacketWithMeta(std::string vvc_type, int vvc_id,
+                                                   std::vector<uint8_t> pkt, PacketMeta meta)
+  {
+    return CallForVvc(vvc_type, vvc_id, "TransmitPacketWithMeta", {vvc_type, vvc_id, pkt, meta});
+  }
+
+  std::future<JsonResponse> ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length)
+  {
+    return CallForVvc(vvc_type, vvc_id, "ReceiveBytes", {vvc_type, vvc_id, num_bytes, exact_length});
+  }
+
+  std::future<JsonResponse> ReceivePacket(std::string vvc_type, int vvc_id)
+  {
+    return CallForVvc(vvc_type, vvc_id, "ReceivePacket", {vvc_type, vvc_id});
+  }
+
+  std::future<JsonResponse> WaitForPattern(std::string vvc_type, int vvc_id, std::vector<uint8_t> pattern,
+                                           int timeout_ms, bool consume)
+  {
+    return CallForVvc(vvc_type, vvc_id, "WaitForPattern", {vvc_type, vvc_id, pattern, timeout_ms, consume});
+  }
+
+private:
+  struct Request {
+    int id;
+    std::string body;
+    std::function<void(std::exception_ptr, JsonResponse)> done;
+  };
+
+  class Connection {
+    std::unique_ptr<jsonrpccxx::IClientConnector> connector;
+    std::mutex mtx;
+    std::condition_variable cv;
+    std::deque<Request> queue;
+    bool stopping = false;
+
+  public:
+    std::thread thread;
+
+    explicit Connection(std::unique_ptr<jsonrpccxx::IClientConnector> connector)
+      : connector(std::move(connector))
+    {
+    }
+
+    void push(Request req)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        queue.push_back(std::move(req));
+      }
+      cv.notify_one();
+    }
+
+    void stop()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mtx);
+        stopping = true;
+      }
+      cv.notify_one();
+
+      if (thread.joinable()) {
+        thread.join();
+      }
+    }
+
+    // Worker thread. Sends the queued requests one at a time until
+    // stopped, and the queue is empty.
+    void run()
+    {
+      while (true) {
+        Request req;
+
+        {
+          std::unique_lock<std::mutex> lock(mtx);
+          cv.wait(lock, [&]() { return stopping || !queue.empty(); });
+
+          if (queue.empty()) {
+            return;
+          }
+
+          req = std::move(queue.front());
+          queue.pop_front();
+        }
+
+        JsonResponse response;
+        std::exception_ptr error;
+
+        try {
+          response = parse_response(req.id, connector->Send(req.body));
+        }
+        catch (...) {
+          error = std::current_exception();
+        }
+
+        req.done(error, std::move(response));
+      }
+    }
+  };
+
+  std::vector<std::unique_ptr<Connection>> connections;
+  std::atomic<int> requestId = 0;
+  std::atomic<size_t> nextConnection = 0;
+
+  static JsonResponse parse_response(int id, const std::string& body)
+  {
+    json res = json::parse(body);
+
+    if (res.contains("error")) {
+      const json& err = res["error"];
+      throw jsonrpccxx::JsonRpcException(err.value("code", 0), err.value("message", std::string()));
+    }
+
+    if (!res.contains("id") || res["id"] != id) {
+      throw jsonrpccxx::JsonRpcException(-32603, "Response id does not match request id " +
+                                         std::to_string(id));
+    }
+
+    return res.at("result").get<JsonResponse>();
+  }
+
+  Connection& next_connection()
+  {
+    return *connections[nextConnection++ % connections.size()];
+  }
+
+  Connection& vvc_connection(const std::string& vvc_type, int vvc_id)
+  {
+    size_t h = std::hash<std::string>{}(vvc_type) ^ std::hash<int>{}(vvc_id);
+    return *connections[h % connections.size()];
+  }
+
+  Request make_request(const std::string& method, json params)
+  {
+    int id = requestId++;
+
+    json req = {
+      {"jsonrpc", "2.0"},
+      {"id", id},
+      {"method", method},
+      {"params", std::move(params)}
+    };
+
+    return Request{.id = id, .body = req.dump()};
+  }
+
+  std::future<JsonResponse> submit(Connection& conn, const std::string& method, json params)
+  {
+    auto promise = std::make_shared<std::promise<JsonResponse>>();
+    std::future<JsonResponse> future = promise->get_future();
+
+    Request req = make_request(method, std::move(params));
+    req.done = [promise](std::exception_ptr error, JsonResponse response) {
+      if (error) {
+        promise->set_exception(error);
+      } else {
+        promise->set_value(std::move(response));
+      }
+    };
+
+    conn.push(std::move(req));
+
+    return future;
+  }
+
+  void submit(Connection& conn, const std::string& method, json params, Callback done)
+  {
+    Request req = make_request(method, std::move(params));
+    req.done = [done = std::move(done)](std::exception_ptr error, JsonResponse response) {
+      if (error) {
+        try {
+          std::rethrow_exception(error);
+        }
+        catch (const std::exception& e) {
+          response = JsonResponse{.success = false, .result = json{{"error", e.what()}}};
+        }
+        catch (...) {
+          response = JsonResponse{.success = false, .result = json{{"error", "Unknown error"}}};
+        }
+      }
+      done(std::move(response));
+    };
+
+    conn.push(std::move(req));
+  }
+};
+
+} // namespace uvvm_cosim
@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "uvvm_cosim_client.hpp"
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Buffers small TransmitBytes calls on the client side, and sends the
+// data for each VVC in one TransmitBytes call when:
+//
+// - The buffered data for the VVC reaches flush_bytes
+// - The oldest buffered byte for the VVC is older than flush_delay. This
+//   is only checked when the writer is called, so a client that waits
+//   for something else should call Poll() now and then.
+// - Flush() is called
+//
+// Buffers are flushed oldest first: when the data for a VVC is sent, the
+// data of VVCs with older buffered bytes is sent before it. Data for one
+// VVC is always sent in the order it was written, but across VVCs the
+// order is only kept at buffer granularity, so bytes written to VVC B
+// while VVC A has data buffered may be sent after later bytes for A.
+//
+// Packets are sent immediately, and all buffered data is flushed before
+// them so the server gets the data in the same order as it was written.
+// The receive calls also flush all buffered data first, since the DUT
+// usually needs it to respond.
+//
+// Since the TransmitBytes calls are deferred, their errors are thrown as
+// runtime_error from the call that flushes them. Data the server rejected
+// is discarded, while data that couldn't be sent stays buffered, so the
+// flush can be retried.
+class UvvmCosimBufferedWriter {
+public:
+  struct Config {
+    size_t flush_bytes = 4096;
+    std::chrono::milliseconds flush_delay = std::chrono::milliseconds(5);
+  };
+
+  UvvmCosimBufferedWriter(UvvmCosimClient& client, Config cfg)
+    : client(client), cfg(cfg)
+  {
+  }
+
+  explicit UvvmCosimBufferedWriter(UvvmCosimClient& client)
+    : UvvmCosimBufferedWriter(client, Config())
+  {
+  }
+
+  ~UvvmCosimBufferedWriter()
+  {
+    try {
+      Flush();
+    }
+    catch (const std::exception&) {
+      // Nowhere to report it, Flush() before destruction to get errors
+    }
+  }
+
+  UvvmCosimBufferedWriter(const UvvmCosimBufferedWriter&) = delete;
+  UvvmCosimBufferedWriter& operator=(const UvvmCosimBufferedWriter&) = delete;
+
+  void TransmitBytes(const std::string& vvc_type, int vvc_id, const std::vector<uint8_t>& data)
+  {
+    Buffer& buf = get_buffer(vvc_type, vvc_id);
+
+    if (buf.data.empty()) {
+      buf.first_write = Clock::now();
+    }
+
+    buf.data.insert(buf.data.end(), data.begin(), data.end());
+
+    if (buf.data.size() >= cfg.flush_bytes) {
+      flush_written_before(buf.first_write);
+    }
+
+    Poll();
+  }
+
+  JsonResponse TransmitPacket(const std::string& vvc_type, int vvc_id, const std::vector<uint8_t>& pkt)
+  {
+    Flush();
+    return client.TransmitPacket(vvc_type, vvc_id, pkt);
+  }
+
+  JsonResponse TransmitPacketWithMeta(const std::string& vvc_type, int vvc_id,
+                                      const std::vector<uint8_t>& pkt, PacketMeta meta)
+  {
+    Flush();
+    return client.TransmitPacketWithMeta(vvc_type, vvc_id, pkt, meta);
+  }
+
+  JsonResponse ReceiveBytes(const std::string& vvc_type, int vvc_id, int num_bytes, bool exact_length)
+  {
+    Flush();
+    return client.ReceiveBytes(vvc_type, vvc_id, num_bytes, exact_length);
+  }
+
+  JsonResponse ReceivePacket(const std::string& vvc_type, int vvc_id)
+  {
+    Flush();
+    return client.ReceivePacket(vvc_type, vvc_id);
+  }
+
+  // Send the data buffered for all VVCs, starting with the VVC with the
+  // oldest data
+  void Flush()
+  {
+    flush_written_before(Clock::time_point::max());
+  }
+
+  // Send the data that has been buffered for longer than flush_delay
+  void Poll()
+  {
+    flush_written_before(Clock::now() - cfg.flush_delay);
+  }
+
+  size_t buffered_bytes() const
+  {
+    size_t size = 0;
+    for (const Buffer& buf : buffers) {
+      size += buf.data.size();
+    }
+    return size;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Buffer {
+    std::string vvc_type;
+    int vvc_id;
+    std::vector<uint8_t> data;
+    Clock::time_point first_write;
+  };
+
+  UvvmCosimClient& client;
+  Config cfg;
+
+  // Only a handful of VVCs are written to by a client, so a linear
+  // search is as fast as anything
+  std::vector<Buffer> buffers;
+
+  Buffer& get_buffer(const std::string& vvc_type, int vvc_id)
+  {
+    for (Buffer& buf : buffers) {
+      if (buf.vvc_id == vvc_id && buf.vvc_type == vvc_type) {
+        return buf;
+      }
+    }
+
+    buffers.push_back(Buffer{.vvc_type = vvc_type, .vvc_id = vvc_id});
+    return buffers.back();
+  }
+
+  // Flush the buffers whose oldest byte was written at or before t,
+  // oldest first
+  void flush_written_before(Clock::time_point t)
+  {
+    std::vector<Buffer*> pending;
+
+    for (Buffer& buf : buffers) {
+      if (!buf.data.empty() && buf.first_write <= t) {
+        pending.push_back(&buf);
+      }
+    }
+
+    std::stable_sort(pending.begin(), pending.end(), [](const Buffer* a, const Buffer* b) {
+      return a->first_write < b->first_write;
+    });
+
+    for (Buffer* buf : pending) {
+      flush(*buf);
+    }
+  }
+
+  void flush(Buffer& buf)
+  {
+    std::vector<uint8_t> data;
+    data.swap(buf.data);
+
+    JsonResponse response;
+
+    try {
+      response = client.TransmitBytes(buf.vvc_type, buf.vvc_id, data);
+    }
+    catch (...) {
+      // Nothing was sent, keep the data for the next flush
+      buf.data.swap(data);
+      throw;
+    }
+
+    if (!response.success) {
+      throw std::runtime_error("TransmitBytes to " + buf.vvc_type + " " + std::to_string(buf.vvc_id) +
+                               " failed, " + std::to_string(data.size()) + " bytes discarded: " +
+                               response.result.value("error", std::string()));
+    }
+  }
+};
+
+} // namespace uvvm_cosim
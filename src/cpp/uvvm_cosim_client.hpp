@@ -1,3 +1,4 @@
+#include <atomic>
 #include <cstdint>
 #include <iostream>
 #include <thread>
@@ -9,7 +10,7 @@
 namespace uvvm_cosim {
 
 class UvvmCosimClient : private jsonrpccxx::JsonRpcClient {
-  int requestId = 0;
+  std::atomic<int> requestId = 0;
 
 public:
   explicit UvvmCosimClient(jsonrpccxx::IClientConnector &connector)
@@ -29,6 +30,22 @@ public:
     return CallMethod<JsonResponse>(requestId++, "TerminateSim", {});
   }
 
+  JsonResponse SetLockstepMode(bool enable) {
+    return CallMethod<JsonResponse>(requestId++, "SetLockstepMode", {enable});
+  }
+
+  JsonResponse RunFor(uint64_t amount, std::string unit) {
+    return CallMethod<JsonResponse>(requestId++, "RunFor", {amount, unit});
+  }
+
+  JsonResponse GetSimTime() {
+    return CallMethod<JsonResponse>(requestId++, "GetSimTime", {});
+  }
+
+  JsonResponse GetSimProgress() {
+    return CallMethod<JsonResponse>(requestId++, "GetSimProgress", {});
+  }
+
   JsonResponse GetVvcList() {
     return CallMethod<JsonResponse>(requestId++, "GetVvcList", {});
   }
@@ -47,6 +64,18 @@ public:
     return CallMethod<JsonResponse>(requestId++, "TransmitPacket", {vvc_type, vvc_id, pkt});
   }
 
+  JsonResponse TransmitPacketWithMeta(std::string vvc_type, int vvc_id, std::vector<uint8_t> pkt,
+                                      PacketMeta meta)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitPacketWithMeta", {vvc_type, vvc_id, pkt, meta});
+  }
+
+  JsonResponse TransmitFromFile(std::string vvc_type, int vvc_id, std::string path,
+                                uint64_t offset, uint64_t length, int packetize_by)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitFromFile", {vvc_type, vvc_id, path, offset, length, packetize_by});
+  }
+
   JsonResponse ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length)
   {
     return CallMethod<JsonResponse>(requestId++, "ReceiveBytes", {vvc_type, vvc_id, num_bytes, exact_length});
@@ -57,6 +86,94 @@ public:
     return CallMethod<JsonResponse>(requestId++, "ReceivePacket", {vvc_type, vvc_id});
   }
 
+  JsonResponse ReceiveBytesWithTimestamps(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceiveBytesWithTimestamps", {vvc_type, vvc_id, num_bytes, exact_length});
+  }
+
+  JsonResponse ReceivePacketWithTimestamps(std::string vvc_type, int vvc_id)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceivePacketWithTimestamps", {vvc_type, vvc_id});
+  }
+
+  JsonResponse WaitForPattern(std::string vvc_type, int vvc_id, std::vector<uint8_t> pattern,
+                              int timeout_ms, bool consume)
+  {
+    return CallMethod<JsonResponse>(requestId++, "WaitForPattern", {vvc_type, vvc_id, pattern, timeout_ms, consume});
+  }
+
+  JsonResponse GetQueueStatus(bool reset_high_water = false)
+  {
+    return CallMethod<JsonResponse>(requestId++, "GetQueueStatus", {reset_high_water});
+  }
+
+  JsonResponse WaitForAny(std::vector<VvcRef> receive_vvcs, std::vector<VvcRef> transmit_vvcs,
+                          int transmit_threshold, int timeout_ms)
+  {
+    return CallMethod<JsonResponse>(requestId++, "WaitForAny", {receive_vvcs, transmit_vvcs, transmit_threshold, timeout_ms});
+  }
+
+  JsonResponse TransmitMulti(std::vector<TransmitEntry> entries)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitMulti", {entries});
+  }
+
+  JsonResponse ReceiveMulti(std::vector<ReceiveEntry> entries)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceiveMulti", {entries});
+  }
+
+  JsonResponse GetLockStats(bool reset = false)
+  {
+    return CallMethod<JsonResponse>(requestId++, "GetLockStats", {reset});
+  }
+
+  JsonResponse AttachReceiveSink(std::string vvc_type, int vvc_id, std::string path,
+                                 std::string format, int link_type)
+  {
+    return CallMethod<JsonResponse>(requestId++, "AttachReceiveSink", {vvc_type, vvc_id, path, format, link_type});
+  }
+
+  JsonResponse DetachReceiveSink(std::string vvc_type, int vvc_id)
+  {
+    return CallMethod<JsonResponse>(requestId++, "DetachReceiveSink", {vvc_type, vvc_id});
+  }
+
+  JsonResponse ResolveVvc(std::string vvc_type, int vvc_id)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ResolveVvc", {vvc_type, vvc_id});
+  }
+
+  JsonResponse TransmitBytesByHandle(uint32_t handle, std::vector<uint8_t> data)
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitBytesByHandle", {handle, data});
+  }
+
+  JsonResponse TransmitPacketByHandle(uint32_t handle, std::vector<uint8_t> pkt, PacketMeta meta = {})
+  {
+    return CallMethod<JsonResponse>(requestId++, "TransmitPacketByHandle", {handle, pkt, meta});
+  }
+
+  JsonResponse ReceiveBytesByHandle(uint32_t handle, int num_bytes, bool exact_length)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceiveBytesByHandle", {handle, num_bytes, exact_length});
+  }
+
+  JsonResponse ReceivePacketByHandle(uint32_t handle)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceivePacketByHandle", {handle});
+  }
+
+  JsonResponse ReceiveBytesByHandleWithTimestamps(uint32_t handle, int num_bytes, bool exact_length)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceiveBytesByHandleWithTimestamps", {handle, num_bytes, exact_length});
+  }
+
+  JsonResponse ReceivePacketByHandleWithTimestamps(uint32_t handle)
+  {
+    return CallMethod<JsonResponse>(requestId++, "ReceivePacketByHandleWithTimestamps", {handle});
+  }
+
 };
 
 } // namespace uvvm_cosim
@@ -1,10 +1,13 @@
 #include <cstdint>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <string>
 #include <thread>
 #include <vector>
 #include <jsonrpccxx/client.hpp>
 #include <jsonrpccxx/iclientconnector.hpp>
-#include <cpphttplibconnector.hpp>
+#include "http_connector.hpp"
 #include "uvvm_cosim_client.hpp"
 #include "uvvm_cosim_types.hpp"
 
@@ -65,18 +68,47 @@ void print_vvc_list(const JsonResponse& vvc_list_json)
   }
 }
 
-// Test connecting, transmitting and receiving some bytes
-int main(int argc, char** argv)
+// If UVVM_COSIM_READY_FILE is set, wait for the simulator to write the
+// port to it, so we can connect as soon as the server is up. Otherwise
+// use UVVM_COSIM_PORT (or the default port), and give the server a
+// moment to start.
+int get_server_port(void)
 {
   using namespace std::chrono_literals;
 
-  CppHttpLibClientConnector http_connector("localhost", 8484);
-  UvvmCosimClient client(http_connector);
+  if (const char* ready_file = std::getenv("UVVM_COSIM_READY_FILE")) {
+    std::cout << "Wait for server to be ready...." << std::endl;
 
-  std::cout << "Wait a bit...." << std::endl;
+    while (true) {
+      std::ifstream f(ready_file);
+      int port;
+
+      if (f >> port) {
+        return port;
+      }
 
+      std::this_thread::sleep_for(10ms);
+    }
+  }
+
+  std::cout << "Wait a bit...." << std::endl;
   std::this_thread::sleep_for(1.0s);
 
+  if (const char* env_port = std::getenv("UVVM_COSIM_PORT")) {
+    return std::stoi(env_port);
+  }
+
+  return 8484;
+}
+
+// Test connecting, transmitting and receiving some bytes
+int main(int argc, char** argv)
+{
+  using namespace std::chrono_literals;
+
+  HttpClientConnector http_connector("localhost", get_server_port());
+  UvvmCosimClient client(http_connector);
+
   std::cout << "Start sim...." << std::endl;
 
   client.StartSim();
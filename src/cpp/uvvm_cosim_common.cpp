@@ -1,5 +1,12 @@
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
 #include <optional>
+#include <stdexcept>
 #include <string>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "uvvm_cosim_server.hpp"
 #include "uvvm_cosim_types.hpp"
 #include "uvvm_cosim_common.hpp"
@@ -13,24 +20,239 @@ namespace uvvm_cosim {
 // TODO: Use shared or unique pointer?
 static UvvmCosimServer* cosim_server = nullptr;
 
+// Get integer value of environment variable, or default_value if not set
+static int get_env_int(const char* name, int default_value)
+{
+  const char* value = std::getenv(name);
+
+  if (value == nullptr) {
+    return default_value;
+  }
+
+  try {
+    return std::stoi(value);
+  }
+  catch (const std::exception&) {
+    throw std::runtime_error(std::string("Invalid value for ") + name + ": " + value);
+  }
+}
+
+// The JSON-RPC server is configured with environment variables, so the
+// settings can be changed per run without changing the testbench
+static HttpServerConfig get_http_server_config(void)
+{
+  HttpServerConfig cfg;
+
+  if (const char* addr = std::getenv("UVVM_COSIM_BIND_ADDRESS")) {
+    cfg.bind_address = addr;
+  }
+
+  cfg.port              = get_env_int("UVVM_COSIM_PORT", cfg.port);
+  cfg.threads           = get_env_int("UVVM_COSIM_THREADS", cfg.threads);
+  cfg.keepalive_timeout = get_env_int("UVVM_COSIM_KEEPALIVE_TIMEOUT", cfg.keepalive_timeout);
+  cfg.keepalive_max     = get_env_int("UVVM_COSIM_KEEPALIVE_MAX", cfg.keepalive_max);
+
+  return cfg;
+}
+
+// Adaptive polling of the transmit queues is configured the same way
+static PollConfig get_poll_config(void)
+{
+  PollConfig cfg;
+
+  int idle_cycles = get_env_int("UVVM_COSIM_POLL_IDLE_CYCLES", cfg.idle_cycles);
+  int max_cycles  = get_env_int("UVVM_COSIM_POLL_MAX_CYCLES", cfg.max_cycles);
+
+  if (idle_cycles < 0 || max_cycles < 1) {
+    throw std::runtime_error("Invalid UVVM_COSIM_POLL_IDLE_CYCLES or UVVM_COSIM_POLL_MAX_CYCLES");
+  }
+
+  cfg.idle_cycles = idle_cycles;
+  cfg.max_cycles  = max_cycles;
+
+  return cfg;
+}
+
+static void write_all(int fd, const std::string& str, const std::string& name)
+{
+  const char* p = str.data();
+  size_t remaining = str.size();
+
+  while (remaining > 0) {
+    ssize_t n = write(fd, p, remaining);
+
+    if (n < 0 && errno != EINTR) {
+      throw std::runtime_error("Failed to write to " + name + ": " + std::strerror(errno));
+    } else if (n > 0) {
+      p += n;
+      remaining -= n;
+    }
+  }
+}
+
+// Tell whoever started the simulation that the server is ready, and which
+// port it listens on. This lets a client connect as soon as the server is
+// up, and lets parallel simulations use port 0 to get a free port each.
+//
+// UVVM_COSIM_READY_FILE: The port is written to this file. The file is
+//   written under a temporary name and renamed, so it never appears partly
+//   written. If it is a named pipe, the port is written to the pipe.
+// UVVM_COSIM_READY_FD: The port is written to this inherited file
+//   descriptor, which is then closed.
+static void notify_ready(int port)
+{
+  const std::string msg = std::to_string(port) + "\n";
+
+  if (const char* path = std::getenv("UVVM_COSIM_READY_FILE")) {
+    struct stat st;
+
+    if (stat(path, &st) == 0 && S_ISFIFO(st.st_mode)) {
+      // Blocks until the reader has opened the pipe
+      int fd = open(path, O_WRONLY | O_CLOEXEC);
+
+      if (fd < 0) {
+        throw std::runtime_error(std::string("Failed to open ") + path + ": " + std::strerror(errno));
+      }
+
+      write_all(fd, msg, path);
+      close(fd);
+    } else {
+      std::string tmp_path = std::string(path) + ".tmp";
+      int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+      if (fd < 0) {
+        throw std::runtime_error("Failed to open " + tmp_path + ": " + std::strerror(errno));
+      }
+
+      write_all(fd, msg, tmp_path);
+      close(fd);
+
+      if (rename(tmp_path.c_str(), path) != 0) {
+        throw std::runtime_error("Failed to rename " + tmp_path + ": " + std::strerror(errno));
+      }
+    }
+  }
+
+  if (const char* fd_str = std::getenv("UVVM_COSIM_READY_FD")) {
+    int fd = get_env_int("UVVM_COSIM_READY_FD", -1);
+
+    write_all(fd, msg, std::string("UVVM_COSIM_READY_FD ") + fd_str);
+    close(fd);
+  }
+}
+
 static void start_rpc_server(void)
 {
-  // Todo:
-  // Use a foreign function and call after UVVM init instead?
-  // Then we can set port in a generic in VHDL code
+  HttpServerConfig http_cfg;
 
-  cosim_server = new UvvmCosimServer(8484);
+  // Remove ready file left over from an earlier run, so a client doesn't
+  // pick up a stale port
+  if (const char* path = std::getenv("UVVM_COSIM_READY_FILE")) {
+    struct stat st;
+    if (stat(path, &st) == 0 && !S_ISFIFO(st.st_mode)) {
+      unlink(path);
+    }
+  }
+
+  try {
+    http_cfg = get_http_server_config();
+  }
+  catch (const std::exception& e) {
+    sim_printf("Error: %s, using default server config", e.what());
+  }
+
+  cosim_server = new UvvmCosimServer(http_cfg);
+
+  try {
+    PollConfig poll_cfg = get_poll_config();
+    cosim_server->SetPollConfig(poll_cfg);
+
+    if (poll_cfg.max_cycles > 1) {
+      sim_printf("Adaptive polling enabled, up to %u cycles after %u idle cycles",
+                 poll_cfg.max_cycles, poll_cfg.idle_cycles);
+    }
+  }
+  catch (const std::exception& e) {
+    sim_printf("Error: %s, adaptive polling disabled", e.what());
+  }
+
+  try {
+    if (const char* root = std::getenv("UVVM_COSIM_FILE_ROOT")) {
+      cosim_server->SetFileRoot(root);
+      sim_printf("TransmitFromFile enabled for files under %s", root);
+    }
+  }
+  catch (const std::exception& e) {
+    sim_printf("Error: %s, TransmitFromFile disabled", e.what());
+  }
+
+  // Traffic capture and replay are set up with environment variables, so
+  // a captured session can be rerun without changing the testbench
+  try {
+    if (get_env_int("UVVM_COSIM_LOCKSTEP", 0) != 0) {
+      sim_printf("Lockstep mode enabled");
+      cosim_server->SetLockstep(true);
+    }
+
+    if (get_env_int("UVVM_COSIM_LOCK_STATS", 0) != 0) {
+      sim_printf("Lock statistics enabled");
+      cosim_server->SetLockStats(true);
+    }
+
+    if (const char* path = std::getenv("UVVM_COSIM_CAPTURE_FILE")) {
+      sim_printf("Capturing cosim traffic to %s", path);
+      cosim_server->StartCapture(path);
+    }
+
+    if (const char* path = std::getenv("UVVM_COSIM_REPLAY_FILE")) {
+      // Max sim time to wait for receive data after the last event in the log
+      uint64_t timeout_ns = 1000000;
+
+      if (const char* timeout = std::getenv("UVVM_COSIM_REPLAY_TIMEOUT_NS")) {
+        timeout_ns = std::stoull(timeout);
+      }
+
+      sim_printf("Replaying cosim traffic from %s", path);
+      cosim_server->StartReplay(path, timeout_ns);
+    }
+  }
+  catch (const std::exception& e) {
+    sim_printf("Error: %s", e.what());
+  }
 
   sim_printf("Start JSON RPC server");
-  cosim_server->StartListening();
+
+  try {
+    cosim_server->StartListening();
+    sim_printf("JSON RPC server listening on %s:%d", http_cfg.bind_address.c_str(), cosim_server->Port());
+    notify_ready(cosim_server->Port());
+  }
+  catch (const std::exception& e) {
+    sim_printf("Error: %s", e.what());
+  }
 }
 
 static void stop_rpc_server(void)
 {
+  if (cosim_server->ReplayActive()) {
+    sim_printf("%s", cosim_server->ReplaySummary().c_str());
+  }
+
+  if (cosim_server->LockStatsEnabled()) {
+    for (const std::string& line : cosim_server->LockStatsSummary()) {
+      sim_printf("%s", line.c_str());
+    }
+  }
+
   sim_printf("Stop JSON RPC server");
   cosim_server->StopListening();
   sim_printf("JSON RPC server stopped");
 
+  // Closed after the server has stopped, so no more traffic is written
+  if (std::string error = cosim_server->StopCapture(); !error.empty()) {
+    sim_printf("Error: %s, captured traffic log is incomplete", error.c_str());
+  }
+
   delete cosim_server;
   cosim_server = nullptr;
 }
@@ -40,13 +262,17 @@ static void stop_rpc_server(void)
 // VHPI foreign functions, procedures, and callbacks
 // ----------------------------------------------------------------------------
 
-bool transmit_byte_queue_empty(std::string vvc_type, int vvc_instance_id)
+int transmit_byte_queue_empty(const std::string& vvc_type, int vvc_instance_id)
 {
-  return cosim_server->TransmitQueueEmpty(vvc_type, vvc_instance_id);
+  LockOp op(LOK_FOREIGN, "transmit_byte_queue_empty");
+
+  return cosim_server->TransmitQueuePoll(vvc_type, vvc_instance_id);
 }
 
-int transmit_byte_queue_get(std::string vvc_type, int vvc_instance_id)
+int transmit_byte_queue_get(const std::string& vvc_type, int vvc_instance_id)
 {
+  LockOp op(LOK_FOREIGN, "transmit_byte_queue_get");
+
   auto byte = cosim_server->TransmitQueueGet(vvc_type, vvc_instance_id);
 
   if (byte) {
@@ -60,18 +286,24 @@ int transmit_byte_queue_get(std::string vvc_type, int vvc_instance_id)
   }
 }
 
-void receive_byte_queue_put(std::string vvc_type, int vvc_instance_id, uint8_t byte)
+void receive_byte_queue_put(const std::string& vvc_type, int vvc_instance_id, uint8_t byte)
 {
+  LockOp op(LOK_FOREIGN, "receive_byte_queue_put");
+
   cosim_server->ReceiveQueuePut(vvc_type, vvc_instance_id, byte);
 }
 
-bool transmit_packet_queue_empty(std::string vvc_type, int vvc_instance_id)
+int transmit_packet_queue_empty(const std::string& vvc_type, int vvc_instance_id)
 {
-  return cosim_server->TransmitPacketQueueEmpty(vvc_type, vvc_instance_id);
+  LockOp op(LOK_FOREIGN, "transmit_packet_queue_empty");
+
+  return cosim_server->TransmitPacketQueuePoll(vvc_type, vvc_instance_id);
 }
 
-int transmit_packet_queue_get(std::string vvc_type, int vvc_instance_id)
+int transmit_packet_queue_get(const std::string& vvc_type, int vvc_instance_id)
 {
+  LockOp op(LOK_FOREIGN, "transmit_packet_queue_get");
+
   auto byte = cosim_server->TransmitPacketQueueGet(vvc_type, vvc_instance_id);
 
   if (byte) {
@@ -88,15 +320,73 @@ int transmit_packet_queue_get(std::string vvc_type, int vvc_instance_id)
   }
 }
 
-void receive_packet_queue_put(std::string vvc_type, int vvc_instance_id,
+void receive_packet_queue_put(const std::string& vvc_type, int vvc_instance_id,
 			      uint8_t byte, bool eop)
 {
+  LockOp op(LOK_FOREIGN, "receive_packet_queue_put");
+
   cosim_server->ReceivePacketQueuePut(vvc_type, vvc_instance_id, byte, eop);
 }
 
+std::vector<uint8_t> transmit_byte_queue_get_beat(const std::string& vvc_type, int vvc_instance_id,
+						  int max_bytes)
+{
+  LockOp op(LOK_FOREIGN, "transmit_byte_queue_get_beat");
+
+  return cosim_server->TransmitQueueGetBeat(vvc_type, vvc_instance_id, max_bytes);
+}
+
+void receive_byte_queue_put_beat(const std::string& vvc_type, int vvc_instance_id,
+				 const std::vector<uint8_t>& data)
+{
+  LockOp op(LOK_FOREIGN, "receive_byte_queue_put_beat");
+
+  cosim_server->ReceiveQueuePutBeat(vvc_type, vvc_instance_id, data);
+}
+
+std::vector<uint8_t> transmit_packet_queue_get_beat(const std::string& vvc_type, int vvc_instance_id,
+						    int max_bytes, bool& eop)
+{
+  LockOp op(LOK_FOREIGN, "transmit_packet_queue_get_beat");
+
+  return cosim_server->TransmitPacketQueueGetBeat(vvc_type, vvc_instance_id, max_bytes, eop);
+}
+
+void receive_packet_queue_put_beat(const std::string& vvc_type, int vvc_instance_id,
+				   const std::vector<uint8_t>& data, bool eop)
+{
+  LockOp op(LOK_FOREIGN, "receive_packet_queue_put_beat");
+
+  cosim_server->ReceivePacketQueuePutBeat(vvc_type, vvc_instance_id, data, eop);
+}
 
-void start_sim(void)
+std::vector<int> transmit_packet_queue_get_meta(const std::string& vvc_type, int vvc_instance_id)
 {
+  LockOp op(LOK_FOREIGN, "transmit_packet_queue_get_meta");
+
+  PacketMeta meta = cosim_server->TransmitPacketQueueGetMeta(vvc_type, vvc_instance_id);
+
+  return {(int)meta.tid, (int)meta.tdest, (int)meta.tuser};
+}
+
+void receive_packet_queue_put_meta(const std::string& vvc_type, int vvc_instance_id,
+				   const std::vector<int>& meta)
+{
+  LockOp op(LOK_FOREIGN, "receive_packet_queue_put_meta");
+
+  // Missing elements are zero
+  auto at = [&](size_t i) { return i < meta.size() ? (uint32_t)meta[i] : 0u; };
+
+  cosim_server->ReceivePacketQueuePutMeta(vvc_type, vvc_instance_id,
+					  PacketMeta{at(0), at(1), at(2)});
+}
+
+
+void start_sim(uint64_t sim_time_ns)
+{
+  LockOp op(LOK_FOREIGN, "start_sim");
+
+  cosim_server->UpdateSimTime(sim_time_ns);
   cosim_server->WaitForStartSim();
 }
 
@@ -111,16 +401,20 @@ bool terminate_sim(void)
   return terminate;
 }
 
-bool vvc_listen_enable(std::string vvc_type, int vvc_instance_id)
+bool vvc_listen_enable(const std::string& vvc_type, int vvc_instance_id)
 {
+  LockOp op(LOK_FOREIGN, "vvc_listen_enable");
+
   return cosim_server->VvcListenEnabled(vvc_type, vvc_instance_id);
 }
 
-void report_vvc_info(std::string vvc_type,
-				std::string vvc_channel,
+void report_vvc_info(const std::string& vvc_type,
+				const std::string& vvc_channel,
 				int vvc_instance_id,
-				std::string bfm_cfg_str)
+				const std::string& bfm_cfg_str)
 {
+  LockOp op(LOK_FOREIGN, "report_vvc_info");
+
   sim_printf("uvvm_cosim_report_vvc_info: Got:");
   sim_printf("Type=%s, Channel=%s, ID=%d, cfg=%s",
 	     vvc_type.c_str(),
@@ -1,6 +1,7 @@
 #pragma once
 #include <string>
 #include <cstdint>
+#include <vector>
 
 namespace uvvm_cosim {
 
@@ -13,30 +14,56 @@ constexpr auto sim_printf = vhpi_printf;
 constexpr auto sim_printf = mti_PrintFormatted;
 #endif
 
-bool transmit_byte_queue_empty(std::string vvc_type, int vvc_instance_id);
+// The empty checks return 0 if the queue has data, otherwise the number
+// of cycles the VVC controller should wait before checking again
+int transmit_byte_queue_empty(const std::string& vvc_type, int vvc_instance_id);
 
-int transmit_byte_queue_get(std::string vvc_type, int vvc_instance_id);
+int transmit_byte_queue_get(const std::string& vvc_type, int vvc_instance_id);
 
-void receive_byte_queue_put(std::string vvc_type, int vvc_instance_id,
+void receive_byte_queue_put(const std::string& vvc_type, int vvc_instance_id,
                             uint8_t byte);
 
-bool transmit_packet_queue_empty(std::string vvc_type, int vvc_instance_id);
+int transmit_packet_queue_empty(const std::string& vvc_type, int vvc_instance_id);
 
-int transmit_packet_queue_get(std::string vvc_type, int vvc_instance_id);
+int transmit_packet_queue_get(const std::string& vvc_type, int vvc_instance_id);
 
-void receive_packet_queue_put(std::string vvc_type, int vvc_instance_id,
+void receive_packet_queue_put(const std::string& vvc_type, int vvc_instance_id,
 			      uint8_t byte, bool eop);
 
-void start_sim(void);
+// Beat variants which move up to max_bytes (transmit) or all of data
+// (receive) with one foreign call. The packet variants stop at the end of
+// a packet, with eop set for the beat that ends it.
+std::vector<uint8_t> transmit_byte_queue_get_beat(const std::string& vvc_type, int vvc_instance_id,
+						  int max_bytes);
+
+void receive_byte_queue_put_beat(const std::string& vvc_type, int vvc_instance_id,
+				 const std::vector<uint8_t>& data);
+
+std::vector<uint8_t> transmit_packet_queue_get_beat(const std::string& vvc_type, int vvc_instance_id,
+						    int max_bytes, bool& eop);
+
+void receive_packet_queue_put_beat(const std::string& vvc_type, int vvc_instance_id,
+				   const std::vector<uint8_t>& data, bool eop);
+
+// Sideband signals for the packet currently being transmitted or
+// received, as tid, tdest and tuser
+std::vector<int> transmit_packet_queue_get_meta(const std::string& vvc_type, int vvc_instance_id);
+
+void receive_packet_queue_put_meta(const std::string& vvc_type, int vvc_instance_id,
+				   const std::vector<int>& meta);
+
+// Called every cycle of the cosim clock with current simulation time.
+// Blocks while the simulation is paused.
+void start_sim(uint64_t sim_time_ns);
 
 bool terminate_sim(void);
 
-bool vvc_listen_enable(std::string vvc_type, int vvc_instance_id);
+bool vvc_listen_enable(const std::string& vvc_type, int vvc_instance_id);
 
-void report_vvc_info(std::string vvc_type,
-				std::string vvc_channel,
+void report_vvc_info(const std::string& vvc_type,
+				const std::string& vvc_channel,
 				int vvc_instance_id,
-				std::string bfm_cfg_str);
+				const std::string& bfm_cfg_str);
 
 void start_of_sim(void);
 
@@ -0,0 +1,375 @@
+#pragma once
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "uvvm_cosim_client.hpp"
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Coroutine interface to UvvmCosimClient, for running many test sequences
+// concurrently on one thread and one connection.
+//
+// A test sequence is a coroutine returning Sequence, which awaits the
+// procedures of this class:
+//
+//   UvvmCosimCoroClient::Sequence echo(UvvmCosimCoroClient& client, int vvc_id)
+//   {
+//     std::vector<uint8_t> pkt = {1, 2, 3};
+//     co_await client.TransmitPacket("AXISTREAM_VVC", vvc_id, pkt);
+//     JsonResponse response = co_await client.ReceivePacket("AXISTREAM_VVC", vvc_id);
+//   }
+//
+//   client.Spawn(echo(client, 0));
+//   client.Spawn(echo(client, 1));
+//   client.Run();
+//
+// Run() is the event loop. It resumes the sequences that are ready, and
+// then makes the RPC calls they are waiting for, once each in the order
+// they were made. The receive procedures don't complete until data has
+// been received. When data hasn't arrived yet, the call is retried on
+// the next round instead of blocking, so the other sequences keep
+// running. When no sequence made progress in a round, the loop sleeps for
+// the poll interval before polling again.
+//
+// Sequences can also await other sequences, which run to completion
+// before the caller continues. Procedures that fail throw runtime_error
+// in the sequence, and exceptions not caught in a spawned sequence are
+// rethrown from Run().
+class UvvmCosimCoroClient {
+public:
+  class Sequence {
+  public:
+    struct promise_type {
+      std::coroutine_handle<> continuation;
+      std::exception_ptr error;
+
+      Sequence get_return_object()
+      {
+        return Sequence(std::coroutine_handle<promise_type>::from_promise(*this));
+      }
+
+      std::suspend_always initial_suspend() noexcept { return {}; }
+
+      // Continue the awaiting sequence, if any
+      auto final_suspend() noexcept
+      {
+        struct FinalAwaiter {
+          bool await_ready() noexcept { return false; }
+
+          std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept
+          {
+            if (h.promise().continuation) {
+              return h.promise().continuation;
+            }
+            return std::noop_coroutine();
+          }
+
+          void await_resume() noexcept {}
+        };
+
+        return FinalAwaiter{};
+      }
+
+      void return_void() {}
+
+      void unhandled_exception() { error = std::current_exception(); }
+    };
+
+    Sequence(Sequence&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+
+    Sequence(const Sequence&) = delete;
+    Sequence& operator=(const Sequence&) = delete;
+
+    ~Sequence()
+    {
+      if (handle) {
+        handle.destroy();
+      }
+    }
+
+    // Awaiting a sequence runs it, and continues when it is done
+    bool await_ready() { return false; }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting)
+    {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    void await_resume()
+    {
+      if (handle.promise().error) {
+        std::rethrow_exception(handle.promise().error);
+      }
+    }
+
+  private:
+    friend class UvvmCosimCoroClient;
+
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Sequence(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+  };
+
+private:
+  // An RPC call or timer that a sequence is suspended on
+  struct Operation {
+    std::coroutine_handle<> waiting;
+
+    // Returns true when the operation is complete
+    virtual bool poll(UvvmCosimClient& client) = 0;
+
+  protected:
+    ~Operation() = default;
+  };
+
+public:
+  class RpcAwaitable : private Operation {
+  public:
+    using Call = std::function<JsonResponse(UvvmCosimClient&)>;
+    using Complete = std::function<bool(const JsonResponse&)>;
+
+    RpcAwaitable(UvvmCosimCoroClient& owner, Call call, Complete complete = nullptr)
+      : owner(owner), call(std::move(call)), complete(std::move(complete))
+    {
+    }
+
+    bool await_ready() { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      waiting = h;
+      owner.pending.push_back(this);
+    }
+
+    JsonResponse await_resume()
+    {
+      if (error) {
+        std::rethrow_exception(error);
+      }
+
+      if (!response.success) {
+        throw std::runtime_error(response.result.value("error", std::string("RPC call failed")));
+      }
+
+      return std::move(response);
+    }
+
+  private:
+    UvvmCosimCoroClient& owner;
+    Call call;
+    Complete complete;
+    JsonResponse response;
+    std::exception_ptr error;
+
+    bool poll(UvvmCosimClient& client) override
+    {
+      try {
+        response = call(client);
+      }
+      catch (...) {
+        error = std::current_exception();
+        return true;
+      }
+
+      return !response.success || !complete || complete(response);
+    }
+  };
+
+  class SleepAwaitable : private Operation {
+  public:
+    SleepAwaitable(UvvmCosimCoroClient& owner, std::chrono::steady_clock::time_point deadline)
+      : owner(owner), deadline(deadline)
+    {
+    }
+
+    bool await_ready() { return std::chrono::steady_clock::now() >= deadline; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+      waiting = h;
+      owner.pending.push_back(this);
+    }
+
+    void await_resume() {}
+
+  private:
+    UvvmCosimCoroClient& owner;
+    std::chrono::steady_clock::time_point deadline;
+
+    bool poll(UvvmCosimClient&) override
+    {
+      return std::chrono::steady_clock::now() >= deadline;
+    }
+  };
+
+  explicit UvvmCosimCoroClient(UvvmCosimClient& client,
+                               std::chrono::microseconds poll_interval = std::chrono::milliseconds(1))
+    : client(client), pollInterval(poll_interval)
+  {
+  }
+
+  ~UvvmCosimCoroClient()
+  {
+    // Operations live in the coroutine frames, so drop them first
+    pending.clear();
+    ready.clear();
+
+    for (auto h : sequences) {
+      h.destroy();
+    }
+  }
+
+  UvvmCosimCoroClient(const UvvmCosimCoroClient&) = delete;
+  UvvmCosimCoroClient& operator=(const UvvmCosimCoroClient&) = delete;
+
+  // Start a sequence on the next round of Run(). Can also be called from
+  // a running sequence.
+  void Spawn(Sequence sequence)
+  {
+    auto h = std::exchange(sequence.handle, nullptr);
+    sequences.push_back(h);
+    ready.push_back(h);
+  }
+
+  // Run until all spawned sequences are done
+  void Run()
+  {
+    while (!sequences.empty()) {
+      bool progress = !ready.empty();
+
+      while (!ready.empty()) {
+        auto h = ready.front();
+        ready.pop_front();
+        h.resume();
+      }
+
+      reap_sequences();
+
+      std::deque<Operation*> polling;
+      polling.swap(pending);
+
+      for (Operation* op : polling) {
+        if (op->poll(client)) {
+          ready.push_back(op->waiting);
+          progress = true;
+        } else {
+          pending.push_back(op);
+        }
+      }
+
+      if (!progress) {
+        std::this_thread::sleep_for(pollInterval);
+      }
+    }
+  }
+
+  // --------------------------------------------------------------------------
+  // Procedures, which are awaited by the sequences
+  // --------------------------------------------------------------------------
+
+  SleepAwaitable Sleep(std::chrono::steady_clock::duration duration)
+  {
+    return SleepAwaitable(*this, std::chrono::steady_clock::now() + duration);
+  }
+
+  RpcAwaitable GetSimTime()
+  {
+    return RpcAwaitable(*this, [](UvvmCosimClient& c) { return c.GetSimTime(); });
+  }
+
+  RpcAwaitable SetVvcListenEnable(std::string vvc_type, int vvc_id, bool enable)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.SetVvcListenEnable(vvc_type, vvc_id, enable);
+    });
+  }
+
+  RpcAwaitable TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.TransmitBytes(vvc_type, vvc_id, data);
+    });
+  }
+
+  RpcAwaitable TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> pkt)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.TransmitPacket(vvc_type, vvc_id, pkt);
+    });
+  }
+
+  RpcAwaitable TransmitPacketWithMeta(std::string vvc_type, int vvc_id, std::vector<uint8_t> pkt,
+                                      PacketMeta meta)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.TransmitPacketWithMeta(vvc_type, vvc_id, pkt, meta);
+    });
+  }
+
+  // Completes when num_bytes bytes have been received
+  RpcAwaitable ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.ReceiveBytes(vvc_type, vvc_id, num_bytes, true);
+    }, has_data);
+  }
+
+  // Completes when a packet has been received
+  RpcAwaitable ReceivePacket(std::string vvc_type, int vvc_id)
+  {
+    return RpcAwaitable(*this, [=](UvvmCosimClient& c) {
+      return c.ReceivePacket(vvc_type, vvc_id);
+    }, has_data);
+  }
+
+private:
+  UvvmCosimClient& client;
+  std::chrono::microseconds pollInterval;
+
+  // Spawned sequences that haven't finished
+  std::vector<std::coroutine_handle<Sequence::promise_type>> sequences;
+
+  std::deque<std::coroutine_handle<>> ready;
+  std::deque<Operation*> pending;
+
+  static bool has_data(const JsonResponse& response)
+  {
+    return response.result.contains("data") && !response.result["data"].empty();
+  }
+
+  // Destroy finished sequences, and rethrow the first exception any of
+  // them ended with
+  void reap_sequences()
+  {
+    std::exception_ptr error;
+
+    std::erase_if(sequences, [&](auto h) {
+      if (!h.done()) {
+        return false;
+      }
+
+      if (h.promise().error && !error) {
+        error = h.promise().error;
+      }
+
+      h.destroy();
+      return true;
+    });
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+} // namespace uvvm_cosim
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 #include <string>
@@ -6,51 +7,130 @@
 
 namespace uvvm_cosim {
 
+  auto UvvmCosimData::get_receive_sink(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid)
+    -> std::shared_ptr<ReceiveSink>
+  {
+    if (qid == QID_RECEIVE) {
+      return vvc_map.entry(vvc).second.receive_sink;
+    }
+    return nullptr;
+  }
+
+  void UvvmCosimData::call_put_hook(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                                    const uint8_t* data, size_t size, bool packet, bool eop)
+  {
+    if (putHook) {
+      putHook(qid, vvc_map.entry(vvc).first, simTimeNs, data, size, packet, eop);
+    }
+  }
+
+  QueueStatus UvvmCosimData::queue_status(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid,
+                                          bool reset_high_water)
+  {
+    auto& queues = vvc_map.entry(vvc).second.queues;
+    QueueStatus status{};
+
+    if (auto byte_queues = std::get_if<ByteQueuePair>(&queues)) {
+      ByteQueue& q = (*byte_queues)[qid];
+      status.bytes = q.size();
+      status.high_water_bytes = q.high_water_mark();
+
+      if (reset_high_water) {
+        q.reset_high_water_mark();
+      }
+    } else {
+      PacketQueue& q = std::get<PacketQueuePair>(queues)[qid];
+      status.bytes = q.size_bytes();
+      status.packets = q.size();
+      status.high_water_bytes = q.high_water_mark_bytes();
+      status.high_water_packets = q.high_water_mark();
+
+      if (reset_high_water) {
+        q.reset_high_water_marks();
+      }
+    }
+
+    return status;
+  }
+
+  int UvvmCosimData::update_poll_state(VvcMapInternal& vvc_map, VvcHandle vvc, bool empty)
+  {
+    PollState& poll = vvc_map.entry(vvc).second.poll;
+
+    if (!empty) {
+      poll = PollState{};
+      return 0;
+    }
+
+    // The controller waited for the interval returned by the last poll
+    poll.idle_cycles += poll.interval;
+
+    if (poll.idle_cycles >= pollConfig.idle_cycles) {
+      poll.interval = std::min(poll.interval * 2, std::max(pollConfig.max_cycles, 1u));
+    }
+
+    return poll.interval;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Byte queue private functions
   /////////////////////////////////////////////////////////////////////////////
 
-  auto UvvmCosimData::get_byte_queue(VvcMapInternal& vvc_map, VvcInstanceKey vvc, QueueId qid) -> ByteQueue&
+  auto UvvmCosimData::get_byte_queue(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid) -> ByteQueue&
   {
-    if (auto it = vvc_map.find(vvc); it != vvc_map.end()) {
-      if (it->second.cfg.packet_based) {
-	throw std::runtime_error("Tried to access byte queue for packet-based VVC " + to_string(vvc) + ".");
-      }
-      return it->second.byte_queues[qid];
-    } else {
-      throw std::runtime_error("VVC " + to_string(vvc) + " does not exist.");
+    auto& [key, data] = vvc_map.entry(vvc);
+
+    if (auto queues = std::get_if<ByteQueuePair>(&data.queues)) {
+      return (*queues)[qid];
     }
+    throw std::runtime_error("Tried to access byte queue for packet-based VVC " + to_string(key) + ".");
   }
 
-  bool UvvmCosimData::byte_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc)
+  bool UvvmCosimData::byte_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc)
   {
     return get_byte_queue(vvc_map, vvc, qid).empty();
   }
 
-  size_t UvvmCosimData::byte_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc)
+  size_t UvvmCosimData::byte_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc)
   {
     return get_byte_queue(vvc_map, vvc, qid).size();
   }
 
-  void UvvmCosimData::byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, uint8_t byte)
+  auto UvvmCosimData::byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, uint8_t byte)
+    -> std::shared_ptr<ReceiveSink>
   {
-    get_byte_queue(vvc_map, vvc, qid).put(byte);
+    call_put_hook(vvc_map, qid, vvc, &byte, 1, false, false);
+
+    if (auto sink = get_receive_sink(vvc_map, vvc, qid)) {
+      return sink;
+    }
+
+    get_byte_queue(vvc_map, vvc, qid).put(byte, now());
+    return nullptr;
   }
 
-  void UvvmCosimData::byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc,
-                      const std::vector<uint8_t>& data)
+  auto UvvmCosimData::byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                      const std::vector<uint8_t>& data) -> std::shared_ptr<ReceiveSink>
   {
-    get_byte_queue(vvc_map, vvc, qid).put(data);
+    call_put_hook(vvc_map, qid, vvc, data.data(), data.size(), false, false);
+
+    if (auto sink = get_receive_sink(vvc_map, vvc, qid)) {
+      return sink;
+    }
+
+    get_byte_queue(vvc_map, vvc, qid).put(data, now());
+    return nullptr;
   }
 
-  auto UvvmCosimData::byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::optional<uint8_t>
+  auto UvvmCosimData::byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc) -> std::optional<uint8_t>
   {
     return get_byte_queue(vvc_map, vvc, qid).get();
   }
 
-  auto UvvmCosimData::byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, int num_bytes) -> std::vector<uint8_t>
+  auto UvvmCosimData::byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, int num_bytes,
+                                     std::vector<SimStampRun>* stamps) -> std::vector<uint8_t>
   {
-    return get_byte_queue(vvc_map, vvc, qid).get(num_bytes);
+    return get_byte_queue(vvc_map, vvc, qid).get(num_bytes, stamps);
   }
 
 
@@ -58,46 +138,121 @@ namespace uvvm_cosim {
   // Packet queue private functions
   /////////////////////////////////////////////////////////////////////////////
 
-  auto UvvmCosimData::get_packet_queue(VvcMapInternal& vvc_map, VvcInstanceKey vvc, QueueId qid) -> PacketQueue&
+  auto UvvmCosimData::get_packet_queue(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid) -> PacketQueue&
   {
-    if (auto it = vvc_map.find(vvc); it != vvc_map.end()) {
-      if (!it->second.cfg.packet_based) {
-	throw std::runtime_error("Tried to access packet queue for non-packet based VVC " + to_string(vvc) + ".");
-      }
-      return it->second.packet_queues[qid];
-    } else {
-      throw std::runtime_error("VVC " + to_string(vvc) + " does not exist.");
+    auto& [key, data] = vvc_map.entry(vvc);
+
+    if (auto queues = std::get_if<PacketQueuePair>(&data.queues)) {
+      return (*queues)[qid];
     }
+    throw std::runtime_error("Tried to access packet queue for non-packet based VVC " + to_string(key) + ".");
   }
 
-  bool UvvmCosimData::packet_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc)
+  bool UvvmCosimData::packet_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc)
   {
     return get_packet_queue(vvc_map, vvc, qid).empty();
   }
 
-  size_t UvvmCosimData::packet_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc)
+  size_t UvvmCosimData::packet_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc)
   {
     return get_packet_queue(vvc_map, vvc, qid).size();
   }
 
-  auto UvvmCosimData::packet_queue_get_byte(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::optional<std::pair<uint8_t, bool>>
+  auto UvvmCosimData::packet_queue_get_byte(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc) -> std::optional<std::pair<uint8_t, bool>>
   {
     return get_packet_queue(vvc_map, vvc, qid).get_byte();
   }
 
-  auto UvvmCosimData::packet_queue_get_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::vector<uint8_t>
+  auto UvvmCosimData::packet_queue_get_bytes(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                                             size_t max_bytes, bool& eop) -> std::vector<uint8_t>
+  {
+    return get_packet_queue(vvc_map, vvc, qid).get_bytes(max_bytes, eop);
+  }
+
+  auto UvvmCosimData::packet_queue_get_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                                           PacketStamp* stamp, PacketMeta* meta) -> std::vector<uint8_t>
+  {
+    return get_packet_queue(vvc_map, vvc, qid).get_pkt(stamp, meta);
+  }
+
+  PacketMeta UvvmCosimData::packet_queue_get_meta(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc)
+  {
+    return get_packet_queue(vvc_map, vvc, qid).get_meta();
+  }
+
+  void UvvmCosimData::packet_queue_put_meta(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, PacketMeta meta)
+  {
+    // Sinks only write the packet data
+    if (!get_receive_sink(vvc_map, vvc, qid)) {
+      get_packet_queue(vvc_map, vvc, qid).put_meta(meta);
+    }
+  }
+
+  auto UvvmCosimData::packet_queue_put_byte(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, uint8_t byte, bool eop)
+    -> std::shared_ptr<ReceiveSink>
   {
-    return get_packet_queue(vvc_map, vvc, qid).get_pkt();
+    call_put_hook(vvc_map, qid, vvc, &byte, 1, true, eop);
+
+    if (auto sink = get_receive_sink(vvc_map, vvc, qid)) {
+      return sink;
+    }
+
+    get_packet_queue(vvc_map, vvc, qid).put_byte(byte, eop, now());
+    return nullptr;
+  }
+
+  auto UvvmCosimData::packet_queue_put_bytes(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                                             const std::vector<uint8_t>& data, bool eop) -> std::shared_ptr<ReceiveSink>
+  {
+    call_put_hook(vvc_map, qid, vvc, data.data(), data.size(), true, eop);
+
+    if (auto sink = get_receive_sink(vvc_map, vvc, qid)) {
+      return sink;
+    }
+
+    get_packet_queue(vvc_map, vvc, qid).put_bytes(data, eop, now());
+    return nullptr;
   }
 
-  void UvvmCosimData::packet_queue_put_byte(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, uint8_t byte, bool eop)
+  auto UvvmCosimData::packet_queue_put_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& pkt,
+                                           PacketMeta meta) -> std::shared_ptr<ReceiveSink>
   {
-    get_packet_queue(vvc_map, vvc, qid).put_byte(byte, eop);
+    if (qid == QID_TRANSMIT) {
+      check_packet_meta(vvc_map, vvc, meta);
+    }
+
+    call_put_hook(vvc_map, qid, vvc, pkt.data(), pkt.size(), true, true);
+
+    if (auto sink = get_receive_sink(vvc_map, vvc, qid)) {
+      return sink;
+    }
+
+    get_packet_queue(vvc_map, vvc, qid).put_pkt(pkt, now(), meta);
+    return nullptr;
   }
 
-  void UvvmCosimData::packet_queue_put_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt)
+  void UvvmCosimData::check_packet_meta(VvcMapInternal& vvc_map, VvcHandle vvc, PacketMeta meta)
   {
-    get_packet_queue(vvc_map, vvc, qid).put_pkt(pkt);
+    auto& [key, data] = vvc_map.entry(vvc);
+
+    auto check = [&](const std::string& name, uint32_t value) {
+      // Values are passed to the simulator as a VHDL integer, so 31 bits
+      // is the limit for VVCs that don't report the signal width
+      int bits = 31;
+
+      if (auto it = data.cfg.bfm_cfg.find(name + "_bits"); it != data.cfg.bfm_cfg.end()) {
+        bits = std::clamp(it->second, 0, 31);
+      }
+
+      if ((value >> bits) != 0) {
+        throw std::runtime_error(name + " " + std::to_string(value) + " is wider than " +
+                                 std::to_string(bits) + " bits supported by VVC " + to_string(key) + ".");
+      }
+    };
+
+    check("tid", meta.tid);
+    check("tdest", meta.tdest);
+    check("tuser", meta.tuser);
   }
 
   /////////////////////////////////////////////////////////////////////////////
@@ -121,7 +276,13 @@ namespace uvvm_cosim {
 
     vvcInstanceMap([&](auto &vvc_map) {
       if (vvc_map.find(vvc) == vvc_map.end()) {
-        vvc_map.emplace(vvc, VvcInstanceData{.cfg = cfg});
+        VvcInstanceData data{.cfg = cfg};
+
+        if (cfg.packet_based) {
+          data.queues.emplace<PacketQueuePair>();
+        }
+
+        vvc_map.emplace(vvc, std::move(data));
       } else {
         throw std::runtime_error("VVC " + to_string(vvc) + " exists already.");
       }
@@ -133,11 +294,14 @@ namespace uvvm_cosim {
     std::vector<VvcInstance> vec;
 
     vvcInstanceMap([&](auto &vvc_map) {
-      for (auto vvc : vvc_map) {
+      for (auto& vvc : vvc_map) {
         vec.push_back(VvcInstance(vvc.first, vvc.second.cfg));
       }
     });
 
+    // The registry keeps VVCs in the order they were added
+    std::sort(vec.begin(), vec.end(), VvcCompare());
+
     return vec;
   }
 
@@ -162,38 +326,367 @@ namespace uvvm_cosim {
     return listen;
   }
 
+  VvcHandle UvvmCosimData::ResolveVvc(VvcInstanceKey vvc) const
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return vvc_map.resolve(vvc);});
+  }
+
+  VvcInstanceKey UvvmCosimData::GetVvcKey(VvcHandle vvc) const
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return vvc_map.entry(vvc).first;});
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Receive sinks
+  /////////////////////////////////////////////////////////////////////////////
+
+  void UvvmCosimData::AttachReceiveSink(VvcInstanceKey vvc, const std::string& path,
+                                        ReceiveSink::Format format, uint16_t link_type)
+  {
+    auto check_vvc = [&](auto &vvc_map) -> VvcInstanceData& {
+      auto it = vvc_map.find(vvc);
+
+      if (it == vvc_map.end()) {
+        throw std::runtime_error("VVC " + to_string(vvc) + " does not exist.");
+      }
+
+      if (it->second.receive_sink) {
+        throw std::runtime_error("VVC " + to_string(vvc) + " has a receive sink attached already.");
+      }
+
+      return it->second;
+    };
+
+    bool packet_based = vvcInstanceMap([&](auto &vvc_map) {return check_vvc(vvc_map).cfg.packet_based;});
+
+    // Open the file and start the writer thread without holding the map lock
+    auto sink = std::make_shared<ReceiveSink>(path, format, packet_based, link_type);
+
+    vvcInstanceMap([&](auto &vvc_map) {check_vvc(vvc_map).receive_sink = std::move(sink);});
+  }
+
+  auto UvvmCosimData::DetachReceiveSink(VvcInstanceKey vvc) -> std::shared_ptr<ReceiveSink>
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {
+      auto it = vvc_map.find(vvc);
+
+      if (it == vvc_map.end()) {
+        throw std::runtime_error("VVC " + to_string(vvc) + " does not exist.");
+      }
+
+      if (!it->second.receive_sink) {
+        throw std::runtime_error("VVC " + to_string(vvc) + " has no receive sink attached.");
+      }
+
+      return std::move(it->second.receive_sink);
+    });
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // File transmit
+  /////////////////////////////////////////////////////////////////////////////
+
+  size_t UvvmCosimData::queue_put_file(QueueId qid, VvcInstanceKey vvc,
+                                       std::shared_ptr<const MappedFile> file, size_t packet_size)
+  {
+    size_t num_packets = vvcInstanceMap([&](auto &vvc_map) -> size_t {
+      VvcHandle handle = vvc_map.resolve(vvc);
+      auto& queues = vvc_map.entry(handle).second.queues;
+
+      if (auto byte_queues = std::get_if<ByteQueuePair>(&queues)) {
+        call_put_hook(vvc_map, qid, handle, file->data(), file->size(), false, false);
+        (*byte_queues)[qid].put(ByteSpan::from_file(file), now());
+        return 0;
+      }
+
+      size_t pkt_size = packet_size == 0 ? file->size() : packet_size;
+
+      for (size_t pos = 0; pos < file->size(); pos += pkt_size) {
+        call_put_hook(vvc_map, qid, handle, file->data() + pos,
+                      std::min(pkt_size, file->size() - pos), true, true);
+      }
+
+      PacketQueue& q = std::get<PacketQueuePair>(queues)[qid];
+      size_t size_before = q.size();
+      q.put_pkts(ByteSpan::from_file(file), packet_size, now());
+      return q.size() - size_before;
+    });
+
+    vvcInstanceMap.notify_all();
+
+    return num_packets;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Queue status for all VVCs
+  /////////////////////////////////////////////////////////////////////////////
+
+  auto UvvmCosimData::GetQueueStatus(bool reset_high_water) -> std::vector<VvcQueueStatus>
+  {
+    std::vector<VvcQueueStatus> vec;
+
+    vvcInstanceMap([&](auto &vvc_map) {
+      vec.reserve(vvc_map.size());
+
+      for (VvcHandle handle = 0; handle < vvc_map.size(); handle++) {
+        auto& [key, data] = vvc_map.entry(handle);
+
+        vec.push_back(VvcQueueStatus{
+          .vvc = key,
+          .packet_based = data.cfg.packet_based,
+          .queues = {queue_status(vvc_map, handle, QID_TRANSMIT, reset_high_water),
+                     queue_status(vvc_map, handle, QID_RECEIVE, reset_high_water)}
+        });
+      }
+    });
+
+    // Same order as GetVvcList
+    std::sort(vec.begin(), vec.end(), [](const VvcQueueStatus& a, const VvcQueueStatus& b) {
+      return VvcCompare()(a.vvc, b.vvc);
+    });
+
+    return vec;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Waiting on several queues
+  /////////////////////////////////////////////////////////////////////////////
+
+  auto UvvmCosimData::wait_for_any(const std::vector<VvcInstanceKey>& receive,
+                                   const std::vector<VvcInstanceKey>& transmit,
+                                   size_t transmit_threshold,
+                                   std::chrono::milliseconds timeout) -> std::vector<QueueReady>
+  {
+    std::vector<std::pair<VvcHandle, QueueId>> queues;
+
+    vvcInstanceMap([&](auto &vvc_map) {
+      for (const VvcInstanceKey& vvc : receive) {
+        queues.emplace_back(vvc_map.resolve(vvc), QID_RECEIVE);
+      }
+      for (const VvcInstanceKey& vvc : transmit) {
+        queues.emplace_back(vvc_map.resolve(vvc), QID_TRANSMIT);
+      }
+    });
+
+    std::vector<QueueReady> ready;
+
+    // Woken by the same notifications as byte_queue_wait_for_pattern, and
+    // by data being taken from transmit queues
+    auto check = [&](VvcMapInternal &vvc_map) {
+      for (auto [handle, qid] : queues) {
+        QueueStatus status = queue_status(vvc_map, handle, qid);
+        bool is_ready = qid == QID_RECEIVE ? status.bytes > 0 : status.bytes < transmit_threshold;
+
+        if (is_ready) {
+          ready.push_back(QueueReady{vvc_map.entry(handle).first, qid, status.bytes, status.packets});
+        }
+      }
+
+      return !ready.empty() || terminateSim.load();
+    };
+
+    vvcInstanceMap.wait_for(timeout, check);
+
+    return ready;
+  }
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Several VVCs in one call
+  /////////////////////////////////////////////////////////////////////////////
+
+  auto UvvmCosimData::queue_put_multi(QueueId qid, const std::vector<QueuePut>& entries) -> std::vector<bool>
+  {
+    std::vector<bool> packet_based;
+
+    vvcInstanceMap([&](auto &vvc_map) {
+      std::vector<VvcHandle> handles;
+
+      for (const QueuePut& entry : entries) {
+        VvcHandle handle = vvc_map.resolve(entry.vvc);
+        bool is_packet = vvc_map.entry(handle).second.cfg.packet_based;
+
+        if (!is_packet && entry.meta != PacketMeta{}) {
+          throw std::runtime_error("VVC " + to_string(entry.vvc) + " has no sideband signals.");
+        }
+
+        if (is_packet && qid == QID_TRANSMIT) {
+          check_packet_meta(vvc_map, handle, entry.meta);
+        }
+
+        handles.push_back(handle);
+        packet_based.push_back(is_packet);
+      }
+
+      // Only used for transmit queues, which never have a receive sink,
+      // so the returned sinks are always nullptr
+      for (size_t i = 0; i < entries.size(); i++) {
+        if (packet_based[i]) {
+          packet_queue_put_pkt(vvc_map, qid, handles[i], entries[i].data, entries[i].meta);
+        } else {
+          byte_queue_put(vvc_map, qid, handles[i], entries[i].data);
+        }
+      }
+    });
+
+    vvcInstanceMap.notify_all();
+
+    return packet_based;
+  }
+
+  auto UvvmCosimData::queue_get_multi(QueueId qid, const std::vector<QueueGet>& entries) -> std::vector<QueueGetResult>
+  {
+    std::vector<QueueGetResult> results;
+
+    vvcInstanceMap([&](auto &vvc_map) {
+      std::vector<VvcHandle> handles;
+
+      for (const QueueGet& entry : entries) {
+        handles.push_back(vvc_map.resolve(entry.vvc));
+      }
+
+      for (size_t i = 0; i < entries.size(); i++) {
+        QueueGetResult result{.packet_based = vvc_map.entry(handles[i]).second.cfg.packet_based};
+        size_t limit = entries[i].limit;
+
+        if (result.packet_based) {
+          PacketQueue& q = get_packet_queue(vvc_map, handles[i], qid);
+
+          while (!q.empty() && (limit == 0 || result.packets.size() < limit)) {
+            QueuedPacket pkt;
+            pkt.data = q.get_pkt(nullptr, &pkt.meta);
+            result.packets.push_back(std::move(pkt));
+          }
+        } else {
+          ByteQueue& q = get_byte_queue(vvc_map, handles[i], qid);
+          result.data = q.get(limit);
+        }
+
+        results.push_back(std::move(result));
+      }
+    });
+
+    notify_taken(qid);
+
+    return results;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Byte queue public functions
   /////////////////////////////////////////////////////////////////////////////
 
   bool UvvmCosimData::byte_queue_empty(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_empty(vvc_map, qid, vvc_map.resolve(vvc));});
+  }
+
+  bool UvvmCosimData::byte_queue_empty(QueueId qid, VvcHandle vvc)
   {
     return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_empty(vvc_map, qid, vvc);});
   }
 
+  int UvvmCosimData::byte_queue_poll(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {
+      VvcHandle handle = vvc_map.resolve(vvc);
+      return update_poll_state(vvc_map, handle, byte_queue_empty(vvc_map, qid, handle));
+    });
+  }
+
   size_t UvvmCosimData::byte_queue_size(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_size(vvc_map, qid, vvc_map.resolve(vvc));});
+  }
+
+  size_t UvvmCosimData::byte_queue_size(QueueId qid, VvcHandle vvc)
   {
     return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_size(vvc_map, qid, vvc);});
   }
 
   void UvvmCosimData::byte_queue_put(QueueId qid, VvcInstanceKey vvc, uint8_t byte)
   {
-    vvcInstanceMap([&](auto &vvc_map) {byte_queue_put(vvc_map, qid, vvc, byte);});
+    put_or_sink([&](auto &vvc_map) {return byte_queue_put(vvc_map, qid, vvc_map.resolve(vvc), byte);},
+                [&](ReceiveSink& sink) {return sink.put_byte(byte, false, simTimeNs);});
   }
 
   void UvvmCosimData::byte_queue_put(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& data)
   {
-    vvcInstanceMap([&](auto &vvc_map) {byte_queue_put(vvc_map, qid, vvc, data);});
+    put_or_sink([&](auto &vvc_map) {return byte_queue_put(vvc_map, qid, vvc_map.resolve(vvc), data);},
+                [&](ReceiveSink& sink) {return sink.put(data, false, simTimeNs);});
+  }
+
+  void UvvmCosimData::byte_queue_put(QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& data)
+  {
+    put_or_sink([&](auto &vvc_map) {return byte_queue_put(vvc_map, qid, vvc, data);},
+                [&](ReceiveSink& sink) {return sink.put(data, false, simTimeNs);});
   }
 
   auto UvvmCosimData::byte_queue_get(QueueId qid, VvcInstanceKey vvc) -> std::optional<uint8_t>
   {
-    return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_get(vvc_map, qid, vvc);});
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return byte_queue_get(vvc_map, qid, vvc_map.resolve(vvc));});
+    notify_taken(qid);
+    return result;
+  }
+
+  auto UvvmCosimData::byte_queue_get(QueueId qid, VvcInstanceKey vvc, int num_bytes,
+                                     std::vector<SimStampRun>* stamps) -> std::vector<uint8_t>
+  {
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return byte_queue_get(vvc_map, qid, vvc_map.resolve(vvc), num_bytes, stamps);});
+    notify_taken(qid);
+    return result;
   }
 
-  auto UvvmCosimData::byte_queue_get(QueueId qid, VvcInstanceKey vvc, int num_bytes) -> std::vector<uint8_t>
+  auto UvvmCosimData::byte_queue_get(QueueId qid, VvcHandle vvc, int num_bytes,
+                                     std::vector<SimStampRun>* stamps) -> std::vector<uint8_t>
   {
-    return vvcInstanceMap([&](auto &vvc_map) {return byte_queue_get(vvc_map, qid, vvc, num_bytes);});
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return byte_queue_get(vvc_map, qid, vvc, num_bytes, stamps);});
+    notify_taken(qid);
+    return result;
+  }
+
+  auto UvvmCosimData::byte_queue_wait_for_pattern(QueueId qid, VvcInstanceKey vvc,
+                                                  const std::vector<uint8_t>& pattern,
+                                                  std::chrono::milliseconds timeout,
+                                                  bool consume) -> std::optional<PatternMatch>
+  {
+    if (pattern.empty()) {
+      throw std::runtime_error("Empty pattern for VVC " + to_string(vvc) + ".");
+    }
+
+    std::optional<PatternMatch> match;
+
+    // Stream position (in bytes consumed + queued) up to which the queue
+    // was searched without a match. On each wakeup only the newly arrived
+    // bytes, plus an overlap of pattern size - 1, are searched again.
+    uint64_t searched_pos = 0;
+    const uint64_t overlap = pattern.size() - 1;
+
+    VvcHandle handle = ResolveVvc(vvc);
+
+    auto search = [&](VvcMapInternal &vvc_map) {
+      ByteQueue& q = get_byte_queue(vvc_map, handle, qid);
+      uint64_t front_pos = q.consumed_count();
+      size_t from = 0;
+
+      if (searched_pos > front_pos + overlap) {
+        from = searched_pos - overlap - front_pos;
+      }
+
+      if (auto offset = q.find(pattern, from); offset) {
+        match = PatternMatch{.length = offset.value() + pattern.size()};
+        if (consume) {
+          match->data = q.get(match->length);
+        }
+        return true;
+      }
+
+      searched_pos = front_pos + q.size();
+
+      return terminateSim.load();
+    };
+
+    vvcInstanceMap.wait_for(timeout, search);
+
+    return match;
   }
 
 
@@ -201,33 +694,94 @@ namespace uvvm_cosim {
   // Packet queue public functions
   /////////////////////////////////////////////////////////////////////////////
   bool UvvmCosimData::packet_queue_empty(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_empty(vvc_map, qid, vvc_map.resolve(vvc));});
+  }
+
+  bool UvvmCosimData::packet_queue_empty(QueueId qid, VvcHandle vvc)
   {
     return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_empty(vvc_map, qid, vvc);});
   }
 
+  int UvvmCosimData::packet_queue_poll(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {
+      VvcHandle handle = vvc_map.resolve(vvc);
+      return update_poll_state(vvc_map, handle, packet_queue_empty(vvc_map, qid, handle));
+    });
+  }
+
   size_t UvvmCosimData::packet_queue_size(QueueId qid, VvcInstanceKey vvc)
   {
-    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_size(vvc_map, qid, vvc);});
+    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_size(vvc_map, qid, vvc_map.resolve(vvc));});
   }
 
   auto UvvmCosimData::packet_queue_get_byte(QueueId qid, VvcInstanceKey vvc) -> std::optional<std::pair<uint8_t, bool>>
   {
-    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_byte(vvc_map, qid, vvc);});
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_byte(vvc_map, qid, vvc_map.resolve(vvc));});
+    notify_taken(qid);
+    return result;
+  }
+
+  auto UvvmCosimData::packet_queue_get_bytes(QueueId qid, VvcInstanceKey vvc,
+                                             size_t max_bytes, bool& eop) -> std::vector<uint8_t>
+  {
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_bytes(vvc_map, qid, vvc_map.resolve(vvc), max_bytes, eop);});
+    notify_taken(qid);
+    return result;
   }
 
-  auto UvvmCosimData::packet_queue_get_pkt(QueueId qid, VvcInstanceKey vvc) -> std::vector<uint8_t>
+  auto UvvmCosimData::packet_queue_get_pkt(QueueId qid, VvcInstanceKey vvc,
+                                           PacketStamp* stamp, PacketMeta* meta) -> std::vector<uint8_t>
   {
-    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_pkt(vvc_map, qid, vvc);});
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_pkt(vvc_map, qid, vvc_map.resolve(vvc), stamp, meta);});
+    notify_taken(qid);
+    return result;
+  }
+
+  auto UvvmCosimData::packet_queue_get_pkt(QueueId qid, VvcHandle vvc,
+                                           PacketStamp* stamp, PacketMeta* meta) -> std::vector<uint8_t>
+  {
+    auto result = vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_pkt(vvc_map, qid, vvc, stamp, meta);});
+    notify_taken(qid);
+    return result;
+  }
+
+  PacketMeta UvvmCosimData::packet_queue_get_meta(QueueId qid, VvcInstanceKey vvc)
+  {
+    return vvcInstanceMap([&](auto &vvc_map) {return packet_queue_get_meta(vvc_map, qid, vvc_map.resolve(vvc));});
+  }
+
+  void UvvmCosimData::packet_queue_put_meta(QueueId qid, VvcInstanceKey vvc, PacketMeta meta)
+  {
+    vvcInstanceMap([&](auto &vvc_map) {packet_queue_put_meta(vvc_map, qid, vvc_map.resolve(vvc), meta);});
   }
 
   void UvvmCosimData::packet_queue_put_byte(QueueId qid, VvcInstanceKey vvc, uint8_t byte, bool eop)
   {
-    vvcInstanceMap([&](auto &vvc_map) {packet_queue_put_byte(vvc_map, qid, vvc, byte, eop);});
+    put_or_sink([&](auto &vvc_map) {return packet_queue_put_byte(vvc_map, qid, vvc_map.resolve(vvc), byte, eop);},
+                [&](ReceiveSink& sink) {return sink.put_byte(byte, eop, simTimeNs);});
+  }
+
+  void UvvmCosimData::packet_queue_put_bytes(QueueId qid, VvcInstanceKey vvc,
+                                             const std::vector<uint8_t>& data, bool eop)
+  {
+    put_or_sink([&](auto &vvc_map) {return packet_queue_put_bytes(vvc_map, qid, vvc_map.resolve(vvc), data, eop);},
+                [&](ReceiveSink& sink) {return sink.put(data, eop, simTimeNs);});
+  }
+
+  void UvvmCosimData::packet_queue_put_pkt(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt,
+                                           PacketMeta meta)
+  {
+    put_or_sink([&](auto &vvc_map) {return packet_queue_put_pkt(vvc_map, qid, vvc_map.resolve(vvc), pkt, meta);},
+                [&](ReceiveSink& sink) {return sink.put(pkt, true, simTimeNs);});
   }
 
-  void UvvmCosimData::packet_queue_put_pkt(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt)
+  void UvvmCosimData::packet_queue_put_pkt(QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& pkt,
+                                           PacketMeta meta)
   {
-    vvcInstanceMap([&](auto &vvc_map) {packet_queue_put_pkt(vvc_map, qid, vvc, pkt);});
+    put_or_sink([&](auto &vvc_map) {return packet_queue_put_pkt(vvc_map, qid, vvc, pkt, meta);},
+                [&](ReceiveSink& sink) {return sink.put(pkt, true, simTimeNs);});
   }
 
 } // namespace uvvm_cosim
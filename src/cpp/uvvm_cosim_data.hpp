@@ -1,20 +1,102 @@
 #pragma once
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <functional>
 #include <map>
+#include <memory>
+#include <optional>
 #include <stdexcept>
 #include <string>
 #include <utility>
 #include <vector>
+#include "lock_stats.hpp"
+#include "mapped_file.hpp"
+#include "receive_sink.hpp"
 #include "shared_map.hpp"
+#include "sim_stamp.hpp"
 #include "uvvm_cosim_types.hpp"
+#include "vvc_registry.hpp"
 
 namespace uvvm_cosim {
 
 // VvcInstanceKey: Identifies VVC by type, channel, id
 // VvcInstanceData: Transmit+receive queue for VVC, config, etc.
-// VvcCompare: Comparator class for VvcInstanceKey
-using VvcMap = shared_map<VvcInstanceKey, VvcInstanceData, VvcCompare>;
-using VvcMapInternal = std::map<VvcInstanceKey, VvcInstanceData, VvcCompare>;
+// VvcHandle: Numeric ID a VvcInstanceKey resolves to
+using VvcMapInternal = VvcRegistry<VvcInstanceData>;
+using VvcMap = shared_map<VvcMapInternal, InstrumentedMutex>;
+
+// Result of a successful byte_queue_wait_for_pattern call.
+// length: Number of bytes up to and including the end of the match.
+// data:   The bytes that were consumed from the queue (empty if the
+//         queue was only searched).
+struct PatternMatch {
+  size_t length;
+  std::vector<uint8_t> data;
+};
+
+// Fill level of a queue.
+// bytes:   Number of bytes in the queue.
+// packets: Number of complete packets in the queue (zero for byte queues).
+// high_water_*: Largest bytes/packets since the VVC was added or the
+//               marks were reset.
+struct QueueStatus {
+  size_t bytes;
+  size_t packets;
+  size_t high_water_bytes;
+  size_t high_water_packets;
+};
+
+// Queue that was ready in a wait_for_any call
+struct QueueReady {
+  VvcInstanceKey vvc;
+  QueueId qid;
+  size_t bytes;
+  size_t packets;
+};
+
+// Data to put in the queue of one VVC in a queue_put_multi call. The
+// data is put as bytes or as one packet depending on the VVC. meta must
+// be zero for byte-based VVCs.
+struct QueuePut {
+  VvcInstanceKey vvc;
+  std::vector<uint8_t> data;
+  PacketMeta meta;
+};
+
+// Queue of one VVC to get data from in a queue_get_multi call.
+// limit: Maximum number of bytes, or packets for packet-based VVCs.
+//        Zero gets everything in the queue.
+struct QueueGet {
+  VvcInstanceKey vvc;
+  size_t limit;
+};
+
+struct QueuedPacket {
+  std::vector<uint8_t> data;
+  PacketMeta meta;
+};
+
+// Data taken from the queue of one VVC in a queue_get_multi call. Only
+// one of data and packets is used, depending on packet_based.
+struct QueueGetResult {
+  bool packet_based;
+  std::vector<uint8_t> data;
+  std::vector<QueuedPacket> packets;
+};
+
+// Status of both queues of a VVC, indexed by QueueId
+struct VvcQueueStatus {
+  VvcInstanceKey vvc;
+  bool packet_based;
+  std::array<QueueStatus, QID_MAX> queues;
+};
+
+// Called with the map locked for all data put in a queue or receive
+// sink, with the sim time the data is stamped with. Used to record the
+// traffic in the same order as it is seen by the simulator.
+using PutHook = std::function<void(QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+                                   const uint8_t* data, size_t size, bool packet, bool eop)>;
 
 class UvvmCosimData {
 private:
@@ -23,45 +105,120 @@ private:
   std::atomic<bool> startSim = false;
   std::atomic<bool> terminateSim = false;
 
+  // Simulation time and number of cosim clock cycles as last reported
+  // by the simulator. Data put in the queues is stamped with these.
+  std::atomic<uint64_t> simTimeNs = 0;
+  std::atomic<uint64_t> simCycles = 0;
+
+  SimStamp now() const {
+    return SimStamp{simTimeNs, simCycles};
+  }
+
+  // Protected by the map lock
+  PollConfig pollConfig;
+  PutHook putHook;
+
 private:
 
+  // The private functions take a VVC that has been resolved to its
+  // handle already, so each public function looks up the VVC only once.
+
+  // Returns the receive sink attached to the VVC for qid, or nullptr if
+  // data for qid should be put in the queue
+  auto get_receive_sink(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid) -> std::shared_ptr<ReceiveSink>;
+
+  void call_put_hook(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                     const uint8_t* data, size_t size, bool packet, bool eop);
+
+  // The private put functions don't write to receive sinks, since the
+  // simulator thread can block in a sink while the writer catches up.
+  // Instead they return the sink the data should go to, and put_or_sink
+  // writes it after the map lock is released. If the sink was detached
+  // in the meantime, the data is put in the queue instead.
+  template <typename Put, typename SinkPut>
+  void put_or_sink(Put put, SinkPut sink_put)
+  {
+    while (true) {
+      std::shared_ptr<ReceiveSink> sink = vvcInstanceMap(put);
+      vvcInstanceMap.notify_all();
+
+      if (!sink || sink_put(*sink)) {
+        return;
+      }
+    }
+  }
+
+  // Status of a queue of either kind, optionally resetting its high-water marks
+  QueueStatus queue_status(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid,
+                           bool reset_high_water = false);
+
+  // Wake up wait_for_any calls waiting for a transmit queue to drain,
+  // after data was taken from the qid queue
+  void notify_taken(QueueId qid) {
+    if (qid == QID_TRANSMIT) {
+      vvcInstanceMap.notify_all();
+    }
+  }
+
+  // Update the poll state of the VVC with the result of an empty check, and
+  // return the number of cycles to wait before the next poll (0 if not empty)
+  int update_poll_state(VvcMapInternal& vvc_map, VvcHandle vvc, bool empty);
+
   /////////////////////////////////////////////////////////////////////////////
   // Byte queue private functions
   /////////////////////////////////////////////////////////////////////////////
 
-  auto get_byte_queue(VvcMapInternal& vvc_map, VvcInstanceKey vvc, QueueId qid) -> ByteQueue&;
+  auto get_byte_queue(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid) -> ByteQueue&;
 
-  bool byte_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc);
+  bool byte_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc);
 
-  size_t byte_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc);
+  size_t byte_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc);
 
-  void byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, uint8_t byte);
+  auto byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, uint8_t byte)
+    -> std::shared_ptr<ReceiveSink>;
 
-  void byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc,
-                      const std::vector<uint8_t>& data);
+  auto byte_queue_put(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                      const std::vector<uint8_t>& data) -> std::shared_ptr<ReceiveSink>;
 
-  auto byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::optional<uint8_t>;
+  auto byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc) -> std::optional<uint8_t>;
 
-  auto byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, int num_bytes) -> std::vector<uint8_t>;
+  auto byte_queue_get(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, int num_bytes,
+                      std::vector<SimStampRun>* stamps) -> std::vector<uint8_t>;
 
 
   /////////////////////////////////////////////////////////////////////////////
   // Packet queue private functions
   /////////////////////////////////////////////////////////////////////////////
 
-  auto get_packet_queue(VvcMapInternal& vvc_map, VvcInstanceKey vvc, QueueId qid) -> PacketQueue&;
+  auto get_packet_queue(VvcMapInternal& vvc_map, VvcHandle vvc, QueueId qid) -> PacketQueue&;
+
+  bool packet_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc);
+
+  size_t packet_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc);
 
-  bool packet_queue_empty(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc);
+  auto packet_queue_get_byte(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc) -> std::optional<std::pair<uint8_t, bool>>;
 
-  size_t packet_queue_size(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc);
+  auto packet_queue_get_bytes(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                             size_t max_bytes, bool& eop) -> std::vector<uint8_t>;
 
-  auto packet_queue_get_byte(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::optional<std::pair<uint8_t, bool>>;
+  auto packet_queue_get_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                            PacketStamp* stamp, PacketMeta* meta) -> std::vector<uint8_t>;
 
-  auto packet_queue_get_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc) -> std::vector<uint8_t>;
+  PacketMeta packet_queue_get_meta(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc);
 
-  void packet_queue_put_byte(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, uint8_t byte, bool eop);
+  void packet_queue_put_meta(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, PacketMeta meta);
 
-  void packet_queue_put_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt);
+  auto packet_queue_put_byte(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, uint8_t byte, bool eop)
+    -> std::shared_ptr<ReceiveSink>;
+
+  auto packet_queue_put_bytes(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc,
+                              const std::vector<uint8_t>& data, bool eop) -> std::shared_ptr<ReceiveSink>;
+
+  auto packet_queue_put_pkt(VvcMapInternal& vvc_map, QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& pkt,
+                            PacketMeta meta) -> std::shared_ptr<ReceiveSink>;
+
+  // Throws if a sideband signal of meta is wider than the VVC supports
+  void check_packet_meta(VvcMapInternal& vvc_map, VvcHandle vvc, PacketMeta meta);
 
 public:
   UvvmCosimData() {}
@@ -81,13 +238,50 @@ public:
   }
 
   void setTerminateSim(bool value) {
-    terminateSim = value;
+    // Set with the map locked and wake up any waiting threads,
+    // so they don't block for the remainder of their timeout
+    vvcInstanceMap([&](auto&) { terminateSim = value; });
+    vvcInstanceMap.notify_all();
   }
 
   bool getTerminateSim() const {
     return terminateSim;
   }
 
+  void setSimTime(uint64_t sim_time_ns, uint64_t cycles) {
+    simTimeNs = sim_time_ns;
+    simCycles = cycles;
+  }
+
+  uint64_t getSimTime() const {
+    return simTimeNs;
+  }
+
+  uint64_t getSimCycles() const {
+    return simCycles;
+  }
+
+  void setPollConfig(PollConfig cfg) {
+    vvcInstanceMap([&](auto&) { pollConfig = cfg; });
+  }
+
+  void setPutHook(PutHook hook) {
+    vvcInstanceMap([&](auto&) { putHook = std::move(hook); });
+  }
+
+  // Record wait and hold times of the VVC map lock per LockOp
+  void setLockStats(bool enable) {
+    vvcInstanceMap.mutex().set_enabled(enable);
+  }
+
+  bool getLockStats() const {
+    return vvcInstanceMap.mutex().is_enabled();
+  }
+
+  LockStatsReport GetLockStatsReport(bool reset) {
+    return vvcInstanceMap.mutex().report(reset);
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // VVC list public functions
   /////////////////////////////////////////////////////////////////////////////
@@ -100,21 +294,112 @@ public:
 
   bool GetVvcListenEnable(VvcInstanceKey vvc) const;
 
+  // Look up the handle of a VVC, which can be used in place of the key
+  // with the handle overloads below to skip the lookup
+  VvcHandle ResolveVvc(VvcInstanceKey vvc) const;
+
+  VvcInstanceKey GetVvcKey(VvcHandle vvc) const;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Receive sinks
+  /////////////////////////////////////////////////////////////////////////////
+
+  // Write data received by the VVC to a file instead of the receive queue.
+  // Data that is in the receive queue already stays there.
+  void AttachReceiveSink(VvcInstanceKey vvc, const std::string& path,
+                         ReceiveSink::Format format, uint16_t link_type);
+
+  // Detach the sink from the VVC, and return it so the caller can get its
+  // stats. The file is flushed and closed when the sink is destroyed.
+  auto DetachReceiveSink(VvcInstanceKey vvc) -> std::shared_ptr<ReceiveSink>;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // File transmit
+  /////////////////////////////////////////////////////////////////////////////
+
+  // Queue the contents of a mapped file on the byte or packet queue of a
+  // VVC, depending on the VVC type. The data is copied from the mapping as
+  // it is consumed. For packet-based VVCs the data is split into packets
+  // of packet_size bytes (zero for a single packet), and the number of
+  // packets queued is returned. Returns zero for byte-based VVCs.
+  size_t queue_put_file(QueueId qid, VvcInstanceKey vvc,
+                        std::shared_ptr<const MappedFile> file, size_t packet_size);
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Queue status for all VVCs
+  /////////////////////////////////////////////////////////////////////////////
+
+  // Fill levels of the transmit and receive queues of every VVC, taken
+  // in one pass with the map locked. If reset_high_water is true the
+  // high-water marks restart from the current levels after being read.
+  auto GetQueueStatus(bool reset_high_water) -> std::vector<VvcQueueStatus>;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Waiting on several queues
+  /////////////////////////////////////////////////////////////////////////////
+
+  // Block until any of the receive VVCs has data in its receive queue,
+  // any of the transmit VVCs has fewer than transmit_threshold bytes in
+  // its transmit queue, timeout expires or the simulation is terminated.
+  // Returns all queues that are ready, or nothing on timeout.
+  auto wait_for_any(const std::vector<VvcInstanceKey>& receive,
+                    const std::vector<VvcInstanceKey>& transmit,
+                    size_t transmit_threshold,
+                    std::chrono::milliseconds timeout) -> std::vector<QueueReady>;
+
+  /////////////////////////////////////////////////////////////////////////////
+  // Several VVCs in one call
+  /////////////////////////////////////////////////////////////////////////////
+
+  // Put data in the qid queue of several VVCs with the map locked once,
+  // in the order of the entries. All VVCs are checked before anything is
+  // put, so nothing is put if an entry is invalid. Returns whether each
+  // VVC is packet-based.
+  auto queue_put_multi(QueueId qid, const std::vector<QueuePut>& entries) -> std::vector<bool>;
+
+  // Get data from the qid queue of several VVCs with the map locked once,
+  // in the order of the entries. Returns one result per entry.
+  auto queue_get_multi(QueueId qid, const std::vector<QueueGet>& entries) -> std::vector<QueueGetResult>;
+
   /////////////////////////////////////////////////////////////////////////////
   // Byte queue public functions
   /////////////////////////////////////////////////////////////////////////////
 
   bool byte_queue_empty(QueueId qid, VvcInstanceKey vvc);
 
+  bool byte_queue_empty(QueueId qid, VvcHandle vvc);
+
+  // Empty check used by the VVC controllers to poll a queue. Returns 0 if
+  // the queue has data, otherwise the number of cycles the controller
+  // should wait before it polls again (see PollConfig).
+  int byte_queue_poll(QueueId qid, VvcInstanceKey vvc);
+
   size_t byte_queue_size(QueueId qid, VvcInstanceKey vvc);
 
+  size_t byte_queue_size(QueueId qid, VvcHandle vvc);
+
   void byte_queue_put(QueueId qid, VvcInstanceKey vvc, uint8_t byte);
 
   void byte_queue_put(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& data);
 
+  void byte_queue_put(QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& data);
+
   auto byte_queue_get(QueueId qid, VvcInstanceKey vvc) -> std::optional<uint8_t>;
 
-  auto byte_queue_get(QueueId qid, VvcInstanceKey vvc, int num_bytes) -> std::vector<uint8_t>;
+  // If stamps is given, the stamps of the returned bytes are appended to it
+  auto byte_queue_get(QueueId qid, VvcInstanceKey vvc, int num_bytes,
+                      std::vector<SimStampRun>* stamps = nullptr) -> std::vector<uint8_t>;
+
+  auto byte_queue_get(QueueId qid, VvcHandle vvc, int num_bytes,
+                      std::vector<SimStampRun>* stamps = nullptr) -> std::vector<uint8_t>;
+
+  // Block until pattern appears in the byte queue, timeout expires or
+  // the simulation is terminated. If consume is true, the bytes up to and
+  // including the match are removed from the queue and returned.
+  auto byte_queue_wait_for_pattern(QueueId qid, VvcInstanceKey vvc,
+                                   const std::vector<uint8_t>& pattern,
+                                   std::chrono::milliseconds timeout,
+                                   bool consume) -> std::optional<PatternMatch>;
 
 
   /////////////////////////////////////////////////////////////////////////////
@@ -122,15 +407,50 @@ public:
   /////////////////////////////////////////////////////////////////////////////
   bool packet_queue_empty(QueueId qid, VvcInstanceKey vvc);
 
+  bool packet_queue_empty(QueueId qid, VvcHandle vvc);
+
+  // Same as byte_queue_poll, for packet queues
+  int packet_queue_poll(QueueId qid, VvcInstanceKey vvc);
+
   size_t packet_queue_size(QueueId qid, VvcInstanceKey vvc);
 
   auto packet_queue_get_byte(QueueId qid, VvcInstanceKey vvc) -> std::optional<std::pair<uint8_t, bool>>;
 
-  auto packet_queue_get_pkt(QueueId qid, VvcInstanceKey vvc) -> std::vector<uint8_t>;
+  // Get up to max_bytes of the next packet, without crossing into the
+  // packet after it. eop is set if the end of the packet was reached.
+  auto packet_queue_get_bytes(QueueId qid, VvcInstanceKey vvc,
+                              size_t max_bytes, bool& eop) -> std::vector<uint8_t>;
+
+  // If stamp or meta is given, it's set to the stamps or sideband
+  // signals of the returned packet
+  auto packet_queue_get_pkt(QueueId qid, VvcInstanceKey vvc,
+                            PacketStamp* stamp = nullptr,
+                            PacketMeta* meta = nullptr) -> std::vector<uint8_t>;
+
+  auto packet_queue_get_pkt(QueueId qid, VvcHandle vvc,
+                            PacketStamp* stamp = nullptr,
+                            PacketMeta* meta = nullptr) -> std::vector<uint8_t>;
+
+  // Sideband signals of the packet currently read with
+  // packet_queue_get_byte/packet_queue_get_bytes
+  PacketMeta packet_queue_get_meta(QueueId qid, VvcInstanceKey vvc);
+
+  // Set the sideband signals of the packet currently put with
+  // packet_queue_put_byte/packet_queue_put_bytes. Ignored while a
+  // receive sink is attached.
+  void packet_queue_put_meta(QueueId qid, VvcInstanceKey vvc, PacketMeta meta);
 
   void packet_queue_put_byte(QueueId qid, VvcInstanceKey vvc, uint8_t byte, bool eop);
 
-  void packet_queue_put_pkt(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt);
+  // Same as packet_queue_put_byte for several bytes of a packet at a time
+  void packet_queue_put_bytes(QueueId qid, VvcInstanceKey vvc,
+                              const std::vector<uint8_t>& data, bool eop);
+
+  void packet_queue_put_pkt(QueueId qid, VvcInstanceKey vvc, const std::vector<uint8_t>& pkt,
+                           PacketMeta meta = {});
+
+  void packet_queue_put_pkt(QueueId qid, VvcHandle vvc, const std::vector<uint8_t>& pkt,
+                           PacketMeta meta = {});
 };
 
 } // namespace uvvm_cosim
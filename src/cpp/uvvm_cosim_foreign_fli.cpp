@@ -1,25 +1,92 @@
+#include <algorithm>
 #include <string>
 #include <cstdint>
+#include <unordered_map>
+#include <vector>
 #include <mti.h>
 #include "uvvm_cosim_common.hpp"
 
 // Convert VHDL string array to std::string
 // Based on function from Modelsim/Questasim FLI example four
-static std::string get_string(mtiVariableIdT id)
+//
+// The last value read from each variable is cached, and the returned
+// string is a reference to it. The value is still read on every call, but
+// into a reused buffer, and the cached string is only assigned when the
+// value changed. Repeated calls with the same VVC type don't allocate.
+static const std::string& get_string(mtiVariableIdT id)
 {
-  char*       buf;
-  int         len;
-  mtiTypeIdT  type;
+  // Foreign subprograms are only called from the simulator thread
+  static std::unordered_map<mtiVariableIdT, std::string> cache;
+  static std::vector<char> buf;
 
-  type = mti_GetVarType(id);
-  len  = mti_TickLength(type);
-  buf  = new char[len+1];
-  mti_GetArrayVarValue(id, buf);
+  // Bound the cache in case the simulator passes a new variable id
+  // for every call
+  constexpr size_t C_MAX_CACHED_STRINGS = 1024;
+
+  int len = mti_TickLength(mti_GetVarType(id));
+
+  if (buf.size() < static_cast<size_t>(len) + 1) {
+    buf.resize(len + 1);
+  }
+
+  mti_GetArrayVarValue(id, buf.data());
   buf[len] = 0;
 
-  std::string s(buf);
-  delete buf;
-  return s;
+  auto it = cache.find(id);
+
+  if (it == cache.end()) {
+    if (cache.size() >= C_MAX_CACHED_STRINGS) {
+      cache.clear();
+    }
+    it = cache.emplace(id, std::string()).first;
+  }
+
+  if (it->second != buf.data()) {
+    it->second.assign(buf.data(), len);
+  }
+
+  return it->second;
+}
+
+static int get_length(mtiVariableIdT id)
+{
+  return mti_TickLength(mti_GetVarType(id));
+}
+
+// Convert VHDL integer_vector to a vector of T (for example uint8_t for
+// one byte per element)
+template <typename T>
+static std::vector<T> get_int_vector(mtiVariableIdT id)
+{
+  std::vector<mtiInt32T> buf(get_length(id));
+  mti_GetArrayVarValue(id, buf.data());
+
+  return std::vector<T>(buf.begin(), buf.end());
+}
+
+// Write to VHDL integer_vector. Elements beyond the end of data are set
+// to zero.
+template <typename T>
+static void set_int_vector(mtiVariableIdT id, const std::vector<T>& data)
+{
+  std::vector<mtiInt32T> buf(get_length(id), 0);
+  std::copy_n(data.begin(), std::min(data.size(), buf.size()), buf.begin());
+
+  // Array values are passed by reference
+  mti_SetVarValue(id, (long)buf.data());
+}
+
+// Current simulation time in ns. mti_Now/mti_NowUpper return the time in
+// units of the simulator resolution, which is given as a power of 10.
+static uint64_t get_sim_time_ns(void)
+{
+  uint64_t t = ((uint64_t)(mtiUInt32T) mti_NowUpper() << 32) | (mtiUInt32T) mti_Now();
+
+  for (int res = mti_GetResolutionLimit(); res != -9; res += (res < -9 ? 1 : -1)) {
+    t = res < -9 ? t / 10 : t * 10;
+  }
+
+  return t;
 }
 
 
@@ -27,7 +94,7 @@ extern "C" {
 
 void uvvm_cosim_foreign_start_sim(void)
 {
-  uvvm_cosim::start_sim();
+  uvvm_cosim::start_sim(get_sim_time_ns());
 }
 
 int uvvm_cosim_foreign_terminate_sim(void)
@@ -40,6 +107,7 @@ void uvvm_cosim_foreign_report_vvc_info(mtiVariableIdT vvc_type,
 					int            vvc_instance_id,
 					mtiVariableIdT bfm_cfg)
 {
+  // Copies, since the cache may be cleared by the next get_string
   std::string vvc_type_str    = get_string(vvc_type);
   std::string vvc_channel_str = get_string(vvc_channel);
   std::string bfm_cfg_str     = get_string(bfm_cfg);
@@ -50,42 +118,42 @@ void uvvm_cosim_foreign_report_vvc_info(mtiVariableIdT vvc_type,
 int uvvm_cosim_foreign_vvc_listen_enable(mtiVariableIdT vvc_type,
 					 int            vvc_instance_id)
 {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
   return uvvm_cosim::vvc_listen_enable(vvc_type_str, vvc_instance_id) ? 1 : 0;
 }
 
 int uvvm_cosim_foreign_transmit_byte_queue_empty(mtiVariableIdT vvc_type,
                                                  int vvc_instance_id) {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
-  return uvvm_cosim::transmit_byte_queue_empty(vvc_type_str, vvc_instance_id) ? 1 : 0;
+  return uvvm_cosim::transmit_byte_queue_empty(vvc_type_str, vvc_instance_id);
 }
 
 int uvvm_cosim_foreign_transmit_byte_queue_get(mtiVariableIdT vvc_type,
                                                int vvc_instance_id) {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
   return uvvm_cosim::transmit_byte_queue_get(vvc_type_str, vvc_instance_id);
 }
 
 void uvvm_cosim_foreign_receive_byte_queue_put(mtiVariableIdT vvc_type,
                                                int vvc_instance_id, int byte) {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
   uvvm_cosim::receive_byte_queue_put(vvc_type_str, vvc_instance_id, byte);
 }
 
 int uvvm_cosim_foreign_transmit_packet_queue_empty(mtiVariableIdT vvc_type,
                                                  int vvc_instance_id) {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
-  return uvvm_cosim::transmit_packet_queue_empty(vvc_type_str, vvc_instance_id) ? 1 : 0;
+  return uvvm_cosim::transmit_packet_queue_empty(vvc_type_str, vvc_instance_id);
 }
 
 int uvvm_cosim_foreign_transmit_packet_queue_get(mtiVariableIdT vvc_type,
 						 int vvc_instance_id) {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
 
   return uvvm_cosim::transmit_packet_queue_get(vvc_type_str, vvc_instance_id);
 }
@@ -94,11 +162,80 @@ void uvvm_cosim_foreign_receive_packet_queue_put(mtiVariableIdT vvc_type,
 						 int vvc_instance_id,
 						 int byte, int end_of_packet)
 {
-  std::string vvc_type_str = get_string(vvc_type);
+  const std::string& vvc_type_str = get_string(vvc_type);
   bool eop = end_of_packet == 1 ? true : false;
   uvvm_cosim::receive_packet_queue_put(vvc_type_str, vvc_instance_id, byte, eop);
 }
 
+// Scalar out parameters are passed as pointers
+
+void uvvm_cosim_foreign_transmit_byte_queue_get_beat(mtiVariableIdT vvc_type,
+						     int vvc_instance_id,
+						     mtiVariableIdT data,
+						     int* num_bytes)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+
+  auto beat = uvvm_cosim::transmit_byte_queue_get_beat(vvc_type_str, vvc_instance_id,
+						       get_length(data));
+  set_int_vector(data, beat);
+  *num_bytes = beat.size();
+}
+
+void uvvm_cosim_foreign_receive_byte_queue_put_beat(mtiVariableIdT vvc_type,
+						    int vvc_instance_id,
+						    mtiVariableIdT data)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+
+  uvvm_cosim::receive_byte_queue_put_beat(vvc_type_str, vvc_instance_id, get_int_vector<uint8_t>(data));
+}
+
+void uvvm_cosim_foreign_transmit_packet_queue_get_beat(mtiVariableIdT vvc_type,
+						       int vvc_instance_id,
+						       mtiVariableIdT data,
+						       int* num_bytes,
+						       int* end_of_packet)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+  bool eop = false;
+
+  auto beat = uvvm_cosim::transmit_packet_queue_get_beat(vvc_type_str, vvc_instance_id,
+							 get_length(data), eop);
+  set_int_vector(data, beat);
+  *num_bytes = beat.size();
+  *end_of_packet = eop ? 1 : 0;
+}
+
+void uvvm_cosim_foreign_receive_packet_queue_put_beat(mtiVariableIdT vvc_type,
+						      int vvc_instance_id,
+						      mtiVariableIdT data,
+						      int end_of_packet)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+  bool eop = end_of_packet == 1 ? true : false;
+
+  uvvm_cosim::receive_packet_queue_put_beat(vvc_type_str, vvc_instance_id, get_int_vector<uint8_t>(data), eop);
+}
+
+void uvvm_cosim_foreign_transmit_packet_queue_get_meta(mtiVariableIdT vvc_type,
+						       int vvc_instance_id,
+						       mtiVariableIdT meta)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+
+  set_int_vector(meta, uvvm_cosim::transmit_packet_queue_get_meta(vvc_type_str, vvc_instance_id));
+}
+
+void uvvm_cosim_foreign_receive_packet_queue_put_meta(mtiVariableIdT vvc_type,
+						      int vvc_instance_id,
+						      mtiVariableIdT meta)
+{
+  const std::string& vvc_type_str = get_string(vvc_type);
+
+  uvvm_cosim::receive_packet_queue_put_meta(vvc_type_str, vvc_instance_id, get_int_vector<int>(meta));
+}
+
 static void start_of_sim_cb(void* p)
 {
   uvvm_cosim::start_of_sim();
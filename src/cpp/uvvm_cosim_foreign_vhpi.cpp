@@ -37,7 +37,11 @@ static void end_of_sim_cb(const vhpiCbDataT * cb_data) {
 
 static void uvvm_cosim_foreign_start_sim(const vhpiCbDataT* p_cb_data)
 {
-  uvvm_cosim::start_sim();
+  vhpiTimeT t;
+
+  vhpi_get_time(&t, NULL);
+
+  uvvm_cosim::start_sim(convert_time_to_ns(&t));
 }
 
 static void uvvm_cosim_foreign_terminate_sim(const vhpiCbDataT* p_cb_data)
@@ -49,18 +53,18 @@ static void uvvm_cosim_foreign_terminate_sim(const vhpiCbDataT* p_cb_data)
 
 static void uvvm_cosim_foreign_transmit_byte_queue_empty(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
 
-  bool empty = uvvm_cosim::transmit_byte_queue_empty(vvc_type, vvc_instance_id);
+  int poll_cycles = uvvm_cosim::transmit_byte_queue_empty(vvc_type, vvc_instance_id);
 
-  return_vhpi_int(p_cb_data, empty ? 1 : 0);
+  return_vhpi_int(p_cb_data, poll_cycles);
 }
 
 static void uvvm_cosim_foreign_transmit_byte_queue_get(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
 
   int data = uvvm_cosim::transmit_byte_queue_get(vvc_type, vvc_instance_id);
 
@@ -69,27 +73,27 @@ static void uvvm_cosim_foreign_transmit_byte_queue_get(const vhpiCbDataT* p_cb_d
 
 static void uvvm_cosim_foreign_receive_byte_queue_put(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
-  uint8_t byte         = get_vhpi_int_param_by_index(p_cb_data, 2);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  uint8_t byte                = get_vhpi_int_param_by_index(p_cb_data, 2);
 
   uvvm_cosim::receive_byte_queue_put(vvc_type, vvc_instance_id, byte);
 }
 
 static void uvvm_cosim_foreign_transmit_packet_queue_empty(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
 
-  bool empty = uvvm_cosim::transmit_packet_queue_empty(vvc_type, vvc_instance_id);
+  int poll_cycles = uvvm_cosim::transmit_packet_queue_empty(vvc_type, vvc_instance_id);
 
-  return_vhpi_int(p_cb_data, empty ? 1 : 0);
+  return_vhpi_int(p_cb_data, poll_cycles);
 }
 
 static void uvvm_cosim_foreign_transmit_packet_queue_get(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
 
   int byte_and_eop = uvvm_cosim::transmit_packet_queue_get(vvc_type, vvc_instance_id);
 
@@ -98,19 +102,84 @@ static void uvvm_cosim_foreign_transmit_packet_queue_get(const vhpiCbDataT* p_cb
 
 static void uvvm_cosim_foreign_receive_packet_queue_put(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
-  uint8_t byte         = get_vhpi_int_param_by_index(p_cb_data, 2);
-  int end_of_packet    = get_vhpi_int_param_by_index(p_cb_data, 3);
-  bool eop             = end_of_packet == 1 ? true : false;
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  uint8_t byte                = get_vhpi_int_param_by_index(p_cb_data, 2);
+  int end_of_packet           = get_vhpi_int_param_by_index(p_cb_data, 3);
+  bool eop                    = end_of_packet == 1 ? true : false;
 
   uvvm_cosim::receive_packet_queue_put(vvc_type, vvc_instance_id, byte, eop);
 }
 
+static void uvvm_cosim_foreign_transmit_byte_queue_get_beat(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  int max_bytes               = get_vhpi_param_size_by_index(p_cb_data, 2);
+
+  auto data = uvvm_cosim::transmit_byte_queue_get_beat(vvc_type, vvc_instance_id, max_bytes);
+
+  put_vhpi_int_vec_param_by_index(p_cb_data, 2, data);
+  put_vhpi_int_param_by_index(p_cb_data, 3, data.size());
+}
+
+static void uvvm_cosim_foreign_receive_byte_queue_put_beat(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  auto data                   = get_vhpi_int_vec_param_by_index<uint8_t>(p_cb_data, 2);
+
+  uvvm_cosim::receive_byte_queue_put_beat(vvc_type, vvc_instance_id, data);
+}
+
+static void uvvm_cosim_foreign_transmit_packet_queue_get_beat(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  int max_bytes               = get_vhpi_param_size_by_index(p_cb_data, 2);
+  bool eop                    = false;
+
+  auto data = uvvm_cosim::transmit_packet_queue_get_beat(vvc_type, vvc_instance_id, max_bytes, eop);
+
+  put_vhpi_int_vec_param_by_index(p_cb_data, 2, data);
+  put_vhpi_int_param_by_index(p_cb_data, 3, data.size());
+  put_vhpi_int_param_by_index(p_cb_data, 4, eop ? 1 : 0);
+}
+
+static void uvvm_cosim_foreign_receive_packet_queue_put_beat(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  auto data                   = get_vhpi_int_vec_param_by_index<uint8_t>(p_cb_data, 2);
+  int end_of_packet           = get_vhpi_int_param_by_index(p_cb_data, 3);
+  bool eop                    = end_of_packet == 1 ? true : false;
+
+  uvvm_cosim::receive_packet_queue_put_beat(vvc_type, vvc_instance_id, data, eop);
+}
+
+static void uvvm_cosim_foreign_transmit_packet_queue_get_meta(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+
+  auto meta = uvvm_cosim::transmit_packet_queue_get_meta(vvc_type, vvc_instance_id);
+
+  put_vhpi_int_vec_param_by_index(p_cb_data, 2, meta);
+}
+
+static void uvvm_cosim_foreign_receive_packet_queue_put_meta(const vhpiCbDataT* p_cb_data)
+{
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
+  auto meta                   = get_vhpi_int_vec_param_by_index<int>(p_cb_data, 2);
+
+  uvvm_cosim::receive_packet_queue_put_meta(vvc_type, vvc_instance_id, meta);
+}
+
 static void uvvm_cosim_foreign_vvc_listen_enable(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
-  int vvc_instance_id  = get_vhpi_int_param_by_index(p_cb_data, 1);
+  const std::string& vvc_type = get_vhpi_str_param_by_index(p_cb_data, 0);
+  int vvc_instance_id         = get_vhpi_int_param_by_index(p_cb_data, 1);
 
   bool listen          = uvvm_cosim::vvc_listen_enable(vvc_type, vvc_instance_id);
 
@@ -119,10 +188,10 @@ static void uvvm_cosim_foreign_vvc_listen_enable(const vhpiCbDataT* p_cb_data)
 
 static void uvvm_cosim_foreign_report_vvc_info(const vhpiCbDataT* p_cb_data)
 {
-  std::string vvc_type    = get_vhpi_str_param_by_index(p_cb_data, 0);
-  std::string vvc_channel = get_vhpi_str_param_by_index(p_cb_data, 1);
-  int vvc_instance_id     = get_vhpi_int_param_by_index(p_cb_data, 2);
-  std::string bfm_cfg_str = get_vhpi_str_param_by_index(p_cb_data, 3);
+  const std::string& vvc_type    = get_vhpi_str_param_by_index(p_cb_data, 0);
+  const std::string& vvc_channel = get_vhpi_str_param_by_index(p_cb_data, 1);
+  int vvc_instance_id            = get_vhpi_int_param_by_index(p_cb_data, 2);
+  const std::string& bfm_cfg_str = get_vhpi_str_param_by_index(p_cb_data, 3);
 
   uvvm_cosim::report_vvc_info(vvc_type, vvc_channel, vvc_instance_id, bfm_cfg_str);
 }
@@ -183,6 +252,36 @@ static void register_foreign_methods(void)
 			       c_lib_name,
 			       vhpiProcF);
 
+  register_vhpi_foreign_method(uvvm_cosim_foreign_transmit_byte_queue_get_beat,
+			       "uvvm_cosim_foreign_transmit_byte_queue_get_beat",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(uvvm_cosim_foreign_receive_byte_queue_put_beat,
+			       "uvvm_cosim_foreign_receive_byte_queue_put_beat",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(uvvm_cosim_foreign_transmit_packet_queue_get_beat,
+			       "uvvm_cosim_foreign_transmit_packet_queue_get_beat",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(uvvm_cosim_foreign_receive_packet_queue_put_beat,
+			       "uvvm_cosim_foreign_receive_packet_queue_put_beat",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(uvvm_cosim_foreign_transmit_packet_queue_get_meta,
+			       "uvvm_cosim_foreign_transmit_packet_queue_get_meta",
+			       c_lib_name,
+			       vhpiProcF);
+
+  register_vhpi_foreign_method(uvvm_cosim_foreign_receive_packet_queue_put_meta,
+			       "uvvm_cosim_foreign_receive_packet_queue_put_meta",
+			       c_lib_name,
+			       vhpiProcF);
+
   vhpi_printf("Registered all foreign functions/procedures");
 }
 
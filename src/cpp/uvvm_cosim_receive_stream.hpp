@@ -0,0 +1,291 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <jsonrpccxx/iclientconnector.hpp>
+#include "uvvm_cosim_client.hpp"
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Receives data from a VVC in the background, so the test code can read
+// it from a local buffer without polling the server itself.
+//
+// A thread keeps calling ReceiveBytes or ReceivePacket on its own
+// connection. While data is coming in it polls again immediately, and
+// when the queue is empty the poll interval doubles up to
+// max_poll_interval, so an idle stream costs a steady, low request rate.
+// Polling pauses while max_buffered_bytes or more are buffered, until
+// the test code has read some of it.
+//
+// Listening must be enabled on the VVC with SetVvcListenEnable. If a
+// receive call fails, the stream stops, and the read calls throw
+// runtime_error with the error once the buffered data has been read.
+class UvvmCosimReceiveStream {
+public:
+  enum Mode { RSM_BYTES, RSM_PACKETS };
+
+  struct Config {
+    int max_request_bytes = 4096;
+    size_t max_buffered_bytes = 1 << 20;
+    std::chrono::microseconds min_poll_interval = std::chrono::microseconds(100);
+    std::chrono::microseconds max_poll_interval = std::chrono::milliseconds(10);
+  };
+
+  using Timeout = std::chrono::steady_clock::duration;
+
+  UvvmCosimReceiveStream(std::unique_ptr<jsonrpccxx::IClientConnector> connector,
+                         const std::string& vvc_type, int vvc_id, Mode mode, Config cfg)
+    : connector(std::move(connector)), client(*this->connector),
+      vvcType(vvc_type), vvcId(vvc_id), mode(mode), cfg(cfg)
+  {
+    thread = std::thread([this]() { run(); });
+  }
+
+  UvvmCosimReceiveStream(std::unique_ptr<jsonrpccxx::IClientConnector> connector,
+                         const std::string& vvc_type, int vvc_id, Mode mode)
+    : UvvmCosimReceiveStream(std::move(connector), vvc_type, vvc_id, mode, Config())
+  {
+  }
+
+  ~UvvmCosimReceiveStream()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stopping = true;
+    }
+    cv.notify_all();
+    thread.join();
+  }
+
+  UvvmCosimReceiveStream(const UvvmCosimReceiveStream&) = delete;
+  UvvmCosimReceiveStream& operator=(const UvvmCosimReceiveStream&) = delete;
+
+  // Wait until num_bytes bytes have been received and return them. Returns
+  // nothing and leaves the buffered data alone on timeout.
+  std::optional<std::vector<uint8_t>> read(size_t num_bytes, Timeout timeout)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!wait(lock, timeout, [&]() { return rxBytes.size() >= num_bytes; })) {
+      return {};
+    }
+
+    return take_bytes(num_bytes);
+  }
+
+  // Wait until some data has been received, and return up to max_bytes
+  // of it. Returns an empty vector on timeout.
+  std::vector<uint8_t> read_some(size_t max_bytes, Timeout timeout)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!wait(lock, timeout, [&]() { return !rxBytes.empty(); })) {
+      return {};
+    }
+
+    return take_bytes(std::min(max_bytes, rxBytes.size()));
+  }
+
+  // Wait for the next packet. Returns nothing on timeout.
+  std::optional<std::vector<uint8_t>> read_packet(Timeout timeout)
+  {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    if (!wait(lock, timeout, [&]() { return !rxPackets.empty(); })) {
+      return {};
+    }
+
+    std::vector<uint8_t> pkt = std::move(rxPackets.front());
+    rxPackets.pop_front();
+    bufferedBytes -= pkt.size();
+    cv.notify_all();
+
+    return pkt;
+  }
+
+  // Input range over the received packets, which ends when no packet has
+  // been received within timeout of the previous one:
+  //
+  //   for (const std::vector<uint8_t>& pkt : stream.packets(100ms)) { ... }
+  class PacketRange {
+  public:
+    class iterator {
+    public:
+      using iterator_category = std::input_iterator_tag;
+      using value_type = std::vector<uint8_t>;
+      using difference_type = std::ptrdiff_t;
+      using pointer = const value_type*;
+      using reference = const value_type&;
+
+      iterator() = default;
+
+      reference operator*() const { return *pkt; }
+      pointer operator->() const { return &*pkt; }
+
+      iterator& operator++()
+      {
+        pkt = stream->read_packet(timeout);
+        return *this;
+      }
+
+      void operator++(int) { ++*this; }
+
+      bool operator==(const iterator& other) const { return !pkt && !other.pkt; }
+
+    private:
+      friend class PacketRange;
+
+      UvvmCosimReceiveStream* stream = nullptr;
+      Timeout timeout;
+      std::optional<std::vector<uint8_t>> pkt;
+
+      iterator(UvvmCosimReceiveStream* stream, Timeout timeout)
+        : stream(stream), timeout(timeout), pkt(stream->read_packet(timeout))
+      {
+      }
+    };
+
+    iterator begin() { return iterator(&stream, timeout); }
+    iterator end() { return iterator(); }
+
+  private:
+    friend class UvvmCosimReceiveStream;
+
+    UvvmCosimReceiveStream& stream;
+    Timeout timeout;
+
+    PacketRange(UvvmCosimReceiveStream& stream, Timeout timeout) : stream(stream), timeout(timeout) {}
+  };
+
+  PacketRange packets(Timeout timeout)
+  {
+    return PacketRange(*this, timeout);
+  }
+
+  size_t buffered_bytes()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return bufferedBytes;
+  }
+
+private:
+  std::unique_ptr<jsonrpccxx::IClientConnector> connector;
+  UvvmCosimClient client;
+  std::string vvcType;
+  int vvcId;
+  Mode mode;
+  Config cfg;
+
+  std::mutex mtx;
+  std::condition_variable cv;
+  std::deque<uint8_t> rxBytes;
+  std::deque<std::vector<uint8_t>> rxPackets;
+  size_t bufferedBytes = 0;
+  std::string error;
+  bool stopping = false;
+
+  std::thread thread;
+
+  // Wait for ready() with mtx held. Throws the receive error if the stream
+  // has stopped and ready() can't become true anymore.
+  template <typename F>
+  bool wait(std::unique_lock<std::mutex>& lock, Timeout timeout, F ready)
+  {
+    bool ok = cv.wait_for(lock, timeout, [&]() { return ready() || !error.empty(); });
+
+    if (ok && !ready()) {
+      throw std::runtime_error(error);
+    }
+
+    return ok;
+  }
+
+  std::vector<uint8_t> take_bytes(size_t num_bytes)
+  {
+    std::vector<uint8_t> data(rxBytes.begin(), rxBytes.begin() + num_bytes);
+    rxBytes.erase(rxBytes.begin(), rxBytes.begin() + num_bytes);
+    bufferedBytes -= num_bytes;
+    cv.notify_all();
+
+    return data;
+  }
+
+  void run()
+  {
+    auto interval = cfg.min_poll_interval;
+
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [&]() { return stopping || bufferedBytes < cfg.max_buffered_bytes; });
+
+        if (stopping) {
+          return;
+        }
+      }
+
+      std::vector<uint8_t> data;
+      std::optional<std::string> failure;
+
+      try {
+        JsonResponse response = mode == RSM_BYTES
+          ? client.ReceiveBytes(vvcType, vvcId, cfg.max_request_bytes, false)
+          : client.ReceivePacket(vvcType, vvcId);
+
+        if (response.success) {
+          data = response.result.at("data").get<std::vector<uint8_t>>();
+        } else {
+          failure = response.result.value("error", std::string());
+        }
+      }
+      catch (const std::exception& e) {
+        failure = e.what();
+      }
+
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+
+        // error must not be empty, or the readers keep waiting for data
+        // until they time out
+        if (failure) {
+          error = failure->empty() ? "Receive failed" : *failure;
+          cv.notify_all();
+          return;
+        }
+
+        if (!data.empty()) {
+          bufferedBytes += data.size();
+
+          if (mode == RSM_BYTES) {
+            rxBytes.insert(rxBytes.end(), data.begin(), data.end());
+          } else {
+            rxPackets.push_back(data);
+          }
+
+          cv.notify_all();
+          interval = cfg.min_poll_interval;
+          continue;
+        }
+
+        // Back off while the queue is empty
+        cv.wait_for(lock, interval, [&]() { return stopping; });
+      }
+
+      interval = std::min(interval * 2, cfg.max_poll_interval);
+    }
+  }
+};
+
+} // namespace uvvm_cosim
@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include <map>
 #include <stdexcept>
 #include <string>
@@ -26,6 +32,18 @@ static std::vector<std::string> split_str(std::string str, std::string delim)
   return str_list;
 }
 
+// Canonical absolute path with symlinks resolved, path must exist
+static std::string real_path(const std::string& path)
+{
+  char resolved[PATH_MAX];
+
+  if (::realpath(path.c_str(), resolved) == nullptr) {
+    throw std::runtime_error("Failed to resolve " + path + ": " + std::strerror(errno));
+  }
+
+  return resolved;
+}
+
 // Search a comma-separated string for config values
 // Each config value must be a key/value pair formatted as "key=value"
 // Only integers are supported for value (use 0/1 for bool).
@@ -65,6 +83,95 @@ static std::map<std::string, int> parse_bfm_cfg_str(const std::string& cfg_str)
 
 namespace uvvm_cosim {
 
+// Key for the VVC that handles data in the direction of qid. UART VVCs
+// have separate TX and RX channels, the other VVC types have one channel.
+static VvcInstanceKey vvc_key(const std::string& vvc_type, int vvc_id, QueueId qid)
+{
+  return VvcInstanceKey{
+    .vvc_type = vvc_type,
+    .vvc_channel = (vvc_type != "UART_VVC" ? "NA" : qid == QID_TRANSMIT ? "TX" : "RX"),
+    .vvc_instance_id = vvc_id
+  };
+}
+
+// Resolve vvc and call f with its handle. The procedures that take a VVC
+// type and id are implemented this way on top of their ByHandle variants.
+template <typename F>
+JsonResponse
+UvvmCosimServer::with_vvc_handle(const VvcInstanceKey& vvc, F f)
+{
+  VvcHandle handle;
+
+  try {
+    handle = cosimData.ResolveVvc(vvc);
+  }
+  catch (const std::runtime_error& e) {
+    return JsonResponse{
+      .success = false,
+      .result = json{{"error", e.what()}}
+    };
+  }
+
+  return f(handle);
+}
+
+void
+UvvmCosimServer::SetFileRoot(const std::string& root)
+{
+  fileRoot = real_path(root);
+}
+
+void
+UvvmCosimServer::StartCapture(const std::string& path)
+{
+  auto log = std::make_unique<TrafficLogWriter>(path);
+
+  // Records are written with the map locked while the data is put, so
+  // they are in the same order and have the same sim time as the data
+  // the simulator gets from the queues
+  cosimData.setPutHook([log = log.get()](QueueId qid, const VvcInstanceKey& vvc,
+                                         uint64_t sim_time_ns, const uint8_t* data,
+                                         size_t size, bool packet, bool eop) {
+    uint8_t flags = (packet ? TLF_PACKET : 0) | (eop ? TLF_EOP : 0);
+    log->write(qid, vvc, sim_time_ns, data, size, flags);
+  });
+
+  trafficLog = std::move(log);
+}
+
+std::string
+UvvmCosimServer::StopCapture()
+{
+  if (!trafficLog) {
+    return "";
+  }
+
+  trafficLog->close();
+  return trafficLog->error();
+}
+
+void
+UvvmCosimServer::StartReplay(const std::string& path, uint64_t timeout_ns)
+{
+  trafficReplay = std::make_unique<TrafficReplay>(path, cosimData, timeout_ns);
+  cosimData.setStartSim(true);
+}
+
+void
+UvvmCosimServer::UpdateSimTime(uint64_t sim_time_ns)
+{
+  uint64_t cycles = cosimData.getSimCycles() + 1;
+  cosimData.setSimTime(sim_time_ns, cycles);
+  simProgress.cycle(sim_time_ns, cycles);
+
+  if (trafficReplay && trafficReplay->tick(sim_time_ns)) {
+    cosimData.setTerminateSim(true);
+    simControl.terminate();
+  }
+
+  simControl.cycle(sim_time_ns, cycles);
+}
+
 void
 UvvmCosimServer::WaitForStartSim()
 {
@@ -82,22 +189,18 @@ UvvmCosimServer::ShouldTerminateSim()
 }
 
 bool
-UvvmCosimServer::VvcListenEnabled(std::string vvc_type,
+UvvmCosimServer::VvcListenEnabled(const std::string& vvc_type,
 				  int vvc_instance_id)
 {
-  VvcInstanceKey vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_instance_id
-  };
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_RECEIVE);
 
   // Note: GetVvcListenEnable will throw if vvc does not exist
   return cosimData.GetVvcListenEnable(vvc);
 }
 
 void
-UvvmCosimServer::AddVvc(std::string vvc_type, std::string vvc_channel,
-			int vvc_instance_id, std::string bfm_cfg_str)
+UvvmCosimServer::AddVvc(const std::string& vvc_type, const std::string& vvc_channel,
+			int vvc_instance_id, const std::string& bfm_cfg_str)
 {
   auto bfm_cfg = parse_bfm_cfg_str(bfm_cfg_str);
 
@@ -111,46 +214,141 @@ UvvmCosimServer::AddVvc(std::string vvc_type, std::string vvc_channel,
   cosimData.AddVvc(vvc, bfm_cfg);
 }
 
-bool
-UvvmCosimServer::TransmitQueueEmpty(std::string vvc_type,
+int
+UvvmCosimServer::TransmitQueuePoll(const std::string& vvc_type,
 				    int vvc_instance_id)
+{
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_TRANSMIT);
+
+  return cosimData.byte_queue_poll(QID_TRANSMIT, vvc);
+}
+
+std::optional<uint8_t>
+UvvmCosimServer::TransmitQueueGet(const std::string& vvc_type,
+				  int vvc_instance_id)
+{
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_TRANSMIT);
+
+  return cosimData.byte_queue_get(QID_TRANSMIT, vvc);
+}
+
+void UvvmCosimServer::ReceiveQueuePut(const std::string& vvc_type,
+				      int vvc_instance_id,
+				      uint8_t byte)
+{
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_RECEIVE);
+
+  // No client is attached during replay, data is only checked
+  if (trafficReplay) {
+    if (trafficLog) {
+      trafficLog->write(QID_RECEIVE, vvc, cosimData.getSimTime(), byte, 0);
+    }
+
+    trafficReplay->receive(vvc, byte, false, false);
+    return;
+  }
+
+  cosimData.byte_queue_put(QID_RECEIVE, vvc, byte);
+}
+
+int UvvmCosimServer::TransmitPacketQueuePoll(const std::string& vvc_type, int vvc_instance_id)
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_channel = "NA",
     .vvc_instance_id = vvc_instance_id
   };
 
-  return cosimData.byte_queue_empty(QID_TRANSMIT, vvc);
+  return cosimData.packet_queue_poll(QID_TRANSMIT, vvc);
 }
 
-std::optional<uint8_t>
-UvvmCosimServer::TransmitQueueGet(std::string vvc_type,
-				  int vvc_instance_id)
+auto UvvmCosimServer::TransmitPacketQueueGet(const std::string& vvc_type, int vvc_instance_id) -> std::optional<std::pair<uint8_t, bool>>
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
+    .vvc_channel = "NA",
     .vvc_instance_id = vvc_instance_id
   };
 
-  return cosimData.byte_queue_get(QID_TRANSMIT, vvc);
+  return cosimData.packet_queue_get_byte(QID_TRANSMIT, vvc);
 }
 
-void UvvmCosimServer::ReceiveQueuePut(std::string vvc_type,
+void UvvmCosimServer::ReceivePacketQueuePut(const std::string& vvc_type, int vvc_instance_id, uint8_t byte, bool eop)
+{
+  VvcInstanceKey vvc = {
+    .vvc_type = vvc_type,
+    .vvc_channel = "NA",
+    .vvc_instance_id = vvc_instance_id
+  };
+
+  // No client is attached during replay, data is only checked
+  if (trafficReplay) {
+    if (trafficLog) {
+      trafficLog->write(QID_RECEIVE, vvc, cosimData.getSimTime(), byte,
+                        TLF_PACKET | (eop ? TLF_EOP : 0));
+    }
+
+    trafficReplay->receive(vvc, byte, eop, true);
+    return;
+  }
+
+  cosimData.packet_queue_put_byte(QID_RECEIVE, vvc, byte, eop);
+}
+
+std::vector<uint8_t>
+UvvmCosimServer::TransmitQueueGetBeat(const std::string& vvc_type,
 				      int vvc_instance_id,
-				      uint8_t byte)
+				      int max_bytes)
+{
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_TRANSMIT);
+
+  // Zero means all bytes for byte_queue_get
+  if (max_bytes <= 0) {
+    return std::vector<uint8_t>();
+  }
+
+  return cosimData.byte_queue_get(QID_TRANSMIT, vvc, max_bytes);
+}
+
+void UvvmCosimServer::ReceiveQueuePutBeat(const std::string& vvc_type,
+					  int vvc_instance_id,
+					  const std::vector<uint8_t>& data)
+{
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_instance_id, QID_RECEIVE);
+
+  // No client is attached during replay, data is only checked
+  if (trafficReplay) {
+    if (trafficLog) {
+      trafficLog->write(QID_RECEIVE, vvc, cosimData.getSimTime(), data, 0);
+    }
+
+    for (uint8_t byte : data) {
+      trafficReplay->receive(vvc, byte, false, false);
+    }
+    return;
+  }
+
+  cosimData.byte_queue_put(QID_RECEIVE, vvc, data);
+}
+
+std::vector<uint8_t>
+UvvmCosimServer::TransmitPacketQueueGetBeat(const std::string& vvc_type,
+					    int vvc_instance_id,
+					    int max_bytes, bool& eop)
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
+    .vvc_channel = "NA",
     .vvc_instance_id = vvc_instance_id
   };
 
-  cosimData.byte_queue_put(QID_RECEIVE, vvc, byte);
+  return cosimData.packet_queue_get_bytes(QID_TRANSMIT, vvc, std::max(max_bytes, 0), eop);
 }
 
-bool UvvmCosimServer::TransmitPacketQueueEmpty(std::string vvc_type, int vvc_instance_id)
+void UvvmCosimServer::ReceivePacketQueuePutBeat(const std::string& vvc_type,
+						int vvc_instance_id,
+						const std::vector<uint8_t>& data,
+						bool eop)
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
@@ -158,10 +356,23 @@ bool UvvmCosimServer::TransmitPacketQueueEmpty(std::string vvc_type, int vvc_ins
     .vvc_instance_id = vvc_instance_id
   };
 
-  return cosimData.packet_queue_empty(QID_TRANSMIT, vvc);
+  // No client is attached during replay, data is only checked
+  if (trafficReplay) {
+    if (trafficLog) {
+      trafficLog->write(QID_RECEIVE, vvc, cosimData.getSimTime(), data,
+                        TLF_PACKET | (eop ? TLF_EOP : 0));
+    }
+
+    for (size_t i = 0; i < data.size(); i++) {
+      trafficReplay->receive(vvc, data[i], eop && i == data.size()-1, true);
+    }
+    return;
+  }
+
+  cosimData.packet_queue_put_bytes(QID_RECEIVE, vvc, data, eop);
 }
 
-auto UvvmCosimServer::TransmitPacketQueueGet(std::string vvc_type, int vvc_instance_id) -> std::optional<std::pair<uint8_t, bool>>
+PacketMeta UvvmCosimServer::TransmitPacketQueueGetMeta(const std::string& vvc_type, int vvc_instance_id)
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
@@ -169,10 +380,10 @@ auto UvvmCosimServer::TransmitPacketQueueGet(std::string vvc_type, int vvc_insta
     .vvc_instance_id = vvc_instance_id
   };
 
-  return cosimData.packet_queue_get_byte(QID_TRANSMIT, vvc);
+  return cosimData.packet_queue_get_meta(QID_TRANSMIT, vvc);
 }
 
-void UvvmCosimServer::ReceivePacketQueuePut(std::string vvc_type, int vvc_instance_id, uint8_t byte, bool eop)
+void UvvmCosimServer::ReceivePacketQueuePutMeta(const std::string& vvc_type, int vvc_instance_id, PacketMeta meta)
 {
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
@@ -180,7 +391,12 @@ void UvvmCosimServer::ReceivePacketQueuePut(std::string vvc_type, int vvc_instan
     .vvc_instance_id = vvc_instance_id
   };
 
-  cosimData.packet_queue_put_byte(QID_RECEIVE, vvc, byte, eop);
+  // Sideband signals are not captured or checked in replay
+  if (trafficReplay) {
+    return;
+  }
+
+  cosimData.packet_queue_put_meta(QID_RECEIVE, vvc, meta);
 }
 
 
@@ -212,6 +428,7 @@ JsonResponse
 UvvmCosimServer::TerminateSim()
 {
   cosimData.setTerminateSim(true);
+  simControl.terminate();
 
   std::cout << std::endl << std::endl << std::endl;
   std::cout << "TERMINATING SIM!!!" << std::endl << std::endl << std::endl;
@@ -223,6 +440,91 @@ UvvmCosimServer::TerminateSim()
   return response;
 }
 
+JsonResponse
+UvvmCosimServer::SetLockstepMode(bool enable)
+{
+  simControl.set_lockstep(enable);
+
+  JsonResponse response = {
+    .success = true
+  };
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::RunFor(uint64_t amount, std::string unit)
+{
+  JsonResponse response;
+
+  try {
+    SimControl::Unit run_unit = SimControl::parse_unit(unit);
+
+    if (!simControl.get_lockstep()) {
+      throw std::runtime_error("RunFor requires lockstep mode");
+    }
+
+    // The simulator also waits for StartSim before it runs
+    cosimData.setStartSim(true);
+
+    SimControl::Progress progress;
+    bool reached = simControl.run_for(amount, run_unit, progress);
+
+    response.success = true;
+    response.result = json{{"reached", reached},
+                           {"sim_time_ns", progress.sim_time_ns},
+                           {"cycles", progress.cycles}};
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::GetSimTime()
+{
+  JsonResponse response = {
+    .success = true,
+    .result = json{{"sim_time_ns", cosimData.getSimTime()},
+                   {"cycles", cosimData.getSimCycles()}}
+  };
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::GetSimProgress()
+{
+  SimProgress::Sample current = {
+    .wall = SimProgress::Clock::now(),
+    .sim_time_ns = cosimData.getSimTime(),
+    .cycles = cosimData.getSimCycles()
+  };
+
+  SimProgress::Report report = simProgress.report(current, {1.0, 10.0, 60.0});
+
+  json rates = json::array();
+  for (const SimProgress::Rate& rate : report.rates) {
+    rates.push_back(json{{"window_s", rate.window_s},
+                         {"cycles_per_s", rate.cycles_per_s},
+                         {"sim_ns_per_s", rate.sim_ns_per_s}});
+  }
+
+  JsonResponse response = {
+    .success = true,
+    .result = json{{"sim_time_ns", report.sim_time_ns},
+                   {"cycles", report.cycles},
+                   {"wall_time_s", report.wall_time_s},
+                   {"rates", rates}}
+  };
+
+  return response;
+}
+
+
 JsonResponse
 UvvmCosimServer::GetVvcList()
 {
@@ -241,11 +543,7 @@ UvvmCosimServer::SetVvcListenEnable(std::string vvc_type, int vvc_id, bool enabl
 {
   JsonResponse response;
 
-  VvcInstanceKey vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_id
-  };
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_id, QID_RECEIVE);
 
   try {
     cosimData.SetVvcListenEnable(vvc, enable);
@@ -260,18 +558,40 @@ UvvmCosimServer::SetVvcListenEnable(std::string vvc_type, int vvc_id, bool enabl
 }
 
 JsonResponse
-UvvmCosimServer::TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+UvvmCosimServer::ResolveVvc(std::string vvc_type, int vvc_id)
 {
   JsonResponse response;
 
-  VvcInstanceKey vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "TX" : "NA"),
-    .vvc_instance_id = vvc_id
-  };
+  try {
+    response.result = json{
+      {"transmit", cosimData.ResolveVvc(vvc_key(vvc_type, vvc_id, QID_TRANSMIT))},
+      {"receive", cosimData.ResolveVvc(vvc_key(vvc_type, vvc_id, QID_RECEIVE))}
+    };
+    response.success = true;
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
+{
+  return with_vvc_handle(vvc_key(vvc_type, vvc_id, QID_TRANSMIT), [&](VvcHandle handle) {
+    return TransmitBytesByHandle(handle, data);
+  });
+}
+
+JsonResponse
+UvvmCosimServer::TransmitBytesByHandle(VvcHandle handle, std::vector<uint8_t> data)
+{
+  JsonResponse response;
 
   try {
-    cosimData.byte_queue_put(QID_TRANSMIT, vvc, data);
+    cosimData.byte_queue_put(QID_TRANSMIT, handle, data);
     response.success = true;
   }
   catch (const std::runtime_error& e) {
@@ -285,16 +605,31 @@ UvvmCosimServer::TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uin
 JsonResponse
 UvvmCosimServer::TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data)
 {
-  JsonResponse response;
+  return TransmitPacketWithMeta(vvc_type, vvc_id, data, PacketMeta{});
+}
 
+JsonResponse
+UvvmCosimServer::TransmitPacketWithMeta(std::string vvc_type, int vvc_id, std::vector<uint8_t> data,
+                                        PacketMeta meta)
+{
   VvcInstanceKey vvc = {
     .vvc_type = vvc_type,
     .vvc_channel = "NA",
     .vvc_instance_id = vvc_id
   };
 
+  return with_vvc_handle(vvc, [&](VvcHandle handle) {
+    return TransmitPacketByHandle(handle, data, meta);
+  });
+}
+
+JsonResponse
+UvvmCosimServer::TransmitPacketByHandle(VvcHandle handle, std::vector<uint8_t> data, PacketMeta meta)
+{
+  JsonResponse response;
+
   try {
-    cosimData.packet_queue_put_pkt(QID_TRANSMIT, vvc, data);
+    cosimData.packet_queue_put_pkt(QID_TRANSMIT, handle, data, meta);
     response.success = true;
   }
   catch (const std::runtime_error& e) {
@@ -306,32 +641,107 @@ UvvmCosimServer::TransmitPacket(std::string vvc_type, int vvc_id, std::vector<ui
 }
 
 JsonResponse
-UvvmCosimServer::ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length)
+UvvmCosimServer::TransmitFromFile(std::string vvc_type, int vvc_id, std::string path,
+                                  uint64_t offset, uint64_t length, int packetize_by)
 {
   JsonResponse response;
 
-  VvcInstanceKey vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_id
-  };
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_id, QID_TRANSMIT);
+
+  try {
+    if (packetize_by < 0) {
+      throw std::runtime_error("packetize_by can not be negative");
+    }
+
+    if (fileRoot.empty()) {
+      throw std::runtime_error("TransmitFromFile is disabled, set UVVM_COSIM_FILE_ROOT to enable it");
+    }
+
+    // Relative paths are relative to the root. The resolved path must be
+    // inside the root, so clients can't read other files via .. or symlinks.
+    std::string resolved = real_path(path.starts_with("/") ? path : fileRoot + "/" + path);
+    std::string prefix = fileRoot == "/" ? fileRoot : fileRoot + "/";
+
+    if (!resolved.starts_with(prefix)) {
+      throw std::runtime_error("Path " + path + " is outside of UVVM_COSIM_FILE_ROOT");
+    }
+
+    auto file = MappedFile::open(resolved, offset, length);
+    size_t num_packets = cosimData.queue_put_file(QID_TRANSMIT, vvc, file, packetize_by);
+
+    response.success = true;
+    response.result = json{{"bytes", file->size()}, {"packets", num_packets}};
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length)
+{
+  return with_vvc_handle(vvc_key(vvc_type, vvc_id, QID_RECEIVE), [&](VvcHandle handle) {
+    return receive_bytes(handle, num_bytes, exact_length, false);
+  });
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveBytesWithTimestamps(std::string vvc_type, int vvc_id, int num_bytes,
+                                            bool exact_length)
+{
+  return with_vvc_handle(vvc_key(vvc_type, vvc_id, QID_RECEIVE), [&](VvcHandle handle) {
+    return receive_bytes(handle, num_bytes, exact_length, true);
+  });
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveBytesByHandle(VvcHandle handle, int num_bytes, bool exact_length)
+{
+  return receive_bytes(handle, num_bytes, exact_length, false);
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveBytesByHandleWithTimestamps(VvcHandle handle, int num_bytes, bool exact_length)
+{
+  return receive_bytes(handle, num_bytes, exact_length, true);
+}
+
+JsonResponse
+UvvmCosimServer::receive_bytes(VvcHandle handle, int num_bytes, bool exact_length, bool timestamps)
+{
+  JsonResponse response;
 
   try {
     std::vector<uint8_t> data;
-    bool empty = cosimData.byte_queue_empty(QID_RECEIVE, vvc);
+    std::vector<SimStampRun> stamps;
+    std::vector<SimStampRun>* stamps_ptr = timestamps ? &stamps : nullptr;
+    bool empty = cosimData.byte_queue_empty(QID_RECEIVE, handle);
 
     if (!empty && exact_length) {
-      size_t size = cosimData.byte_queue_size(QID_RECEIVE, vvc);
+      size_t size = cosimData.byte_queue_size(QID_RECEIVE, handle);
 
       if (size >= num_bytes) {
-        data = cosimData.byte_queue_get(QID_RECEIVE, vvc, num_bytes);
+        data = cosimData.byte_queue_get(QID_RECEIVE, handle, num_bytes, stamps_ptr);
       }
     } else if (!empty && !exact_length) {
-      data = cosimData.byte_queue_get(QID_RECEIVE, vvc, num_bytes);
+      data = cosimData.byte_queue_get(QID_RECEIVE, handle, num_bytes, stamps_ptr);
     }
 
     response.success = true;
     response.result = json{{"data", data}};
+
+    if (timestamps) {
+      response.result["timestamps"] = json::array();
+
+      for (const SimStampRun& run : stamps) {
+        response.result["timestamps"].push_back(json{{"count", run.count},
+                                                     {"sim_time_ns", run.stamp.sim_time_ns},
+                                                     {"cycle", run.stamp.cycle}});
+      }
+    }
   }
   catch (const std::runtime_error& e) {
     response.success = false;
@@ -344,23 +754,59 @@ UvvmCosimServer::ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, b
 JsonResponse
 UvvmCosimServer::ReceivePacket(std::string vvc_type, int vvc_id)
 {
-  JsonResponse response;
+  return with_vvc_handle(vvc_key(vvc_type, vvc_id, QID_RECEIVE), [&](VvcHandle handle) {
+    return receive_packet(handle, false);
+  });
+}
 
-  VvcInstanceKey vvc = {
-    .vvc_type = vvc_type,
-    .vvc_channel = (vvc_type == "UART_VVC" ? "RX" : "NA"),
-    .vvc_instance_id = vvc_id
-  };
+JsonResponse
+UvvmCosimServer::ReceivePacketWithTimestamps(std::string vvc_type, int vvc_id)
+{
+  return with_vvc_handle(vvc_key(vvc_type, vvc_id, QID_RECEIVE), [&](VvcHandle handle) {
+    return receive_packet(handle, true);
+  });
+}
+
+JsonResponse
+UvvmCosimServer::ReceivePacketByHandle(VvcHandle handle)
+{
+  return receive_packet(handle, false);
+}
+
+JsonResponse
+UvvmCosimServer::ReceivePacketByHandleWithTimestamps(VvcHandle handle)
+{
+  return receive_packet(handle, true);
+}
+
+JsonResponse
+UvvmCosimServer::receive_packet(VvcHandle handle, bool timestamps)
+{
+  JsonResponse response;
 
   try {
     std::vector<uint8_t> pkt;
+    PacketStamp stamp;
+    PacketMeta meta;
 
-    if(!cosimData.packet_queue_empty(QID_RECEIVE, vvc)) {
-      pkt = cosimData.packet_queue_get_pkt(QID_RECEIVE, vvc);
+    if(!cosimData.packet_queue_empty(QID_RECEIVE, handle)) {
+      pkt = cosimData.packet_queue_get_pkt(QID_RECEIVE, handle, &stamp, &meta);
     }
 
     response.success = true;
     response.result = json{{"data", pkt}};
+
+    // Only packets with sideband signals carry them in the result
+    if (meta != PacketMeta{}) {
+      response.result["meta"] = meta;
+    }
+
+    if (timestamps && !pkt.empty()) {
+      response.result["timestamps"] = json{
+        {"first", {{"sim_time_ns", stamp.first.sim_time_ns}, {"cycle", stamp.first.cycle}}},
+        {"last", {{"sim_time_ns", stamp.last.sim_time_ns}, {"cycle", stamp.last.cycle}}}
+      };
+    }
   }
   catch (const std::runtime_error& e) {
     response.success = false;
@@ -370,5 +816,320 @@ UvvmCosimServer::ReceivePacket(std::string vvc_type, int vvc_id)
   return response;
 }
 
-} // namespace uvvm_cosim
+JsonResponse
+UvvmCosimServer::WaitForPattern(std::string vvc_type, int vvc_id, std::vector<uint8_t> pattern,
+                                int timeout_ms, bool consume)
+{
+  JsonResponse response;
+
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_id, QID_RECEIVE);
+
+  try {
+    auto match = cosimData.byte_queue_wait_for_pattern(QID_RECEIVE, vvc, pattern,
+                                                       std::chrono::milliseconds(timeout_ms),
+                                                       consume);
+
+    response.success = true;
+
+    if (match) {
+      response.result = json{{"found", true},
+                             {"length", match->length},
+                             {"data", match->data}};
+    } else {
+      response.result = json{{"found", false},
+                             {"length", 0},
+                             {"data", std::vector<uint8_t>()}};
+    }
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::GetQueueStatus(bool reset_high_water)
+{
+  auto queue_json = [](const QueueStatus& q) {
+    return json{{"bytes", q.bytes},
+                {"packets", q.packets},
+                {"high_water_bytes", q.high_water_bytes},
+                {"high_water_packets", q.high_water_packets}};
+  };
+
+  JsonResponse response;
+
+  response.success = true;
+  response.result = json::array();
+
+  for (const VvcQueueStatus& vvc : cosimData.GetQueueStatus(reset_high_water)) {
+    response.result.push_back(json{{"vvc_type", vvc.vvc.vvc_type},
+                                   {"vvc_channel", vvc.vvc.vvc_channel},
+                                   {"vvc_instance_id", vvc.vvc.vvc_instance_id},
+                                   {"packet_based", vvc.packet_based},
+                                   {"transmit", queue_json(vvc.queues[QID_TRANSMIT])},
+                                   {"receive", queue_json(vvc.queues[QID_RECEIVE])}});
+  }
 
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::WaitForAny(std::vector<VvcRef> receive_vvcs, std::vector<VvcRef> transmit_vvcs,
+                            int transmit_threshold, int timeout_ms)
+{
+  JsonResponse response;
+
+  try {
+    if (timeout_ms < 0 || transmit_threshold < 0) {
+      throw std::runtime_error("timeout_ms and transmit_threshold can not be negative");
+    }
+
+    std::vector<VvcInstanceKey> receive;
+    std::vector<VvcInstanceKey> transmit;
+
+    for (const VvcRef& vvc : receive_vvcs) {
+      receive.push_back(vvc_key(vvc.vvc_type, vvc.vvc_id, QID_RECEIVE));
+    }
+
+    for (const VvcRef& vvc : transmit_vvcs) {
+      transmit.push_back(vvc_key(vvc.vvc_type, vvc.vvc_id, QID_TRANSMIT));
+    }
+
+    auto ready = cosimData.wait_for_any(receive, transmit, transmit_threshold,
+                                        std::chrono::milliseconds(timeout_ms));
+
+    response.success = true;
+    response.result = json{{"ready", json::array()}};
+
+    for (const QueueReady& q : ready) {
+      response.result["ready"].push_back(json{{"vvc_type", q.vvc.vvc_type},
+                                              {"vvc_id", q.vvc.vvc_instance_id},
+                                              {"direction", q.qid == QID_RECEIVE ? "receive" : "transmit"},
+                                              {"bytes", q.bytes},
+                                              {"packets", q.packets}});
+    }
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::TransmitMulti(std::vector<TransmitEntry> entries)
+{
+  JsonResponse response;
+
+  try {
+    std::vector<QueuePut> puts;
+
+    for (TransmitEntry& entry : entries) {
+      puts.push_back(QueuePut{
+        .vvc = vvc_key(entry.vvc_type, entry.vvc_id, QID_TRANSMIT),
+        .data = std::move(entry.data),
+        .meta = entry.meta
+      });
+    }
+
+    std::vector<bool> packet_based = cosimData.queue_put_multi(QID_TRANSMIT, puts);
+
+    size_t num_bytes = 0;
+    size_t num_packets = 0;
+
+    for (size_t i = 0; i < puts.size(); i++) {
+      num_bytes += puts[i].data.size();
+      num_packets += packet_based[i];
+    }
+
+    response.success = true;
+    response.result = json{{"bytes", num_bytes}, {"packets", num_packets}};
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::ReceiveMulti(std::vector<ReceiveEntry> entries)
+{
+  JsonResponse response;
+
+  try {
+    std::vector<QueueGet> gets;
+
+    for (const ReceiveEntry& entry : entries) {
+      if (entry.limit < 0) {
+        throw std::runtime_error("limit can not be negative");
+      }
+
+      gets.push_back(QueueGet{
+        .vvc = vvc_key(entry.vvc_type, entry.vvc_id, QID_RECEIVE),
+        .limit = size_t(entry.limit)
+      });
+    }
+
+    auto results = cosimData.queue_get_multi(QID_RECEIVE, gets);
+
+    response.success = true;
+    response.result = json{{"results", json::array()}};
+
+    for (size_t i = 0; i < results.size(); i++) {
+      json result = json{{"vvc_type", entries[i].vvc_type},
+                         {"vvc_id", entries[i].vvc_id}};
+
+      if (results[i].packet_based) {
+        result["packets"] = json::array();
+
+        for (const QueuedPacket& pkt : results[i].packets) {
+          json pkt_json = json{{"data", pkt.data}};
+
+          // Same as ReceivePacket, only packets with sideband signals carry them
+          if (pkt.meta != PacketMeta{}) {
+            pkt_json["meta"] = pkt.meta;
+          }
+
+          result["packets"].push_back(pkt_json);
+        }
+      } else {
+        result["data"] = results[i].data;
+      }
+
+      response.result["results"].push_back(result);
+    }
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+// Operations sorted by total time waited for the lock, longest first
+static std::vector<std::pair<std::string, LockOpStats>> sort_by_wait(const LockStatsReport& report)
+{
+  std::vector<std::pair<std::string, LockOpStats>> ops(report.begin(), report.end());
+
+  std::stable_sort(ops.begin(), ops.end(), [](const auto& a, const auto& b) {
+    return a.second.wait.total_ns > b.second.wait.total_ns;
+  });
+
+  return ops;
+}
+
+JsonResponse
+UvvmCosimServer::GetLockStats(bool reset)
+{
+  auto histogram_json = [](const DurationHistogram& h) {
+    // Buckets after the last non-empty one are left out
+    auto last = std::find_if(h.buckets.rbegin(), h.buckets.rend(), [](uint64_t n) { return n != 0; });
+
+    return json{{"count", h.count},
+                {"total_ns", h.total_ns},
+                {"max_ns", h.max_ns},
+                {"p50_ns", h.percentile_ns(0.5)},
+                {"p99_ns", h.percentile_ns(0.99)},
+                {"buckets", std::vector<uint64_t>(h.buckets.begin(), last.base())}};
+  };
+
+  JsonResponse response;
+
+  response.success = true;
+  response.result = json{{"enabled", cosimData.getLockStats()},
+                         {"ops", json::array()}};
+
+  for (const auto& [name, stats] : sort_by_wait(cosimData.GetLockStatsReport(reset))) {
+    response.result["ops"].push_back(json{{"op", name},
+                                          {"kind", to_string(stats.kind)},
+                                          {"wait", histogram_json(stats.wait)},
+                                          {"hold", histogram_json(stats.hold)}});
+  }
+
+  return response;
+}
+
+std::vector<std::string>
+UvvmCosimServer::LockStatsSummary()
+{
+  auto histogram_str = [](const DurationHistogram& h) {
+    return "avg " + std::to_string(h.count ? h.total_ns / h.count : 0) +
+           " p99 " + std::to_string(h.percentile_ns(0.99)) +
+           " max " + std::to_string(h.max_ns) + " ns";
+  };
+
+  std::vector<std::string> lines;
+
+  for (const auto& [name, stats] : sort_by_wait(cosimData.GetLockStatsReport(false))) {
+    lines.push_back(std::string("Lock stats ") + to_string(stats.kind) + " " + name + ": " +
+                    std::to_string(stats.wait.count) + " locks, " +
+                    "wait " + histogram_str(stats.wait) + ", " +
+                    "hold " + histogram_str(stats.hold));
+  }
+
+  return lines;
+}
+
+JsonResponse
+UvvmCosimServer::AttachReceiveSink(std::string vvc_type, int vvc_id, std::string path,
+                                   std::string format, int link_type)
+{
+  JsonResponse response;
+
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_id, QID_RECEIVE);
+
+  try {
+    if (link_type < 0 || link_type > 0xFFFF) {
+      throw std::runtime_error("Invalid link_type " + std::to_string(link_type));
+    }
+
+    cosimData.AttachReceiveSink(vvc, path, ReceiveSink::parse_format(format), link_type);
+    response.success = true;
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+JsonResponse
+UvvmCosimServer::DetachReceiveSink(std::string vvc_type, int vvc_id)
+{
+  JsonResponse response;
+
+  VvcInstanceKey vvc = vvc_key(vvc_type, vvc_id, QID_RECEIVE);
+
+  try {
+    auto sink = cosimData.DetachReceiveSink(vvc);
+
+    // Flush and close the file before responding
+    sink->close();
+
+    std::string error = sink->error();
+
+    response.success = error.empty();
+    response.result = json{{"bytes", sink->bytes()},
+                           {"packets", sink->packets()}};
+
+    if (!error.empty()) {
+      response.result["error"] = error;
+    }
+  }
+  catch (const std::runtime_error& e) {
+    response.success = false;
+    response.result = json{{"error", e.what()}};
+  }
+
+  return response;
+}
+
+} // namespace uvvm_cosim
@@ -2,13 +2,18 @@
 #include <atomic>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 #include <jsonrpccxx/server.hpp>
-#include <cpphttplibconnector.hpp>
+#include "http_connector.hpp"
+#include "sim_control.hpp"
+#include "sim_progress.hpp"
 #include "uvvm_cosim_types.hpp"
 #include "uvvm_cosim_data.hpp"
+#include "traffic_log.hpp"
 
 namespace uvvm_cosim {
 
@@ -16,8 +21,18 @@ class UvvmCosimServer {
 private:
 
   jsonrpccxx::JsonRpc2Server jsonRpcServer;
-  CppHttpLibServerConnector httpServer;
+  HttpServerConnector httpServer;
   UvvmCosimData cosimData;
+  SimControl simControl;
+  SimProgress simProgress;
+
+  // Set when capturing traffic to a log or replaying traffic from a log
+  std::unique_ptr<TrafficLogWriter> trafficLog;
+  std::unique_ptr<TrafficReplay> trafficReplay;
+
+  // Directory TransmitFromFile may read files from, resolved to its
+  // canonical path. TransmitFromFile is disabled while it is empty.
+  std::string fileRoot;
 
   // --------------------------------------------------------------------------
   // JSON-RPC remote procedures
@@ -26,55 +41,205 @@ private:
   JsonResponse StartSim();
   JsonResponse PauseSim();
   JsonResponse TerminateSim();
+  JsonResponse SetLockstepMode(bool enable);
+  JsonResponse RunFor(uint64_t amount, std::string unit);
+  JsonResponse GetSimTime();
+  JsonResponse GetSimProgress();
   JsonResponse GetVvcList();
   JsonResponse SetVvcListenEnable(std::string vvc_type, int vvc_id, bool enable);
 
   JsonResponse TransmitBytes(std::string vvc_type, int vvc_id, std::vector<uint8_t> data);
   JsonResponse TransmitPacket(std::string vvc_type, int vvc_id, std::vector<uint8_t> data);
+  JsonResponse TransmitPacketWithMeta(std::string vvc_type, int vvc_id, std::vector<uint8_t> data,
+                                      PacketMeta meta);
+  JsonResponse TransmitFromFile(std::string vvc_type, int vvc_id, std::string path,
+                                uint64_t offset, uint64_t length, int packetize_by);
 
   JsonResponse ReceiveBytes(std::string vvc_type, int vvc_id, int num_bytes, bool exact_length);
   JsonResponse ReceivePacket(std::string vvc_type, int vvc_id);
 
+  // Same as ReceiveBytes/ReceivePacket, with the sim time stamps of the
+  // received data included in the result
+  JsonResponse ReceiveBytesWithTimestamps(std::string vvc_type, int vvc_id, int num_bytes,
+                                          bool exact_length);
+  JsonResponse ReceivePacketWithTimestamps(std::string vvc_type, int vvc_id);
+
+  JsonResponse WaitForPattern(std::string vvc_type, int vvc_id, std::vector<uint8_t> pattern,
+                              int timeout_ms, bool consume);
+
+  JsonResponse GetQueueStatus(bool reset_high_water);
+
+  JsonResponse WaitForAny(std::vector<VvcRef> receive_vvcs, std::vector<VvcRef> transmit_vvcs,
+                          int transmit_threshold, int timeout_ms);
+
+  JsonResponse TransmitMulti(std::vector<TransmitEntry> entries);
+
+  JsonResponse ReceiveMulti(std::vector<ReceiveEntry> entries);
+
+  JsonResponse GetLockStats(bool reset);
+
+  JsonResponse AttachReceiveSink(std::string vvc_type, int vvc_id, std::string path,
+                                 std::string format, int link_type);
+  JsonResponse DetachReceiveSink(std::string vvc_type, int vvc_id);
+
+  // Clients that resolve a VVC to its transmit and receive handles once
+  // can use the ByHandle variants, which skip looking up the VVC by name
+  JsonResponse ResolveVvc(std::string vvc_type, int vvc_id);
+
+  JsonResponse TransmitBytesByHandle(VvcHandle handle, std::vector<uint8_t> data);
+  JsonResponse TransmitPacketByHandle(VvcHandle handle, std::vector<uint8_t> data, PacketMeta meta);
+  JsonResponse ReceiveBytesByHandle(VvcHandle handle, int num_bytes, bool exact_length);
+  JsonResponse ReceivePacketByHandle(VvcHandle handle);
+  JsonResponse ReceiveBytesByHandleWithTimestamps(VvcHandle handle, int num_bytes, bool exact_length);
+  JsonResponse ReceivePacketByHandleWithTimestamps(VvcHandle handle);
+
+  JsonResponse receive_bytes(VvcHandle handle, int num_bytes, bool exact_length, bool timestamps);
+  JsonResponse receive_packet(VvcHandle handle, bool timestamps);
+
+  template <typename F>
+  JsonResponse with_vvc_handle(const VvcInstanceKey& vvc, F f);
+
+  // Add a JSON-RPC procedure. Its calls are tagged with its name, so
+  // lock statistics are attributed to it.
+  void AddMethod(const std::string& name, jsonrpccxx::MethodHandle handle,
+                 const jsonrpccxx::NamedParamMapping& params)
+  {
+    jsonRpcServer.Add(name, [name, handle](const json& args) {
+      LockOp op(LOK_RPC, name);
+      return handle(args);
+    }, params);
+  }
+
 public:
-  UvvmCosimServer(int port)
+  UvvmCosimServer(const HttpServerConfig& http_cfg)
     : jsonRpcServer()
-    , httpServer(jsonRpcServer, port)
+    , httpServer(jsonRpcServer, http_cfg)
   {
     using namespace jsonrpccxx;
 
     // Add JSON-RPC procedures
 
-    jsonRpcServer.Add("TransmitBytes",
-                      GetHandle(&UvvmCosimServer::TransmitBytes, *this),
-                      {"vvc_type", "vvc_id", "data"});
+    AddMethod("TransmitBytes",
+              GetHandle(&UvvmCosimServer::TransmitBytes, *this),
+              {"vvc_type", "vvc_id", "data"});
+
+    AddMethod("TransmitPacket",
+              GetHandle(&UvvmCosimServer::TransmitPacket, *this),
+              {"vvc_type", "vvc_id", "data"});
+
+    AddMethod("TransmitPacketWithMeta",
+              GetHandle(&UvvmCosimServer::TransmitPacketWithMeta, *this),
+              {"vvc_type", "vvc_id", "data", "meta"});
+
+    AddMethod("TransmitFromFile",
+              GetHandle(&UvvmCosimServer::TransmitFromFile, *this),
+              {"vvc_type", "vvc_id", "path", "offset", "length", "packetize_by"});
+
+    AddMethod("ReceiveBytes",
+              GetHandle(&UvvmCosimServer::ReceiveBytes, *this),
+              {"vvc_type", "vvc_id", "num_bytes", "exact_length"});
+
+    AddMethod("ReceivePacket",
+              GetHandle(&UvvmCosimServer::ReceivePacket, *this),
+              {"vvc_type", "vvc_id"});
+
+    AddMethod("ReceiveBytesWithTimestamps",
+              GetHandle(&UvvmCosimServer::ReceiveBytesWithTimestamps, *this),
+              {"vvc_type", "vvc_id", "num_bytes", "exact_length"});
+
+    AddMethod("ReceivePacketWithTimestamps",
+              GetHandle(&UvvmCosimServer::ReceivePacketWithTimestamps, *this),
+              {"vvc_type", "vvc_id"});
+
+    AddMethod("WaitForPattern",
+              GetHandle(&UvvmCosimServer::WaitForPattern, *this),
+              {"vvc_type", "vvc_id", "pattern", "timeout_ms", "consume"});
+
+    AddMethod("GetQueueStatus",
+              GetHandle(&UvvmCosimServer::GetQueueStatus, *this),
+              {"reset_high_water"});
+
+    AddMethod("WaitForAny",
+              GetHandle(&UvvmCosimServer::WaitForAny, *this),
+              {"receive_vvcs", "transmit_vvcs", "transmit_threshold", "timeout_ms"});
+
+    AddMethod("TransmitMulti",
+              GetHandle(&UvvmCosimServer::TransmitMulti, *this),
+              {"entries"});
+
+    AddMethod("ReceiveMulti",
+              GetHandle(&UvvmCosimServer::ReceiveMulti, *this),
+              {"entries"});
+
+    AddMethod("GetLockStats",
+              GetHandle(&UvvmCosimServer::GetLockStats, *this),
+              {"reset"});
+
+    AddMethod("AttachReceiveSink",
+              GetHandle(&UvvmCosimServer::AttachReceiveSink, *this),
+              {"vvc_type", "vvc_id", "path", "format", "link_type"});
+
+    AddMethod("DetachReceiveSink",
+              GetHandle(&UvvmCosimServer::DetachReceiveSink, *this),
+              {"vvc_type", "vvc_id"});
+
+    AddMethod("ResolveVvc",
+              GetHandle(&UvvmCosimServer::ResolveVvc, *this),
+              {"vvc_type", "vvc_id"});
+
+    AddMethod("TransmitBytesByHandle",
+              GetHandle(&UvvmCosimServer::TransmitBytesByHandle, *this),
+              {"handle", "data"});
+
+    AddMethod("TransmitPacketByHandle",
+              GetHandle(&UvvmCosimServer::TransmitPacketByHandle, *this),
+              {"handle", "data", "meta"});
+
+    AddMethod("ReceiveBytesByHandle",
+              GetHandle(&UvvmCosimServer::ReceiveBytesByHandle, *this),
+              {"handle", "num_bytes", "exact_length"});
+
+    AddMethod("ReceivePacketByHandle",
+              GetHandle(&UvvmCosimServer::ReceivePacketByHandle, *this),
+              {"handle"});
 
-    jsonRpcServer.Add("TransmitPacket",
-                      GetHandle(&UvvmCosimServer::TransmitPacket, *this),
-                      {"vvc_type", "vvc_id", "data"});
+    AddMethod("ReceiveBytesByHandleWithTimestamps",
+              GetHandle(&UvvmCosimServer::ReceiveBytesByHandleWithTimestamps, *this),
+              {"handle", "num_bytes", "exact_length"});
 
-    jsonRpcServer.Add("ReceiveBytes",
-                      GetHandle(&UvvmCosimServer::ReceiveBytes, *this),
-                      {"vvc_type", "vvc_id", "num_bytes", "exact_length"});
+    AddMethod("ReceivePacketByHandleWithTimestamps",
+              GetHandle(&UvvmCosimServer::ReceivePacketByHandleWithTimestamps, *this),
+              {"handle"});
 
-    jsonRpcServer.Add("ReceivePacket",
-                      GetHandle(&UvvmCosimServer::ReceivePacket, *this),
-                      {"vvc_type", "vvc_id"});
+    AddMethod("GetVvcList",
+              GetHandle(&UvvmCosimServer::GetVvcList, *this), {});
 
-    jsonRpcServer.Add("GetVvcList",
-                      GetHandle(&UvvmCosimServer::GetVvcList, *this), {});
+    AddMethod("SetVvcListenEnable",
+              GetHandle(&UvvmCosimServer::SetVvcListenEnable, *this),
+              {"vvc_type", "vvc_id", "enable"});
 
-    jsonRpcServer.Add("SetVvcListenEnable",
-                      GetHandle(&UvvmCosimServer::SetVvcListenEnable, *this),
-		      {"vvc_type", "vvc_id", "enable"});
+    AddMethod("StartSim",
+              GetHandle(&UvvmCosimServer::StartSim, *this), {});
 
-    jsonRpcServer.Add("StartSim",
-		      GetHandle(&UvvmCosimServer::StartSim, *this), {});
+    AddMethod("PauseSim",
+              GetHandle(&UvvmCosimServer::PauseSim, *this), {});
 
-    jsonRpcServer.Add("PauseSim",
-		      GetHandle(&UvvmCosimServer::PauseSim, *this), {});
+    AddMethod("TerminateSim",
+              GetHandle(&UvvmCosimServer::TerminateSim, *this), {});
 
-    jsonRpcServer.Add("TerminateSim",
-		      GetHandle(&UvvmCosimServer::TerminateSim, *this), {});
+    AddMethod("SetLockstepMode",
+              GetHandle(&UvvmCosimServer::SetLockstepMode, *this),
+              {"enable"});
+
+    AddMethod("RunFor",
+              GetHandle(&UvvmCosimServer::RunFor, *this),
+              {"amount", "unit"});
+
+    AddMethod("GetSimTime",
+              GetHandle(&UvvmCosimServer::GetSimTime, *this), {});
+
+    AddMethod("GetSimProgress",
+              GetHandle(&UvvmCosimServer::GetSimProgress, *this), {});
   }
 
   ~UvvmCosimServer()
@@ -93,29 +258,114 @@ public:
 
   void StopListening()
   {
+    // Release any client blocked in RunFor, so the server can shut down
+    simControl.terminate();
     httpServer.StopListening();
   }
 
+  // Allow TransmitFromFile to read files under root. Set by the server
+  // operator, since the paths come from the clients.
+  void SetFileRoot(const std::string& root);
+
+  // Lockstep mode can be enabled before the simulation starts, so the
+  // simulator stops at the first cycle and waits for RunFor
+  void SetLockstep(bool enable)
+  {
+    simControl.set_lockstep(enable);
+  }
+
+  void SetPollConfig(PollConfig cfg)
+  {
+    cosimData.setPollConfig(cfg);
+  }
+
+  // Record how long calls wait for and hold the lock on the VVC queues,
+  // reported by GetLockStats and LockStatsSummary
+  void SetLockStats(bool enable)
+  {
+    cosimData.setLockStats(enable);
+  }
+
+  bool LockStatsEnabled() const
+  {
+    return cosimData.getLockStats();
+  }
+
+  // One line per operation, the ones that waited longest first, for
+  // printing at the end of the simulation
+  std::vector<std::string> LockStatsSummary();
+
+  int Port() const
+  {
+    return httpServer.Port();
+  }
+
+  // Capture all transmit/receive traffic to a binary log
+  void StartCapture(const std::string& path);
+
+  // Close the capture log, if any. Returns the first error from writing
+  // the log, or an empty string.
+  std::string StopCapture();
+
+  // Replay transmit traffic from a log, and check received data against
+  // it. Replay is done without a client, and the simulation is started
+  // immediately and terminated when the replay is done.
+  void StartReplay(const std::string& path, uint64_t timeout_ns);
+
+  bool ReplayActive() const
+  {
+    return trafficReplay != nullptr;
+  }
+
+  std::string ReplaySummary() const
+  {
+    return trafficReplay ? trafficReplay->summary() : "";
+  }
+
+  // Called from the simulator for every cycle of the cosim clock.
+  // Blocks in lockstep mode until the simulator is allowed to continue.
+  void UpdateSimTime(uint64_t sim_time_ns);
+
   void WaitForStartSim();
   bool ShouldTerminateSim();
 
-  bool VvcListenEnabled(std::string vvc_type,
+  bool VvcListenEnabled(const std::string& vvc_type,
 			   int vvc_instance_id);
 
-  void AddVvc(std::string vvc_type, std::string vvc_channel,
-	      int vvc_instance_id, std::string bfm_cfg_str);
+  void AddVvc(const std::string& vvc_type, const std::string& vvc_channel,
+	      int vvc_instance_id, const std::string& bfm_cfg_str);
+
+  // Returns 0 if the transmit queue has data, otherwise the number of
+  // cycles to wait before polling again
+  int TransmitQueuePoll(const std::string& vvc_type, int vvc_instance_id);
+
+  std::optional<uint8_t> TransmitQueueGet(const std::string& vvc_type, int vvc_instance_id);
+
+  void ReceiveQueuePut(const std::string& vvc_type, int vvc_instance_id, uint8_t byte);
+
+  int TransmitPacketQueuePoll(const std::string& vvc_type, int vvc_instance_id);
+
+  auto TransmitPacketQueueGet(const std::string& vvc_type, int vvc_instance_id) -> std::optional<std::pair<uint8_t, bool>>;
+
+  void ReceivePacketQueuePut(const std::string& vvc_type, int vvc_instance_id, uint8_t byte, bool eop);
 
-  bool TransmitQueueEmpty(std::string vvc_type, int vvc_instance_id);
+  // Beat variants of the above, which move up to max_bytes (or all of
+  // data) per call. Packet beats never cross the end of a packet.
+  std::vector<uint8_t> TransmitQueueGetBeat(const std::string& vvc_type, int vvc_instance_id, int max_bytes);
 
-  std::optional<uint8_t> TransmitQueueGet(std::string vvc_type, int vvc_instance_id);
+  void ReceiveQueuePutBeat(const std::string& vvc_type, int vvc_instance_id, const std::vector<uint8_t>& data);
 
-  void ReceiveQueuePut(std::string vvc_type, int vvc_instance_id, uint8_t byte);
+  std::vector<uint8_t> TransmitPacketQueueGetBeat(const std::string& vvc_type, int vvc_instance_id,
+                                                  int max_bytes, bool& eop);
 
-  bool TransmitPacketQueueEmpty(std::string vvc_type, int vvc_instance_id);
+  void ReceivePacketQueuePutBeat(const std::string& vvc_type, int vvc_instance_id,
+                                 const std::vector<uint8_t>& data, bool eop);
 
-  auto TransmitPacketQueueGet(std::string vvc_type, int vvc_instance_id) -> std::optional<std::pair<uint8_t, bool>>;
+  // Sideband signals for the packet currently being transmitted or
+  // received, moved once per packet
+  PacketMeta TransmitPacketQueueGetMeta(const std::string& vvc_type, int vvc_instance_id);
 
-  void ReceivePacketQueuePut(std::string vvc_type, int vvc_instance_id, uint8_t byte, bool eop);
+  void ReceivePacketQueuePutMeta(const std::string& vvc_type, int vvc_instance_id, PacketMeta meta);
 
 };
   
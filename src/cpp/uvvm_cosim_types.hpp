@@ -1,7 +1,9 @@
 #pragma once
 #include <deque>
 #include <map>
+#include <memory>
 #include <string>
+#include <variant>
 #include "nlohmann/json.hpp"
 #include "byte_queue.hpp"
 #include "packet_queue.hpp"
@@ -11,6 +13,8 @@ namespace uvvm_cosim {
 
 using json = nlohmann::json;
 
+class ReceiveSink;
+
 enum QueueId { QID_TRANSMIT, QID_RECEIVE, QID_MAX};
 
 // Used as key in std::map of all VVCs in server
@@ -37,15 +41,37 @@ struct VvcConfig {
   std::map<std::string, int> bfm_cfg;
 };
 
+// Adaptive polling of transmit queues. After idle_cycles cycles without
+// data the VVC controller is told to wait an exponentially growing number
+// of cycles between polls, up to max_cycles. max_cycles = 1 disables it.
+struct PollConfig {
+  unsigned idle_cycles = 100;
+  unsigned max_cycles = 1;
+};
+
+struct PollState {
+  unsigned idle_cycles = 0;
+  unsigned interval = 1;
+};
+
+// Transmit and receive queue for a VVC
+using ByteQueuePair = std::array<ByteQueue, QID_MAX>;
+using PacketQueuePair = std::array<PacketQueue, QID_MAX>;
+
 // Used as value in std::map of all VVCs in server
 struct VvcInstanceData {
   VvcConfig cfg;
 
-  // Used only for VVCs that are not packet-based
-  std::array<ByteQueue, QID_MAX> byte_queues;
+  // Byte queues for VVCs that are not packet-based, packet queues for
+  // those that are. The kind is chosen when the VVC is added, so only
+  // one of them is allocated per VVC.
+  std::variant<ByteQueuePair, PacketQueuePair> queues;
+
+  // When set, received data is written here instead of to the queues
+  std::shared_ptr<ReceiveSink> receive_sink;
 
-  // Used only for VVCs that are packet-based
-  std::array<PacketQueue, QID_MAX> packet_queues;
+  // Backoff state for polling the transmit queue
+  PollState poll;
 };
 
 // This struct contains all fields that identify a VVC as well as
@@ -88,6 +114,82 @@ inline void from_json(const json &j, VvcInstance &v) {
   j.at("listen_enable").get_to(v.listen_enable);
 }
 
+// Fields left out in JSON are zero
+inline void to_json(json &j, const PacketMeta &m) {
+  j = json{{"tid", m.tid},
+           {"tdest", m.tdest},
+           {"tuser", m.tuser}};
+}
+
+inline void from_json(const json &j, PacketMeta &m) {
+  m.tid = j.value("tid", 0u);
+  m.tdest = j.value("tdest", 0u);
+  m.tuser = j.value("tuser", 0u);
+}
+
+// VVC as given by clients in RPC calls that take a list of VVCs
+struct VvcRef {
+  std::string vvc_type;
+  int vvc_id;
+};
+
+inline void to_json(json &j, const VvcRef &v) {
+  j = json{{"vvc_type", v.vvc_type},
+           {"vvc_id", v.vvc_id}};
+}
+
+inline void from_json(const json &j, VvcRef &v) {
+  j.at("vvc_type").get_to(v.vvc_type);
+  j.at("vvc_id").get_to(v.vvc_id);
+}
+
+// Entry in a TransmitMulti call. The data is queued as bytes or as one
+// packet depending on the VVC. meta is left out for VVCs without
+// sideband signals.
+struct TransmitEntry {
+  std::string vvc_type;
+  int vvc_id;
+  std::vector<uint8_t> data;
+  PacketMeta meta;
+};
+
+inline void to_json(json &j, const TransmitEntry &e) {
+  j = json{{"vvc_type", e.vvc_type},
+           {"vvc_id", e.vvc_id},
+           {"data", e.data}};
+
+  if (e.meta != PacketMeta{}) {
+    j["meta"] = e.meta;
+  }
+}
+
+inline void from_json(const json &j, TransmitEntry &e) {
+  j.at("vvc_type").get_to(e.vvc_type);
+  j.at("vvc_id").get_to(e.vvc_id);
+  j.at("data").get_to(e.data);
+  e.meta = j.value("meta", PacketMeta{});
+}
+
+// Entry in a ReceiveMulti call. limit is the maximum number of bytes, or
+// packets for packet-based VVCs, to receive. Zero means all.
+struct ReceiveEntry {
+  std::string vvc_type;
+  int vvc_id;
+  int limit;
+};
+
+inline void to_json(json &j, const ReceiveEntry &e) {
+  j = json{{"vvc_type", e.vvc_type},
+           {"vvc_id", e.vvc_id},
+           {"limit", e.limit}};
+}
+
+inline void from_json(const json &j, ReceiveEntry &e) {
+  j.at("vvc_type").get_to(e.vvc_type);
+  j.at("vvc_id").get_to(e.vvc_id);
+  e.limit = j.value("limit", 0);
+}
+
 struct JsonResponse {
   bool success;
   json result;
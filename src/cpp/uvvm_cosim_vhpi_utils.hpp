@@ -1,18 +1,77 @@
 #pragma once
+#include <algorithm>
 #include <stdexcept>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
 #include <vhpi_user.h>
 
-static inline std::string get_vhpi_str_param_by_index(const vhpiCbDataT* p_cb_data, int param_index)
+// Parameter handles and string parameter values for a foreign subprogram
+// call site, keyed by p_cb_data->obj. Looking up the handles is the main
+// cost of a foreign call, and they are the same for every call from the
+// same site. Deque so references to strings stay valid when it grows.
+struct VhpiParamCache {
+  std::vector<vhpiHandleT> handles;
+  std::deque<std::string> strings;
+};
+
+// Foreign subprograms are only called from the simulator thread
+static inline VhpiParamCache& get_vhpi_param_cache(const vhpiCbDataT* p_cb_data)
+{
+  static std::unordered_map<vhpiHandleT, VhpiParamCache> cache;
+
+  // Bound the cache in case the simulator passes a new obj handle for
+  // every call. It is only cleared when a call from another site starts,
+  // so the strings returned for the current call stay valid.
+  constexpr size_t C_MAX_CACHED_SITES = 1024;
+
+  // All params of a call are read one after another, so most lookups
+  // are for the same site as the last one
+  static vhpiHandleT last_obj = nullptr;
+  static VhpiParamCache* last_site = nullptr;
+
+  if (last_site == nullptr || p_cb_data->obj != last_obj) {
+    if (!cache.contains(p_cb_data->obj) && cache.size() >= C_MAX_CACHED_SITES) {
+      cache.clear();
+    }
+
+    last_obj = p_cb_data->obj;
+    last_site = &cache[last_obj];
+  }
+
+  return *last_site;
+}
+
+static inline vhpiHandleT get_vhpi_param_handle(const vhpiCbDataT* p_cb_data, int param_index)
+{
+  std::vector<vhpiHandleT>& handles = get_vhpi_param_cache(p_cb_data).handles;
+
+  if (param_index >= handles.size()) {
+    handles.resize(param_index + 1, nullptr);
+  }
+
+  if (handles[param_index] == nullptr) {
+    handles[param_index] = vhpi_handle_by_index(vhpiParamDecls,
+						p_cb_data->obj,
+						param_index);
+  }
+
+  return handles[param_index];
+}
+
+// The returned string is owned by the cache, and stays the same until the
+// next call from the same site. When the value is the same as in the last
+// call, which it is for VVC types, no string is allocated.
+static inline const std::string& get_vhpi_str_param_by_index(const vhpiCbDataT* p_cb_data, int param_index)
 {
   // String buffer size is pretty large to accomodate
   // BFM config strings that may get pretty long
   constexpr size_t C_MAX_STR_SIZE = 1024;
 
-  vhpiHandleT h_param = vhpi_handle_by_index(vhpiParamDecls,
-					     p_cb_data->obj,
-					     param_index);
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
   vhpiCharT str_buff[C_MAX_STR_SIZE];
   vhpiValueT vhpi_val = {.format = vhpiStrVal};
   vhpi_val.bufSize = sizeof(str_buff);
@@ -28,15 +87,24 @@ static inline std::string get_vhpi_str_param_by_index(const vhpiCbDataT* p_cb_da
   // Note:
   // vhpiCharT is defined as unsigned char and std::string
   // doesn't have constructor for uchar
+  const char* str = reinterpret_cast<char *>(vhpi_val.value.str);
+
+  std::deque<std::string>& strings = get_vhpi_param_cache(p_cb_data).strings;
 
-  return std::string(reinterpret_cast<char *>(vhpi_val.value.str));
+  if (param_index >= strings.size()) {
+    strings.resize(param_index + 1);
+  }
+
+  if (strings[param_index] != str) {
+    strings[param_index] = str;
+  }
+
+  return strings[param_index];
 }
 
 static inline int get_vhpi_int_param_by_index(const vhpiCbDataT* p_cb_data, int param_index)
 {
-  vhpiHandleT h_param = vhpi_handle_by_index(vhpiParamDecls,
-					     p_cb_data->obj,
-					     param_index);
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
   vhpiValueT vhpi_val = {.format = vhpiIntVal};
 
   if (vhpi_get_value(h_param, &vhpi_val) != 0) {
@@ -49,6 +117,71 @@ static inline int get_vhpi_int_param_by_index(const vhpiCbDataT* p_cb_data, int
   return vhpi_val.value.intg;
 }
 
+// Get integer_vector param, with the elements converted to T
+// (for example uint8_t for one byte per element)
+template <typename T>
+static inline std::vector<T> get_vhpi_int_vec_param_by_index(const vhpiCbDataT* p_cb_data, int param_index)
+{
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
+  int num_elems = vhpi_get(vhpiSizeP, h_param);
+
+  std::vector<vhpiIntT> buff(num_elems > 0 ? num_elems : 0);
+  vhpiValueT vhpi_val = {.format = vhpiIntVecVal};
+  vhpi_val.bufSize = buff.size() * sizeof(vhpiIntT);
+  vhpi_val.numElems = buff.size();
+  vhpi_val.value.intgs = buff.data();
+
+  if (!buff.empty() && vhpi_get_value(h_param, &vhpi_val) != 0) {
+    vhpi_printf("Failed to get param index %d as int vector", param_index);
+    throw std::runtime_error(std::string("VHPI error: Failed to get parameter index ")
+			     + std::to_string(param_index)
+			     + std::string(" as int vector"));
+  }
+
+  return std::vector<T>(buff.begin(), buff.end());
+}
+
+// Number of elements in an array param
+static inline int get_vhpi_param_size_by_index(const vhpiCbDataT* p_cb_data, int param_index)
+{
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
+  return vhpi_get(vhpiSizeP, h_param);
+}
+
+// Write to an integer_vector out param. Elements beyond the end of data
+// are set to zero.
+template <typename T>
+static inline void put_vhpi_int_vec_param_by_index(const vhpiCbDataT* p_cb_data, int param_index,
+						   const std::vector<T>& data)
+{
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
+  int num_elems = vhpi_get(vhpiSizeP, h_param);
+
+  if (num_elems <= 0) {
+    return;
+  }
+
+  std::vector<vhpiIntT> buff(num_elems, 0);
+  std::copy_n(data.begin(), std::min(data.size(), buff.size()), buff.begin());
+
+  vhpiValueT vhpi_val = {.format = vhpiIntVecVal};
+  vhpi_val.bufSize = buff.size() * sizeof(vhpiIntT);
+  vhpi_val.numElems = buff.size();
+  vhpi_val.value.intgs = buff.data();
+
+  vhpi_put_value(h_param, &vhpi_val, vhpiDeposit);
+}
+
+static inline void put_vhpi_int_param_by_index(const vhpiCbDataT* p_cb_data, int param_index, int value)
+{
+  vhpiHandleT h_param = get_vhpi_param_handle(p_cb_data, param_index);
+  vhpiValueT vhpi_val = {
+    .format = vhpiIntVal,
+    .value = { .intg = value }
+  };
+  vhpi_put_value(h_param, &vhpi_val, vhpiDeposit);
+}
+
 static inline void return_vhpi_int(const vhpiCbDataT* p_cb_data, int value)
 {
   vhpiValueT ret_val = {
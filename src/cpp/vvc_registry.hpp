@@ -0,0 +1,199 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Numeric ID of a VVC in the registry. Handles are assigned in the order
+// VVCs are added, and stay valid as long as the registry exists since
+// VVCs are never removed.
+using VvcHandle = uint32_t;
+
+// Registry of all VVCs, with the same interface as the std::map it
+// replaces for the parts of it that are used.
+//
+// VVC type and channel names are interned to small integer IDs when a VVC
+// is added, and the entries are indexed by a flat, open-addressed hash
+// table keyed on (type id, channel id, instance id). Looking up a key
+// costs two string hashes and a probe or two, instead of a walk down a
+// tree with string compares at every level. Clients that resolve a VVC
+// to its handle once can skip the lookup entirely.
+template <typename V>
+class VvcRegistry {
+public:
+  using value_type = std::pair<const VvcInstanceKey, V>;
+  using iterator = typename std::deque<value_type>::iterator;
+  using const_iterator = typename std::deque<value_type>::const_iterator;
+
+  iterator begin() { return entries.begin(); }
+  iterator end() { return entries.end(); }
+  const_iterator begin() const { return entries.begin(); }
+  const_iterator end() const { return entries.end(); }
+
+  size_t size() const { return entries.size(); }
+  bool empty() const { return entries.empty(); }
+
+  std::optional<VvcHandle> find_handle(const VvcInstanceKey& key) const
+  {
+    auto type_id = lookup_name(types, key.vvc_type);
+    auto channel_id = lookup_name(channels, key.vvc_channel);
+
+    if (!type_id || !channel_id) {
+      return {};
+    }
+
+    return probe(pack(*type_id, *channel_id, key.vvc_instance_id));
+  }
+
+  iterator find(const VvcInstanceKey& key)
+  {
+    auto handle = find_handle(key);
+    return handle ? entries.begin() + *handle : entries.end();
+  }
+
+  const_iterator find(const VvcInstanceKey& key) const
+  {
+    auto handle = find_handle(key);
+    return handle ? entries.begin() + *handle : entries.end();
+  }
+
+  VvcHandle resolve(const VvcInstanceKey& key) const
+  {
+    if (auto handle = find_handle(key)) {
+      return *handle;
+    }
+    throw std::runtime_error("VVC " + to_string(key) + " does not exist.");
+  }
+
+  value_type& entry(VvcHandle handle)
+  {
+    if (handle >= entries.size()) {
+      throw std::runtime_error("VVC handle " + std::to_string(handle) + " does not exist.");
+    }
+    return entries[handle];
+  }
+
+  // Add a VVC unless it exists already. Returns an iterator to the VVC,
+  // and whether it was added.
+  std::pair<iterator, bool> emplace(const VvcInstanceKey& key, V&& value)
+  {
+    if (auto handle = find_handle(key)) {
+      return {entries.begin() + *handle, false};
+    }
+
+    uint64_t packed = pack(intern_name(types, key.vvc_type),
+                           intern_name(channels, key.vvc_channel),
+                           key.vvc_instance_id);
+
+    VvcHandle handle = entries.size();
+    entries.emplace_back(key, std::move(value));
+    packed_keys.push_back(packed);
+
+    // Keep the table at most half full so probe sequences stay short
+    if (entries.size() * 2 > slots.size()) {
+      rehash(std::max<size_t>(16, slots.size() * 2));
+    } else {
+      insert_slot(packed, handle);
+    }
+
+    return {entries.begin() + handle, true};
+  }
+
+private:
+  using NameMap = std::unordered_map<std::string, uint16_t>;
+
+  NameMap types;
+  NameMap channels;
+
+  // Deque so references to entries stay valid when VVCs are added
+  std::deque<value_type> entries;
+  std::vector<uint64_t> packed_keys;
+
+  static constexpr VvcHandle EMPTY_SLOT = UINT32_MAX;
+
+  struct Slot {
+    uint64_t key;
+    VvcHandle handle = EMPTY_SLOT;
+  };
+
+  // Size is zero or a power of two
+  std::vector<Slot> slots;
+
+  static std::optional<uint16_t> lookup_name(const NameMap& names, const std::string& name)
+  {
+    if (auto it = names.find(name); it != names.end()) {
+      return it->second;
+    }
+    return {};
+  }
+
+  static uint16_t intern_name(NameMap& names, const std::string& name)
+  {
+    return names.emplace(name, names.size()).first->second;
+  }
+
+  static uint64_t pack(uint16_t type_id, uint16_t channel_id, int instance_id)
+  {
+    return (uint64_t(type_id) << 48) | (uint64_t(channel_id) << 32) | uint32_t(instance_id);
+  }
+
+  // Finalizer from MurmurHash3, so keys that only differ in the
+  // instance ID are spread over the table
+  static size_t hash(uint64_t key)
+  {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  std::optional<VvcHandle> probe(uint64_t key) const
+  {
+    if (slots.empty()) {
+      return {};
+    }
+
+    size_t mask = slots.size() - 1;
+
+    for (size_t i = hash(key) & mask; slots[i].handle != EMPTY_SLOT; i = (i + 1) & mask) {
+      if (slots[i].key == key) {
+        return slots[i].handle;
+      }
+    }
+
+    return {};
+  }
+
+  void insert_slot(uint64_t key, VvcHandle handle)
+  {
+    size_t mask = slots.size() - 1;
+    size_t i = hash(key) & mask;
+
+    while (slots[i].handle != EMPTY_SLOT) {
+      i = (i + 1) & mask;
+    }
+
+    slots[i] = Slot{key, handle};
+  }
+
+  void rehash(size_t size)
+  {
+    slots.assign(size, Slot{});
+
+    for (VvcHandle handle = 0; handle < packed_keys.size(); handle++) {
+      insert_slot(packed_keys[handle], handle);
+    }
+  }
+};
+
+} // namespace uvvm_cosim
@@ -4,10 +4,15 @@
 import itertools
 import requests
 import time
+from uvvm_cosim_port import get_server_port
 
 
 def main():
-    url = "http://localhost:8484/jsonrpc"
+    port = get_server_port()
+    url = f"http://localhost:{port}/jsonrpc"
+
+    # Use a session so the connection is kept open between requests
+    session = requests.Session()
 
     id = itertools.count(start=0, step=1)
 
@@ -17,7 +22,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    requests.post(url, json=payload).json()
+    session.post(url, json=payload).json()
 
     time.sleep(0.5)
 
@@ -27,7 +32,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"VVC list response: {response}")
 
@@ -41,7 +46,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -53,7 +58,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    requests.post(url, json=payload).json()
+    session.post(url, json=payload).json()
 
     payload = {
         "method": "SetVvcListenEnable",
@@ -63,7 +68,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    requests.post(url, json=payload).json()
+    session.post(url, json=payload).json()
 
     time.sleep(0.5)
 
@@ -79,7 +84,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -94,7 +99,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -110,7 +115,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -125,7 +130,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -141,7 +146,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -154,7 +159,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    response = requests.post(url, json=payload).json()
+    response = session.post(url, json=payload).json()
     print(f"request = {payload}")
     print(f"response = {response}")
 
@@ -164,7 +169,7 @@ def main():
         "jsonrpc": "2.0",
         "id": next(id),
     }
-    requests.post(url, json=payload).json()
+    session.post(url, json=payload).json()
 
 
 if __name__ == "__main__":
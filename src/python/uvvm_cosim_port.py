@@ -0,0 +1,18 @@
+# Helper for finding the port of the cosim server, shared by the
+# example clients.
+
+import os
+import time
+
+
+def get_server_port():
+    """Wait for the simulator to write the port to UVVM_COSIM_READY_FILE if
+    it is set, otherwise use UVVM_COSIM_PORT or the default port."""
+    ready_file = os.environ.get("UVVM_COSIM_READY_FILE")
+    if ready_file is None:
+        return int(os.environ.get("UVVM_COSIM_PORT", "8484"))
+
+    while not os.path.exists(ready_file):
+        time.sleep(0.01)
+    with open(ready_file) as f:
+        return int(f.read())
@@ -23,7 +23,19 @@ use uvvm_cosim_lib.uvvm_cosim_foreign_pkg.all;
 
 entity uvvm_cosim is
   generic (
-    GC_COSIM_EN : boolean := false);
+    GC_COSIM_EN : boolean := false;
+
+    -- tdata width in bits of each AXI-Stream VVC, indexed by VVC instance.
+    -- Must match GC_DATA_WIDTH of the VVC instances.
+    GC_AXIS_DATA_WIDTHS : integer_vector(0 to C_AXISTREAM_VVC_MAX_INSTANCE_NUM-1) := (others => 8);
+
+    -- Max bytes moved per foreign call by the AXI-Stream VVC controllers.
+    GC_AXIS_BEAT_BYTES : positive := 64;
+
+    -- Transmit packets longer than C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES as
+    -- several shorter packets instead of failing. The BFM asserts tlast
+    -- at the end of each of them, so the DUT sees separate packets.
+    GC_AXIS_SEGMENT_PACKETS : boolean := false);
   port (
     clk             : in std_logic;
     vvc_config_done : in std_logic);
@@ -86,7 +98,8 @@ begin
         axis_vvc_indexes_in_use(vvc_instance_id) <= '1';
 
         -- Comma-separated string with VVC config
-        bfm_cfg := bfm_cfg_to_string(shared_axistream_vvc_config(vvc_instance_id).bfm_config);
+        bfm_cfg := bfm_cfg_to_string(shared_axistream_vvc_config(vvc_instance_id).bfm_config,
+                                     GC_AXIS_DATA_WIDTHS(vvc_instance_id));
       else
         -- Unsupported VVC
         bfm_cfg := bfm_cfg_to_string(VOID);
@@ -138,9 +151,20 @@ begin
 
   g_axis_vvc_ctrl: for vvc_idx in 0 to C_AXISTREAM_VVC_MAX_INSTANCE_NUM-1 generate
 
+    -- Only declared to check the width before it is passed on to the
+    -- controller, so the error names the generic of this entity
+    constant C_DATA_BYTES : positive :=
+      axis_data_bytes(GC_AXIS_DATA_WIDTHS(vvc_idx),
+                      "GC_AXIS_DATA_WIDTHS(" & integer'image(vvc_idx) & ")");
+
+  begin
+
     inst_axis_vvc_ctrl: entity uvvm_cosim_lib.uvvm_cosim_axis_vvc_ctrl
       generic map (
-        GC_VVC_IDX => vvc_idx)
+        GC_VVC_IDX         => vvc_idx,
+        GC_DATA_WIDTH      => GC_AXIS_DATA_WIDTHS(vvc_idx),
+        GC_BEAT_BYTES      => GC_AXIS_BEAT_BYTES,
+        GC_SEGMENT_PACKETS => GC_AXIS_SEGMENT_PACKETS)
       port map (
         clk            => clk,
         vvc_idx_in_use => axis_vvc_indexes_in_use(vvc_idx),
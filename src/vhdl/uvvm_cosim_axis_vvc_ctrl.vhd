@@ -17,7 +17,10 @@ use uvvm_cosim_lib.uvvm_cosim_foreign_pkg.all;
 
 entity uvvm_cosim_axis_vvc_ctrl is
   generic (
-    GC_VVC_IDX : natural);
+    GC_VVC_IDX         : natural;
+    GC_DATA_WIDTH      : positive := 8;   -- tdata width in bits
+    GC_BEAT_BYTES      : positive := 64;
+    GC_SEGMENT_PACKETS : boolean  := false);
   port (
     clk            : in std_logic;
     vvc_idx_in_use : in std_logic;
@@ -30,6 +33,9 @@ architecture func of uvvm_cosim_axis_vvc_ctrl is
   constant C_SCOPE    : string := "UVVM_COSIM_AXIS_VVC_CTRL";
   constant C_VVC_TYPE : string := "AXISTREAM_VVC";
 
+  -- Bytes per word (beat) on the bus
+  constant C_DATA_BYTES : positive := axis_data_bytes(GC_DATA_WIDTH, "GC_DATA_WIDTH");
+
 begin
 
   -- Note:
@@ -48,15 +54,34 @@ begin
     constant C_CMD_QUEUE_MAX : natural := 32;
     variable v_data          : t_slv_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1)(7 downto 0);
     variable v_data_size     : integer range 0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES;
-
+    variable v_poll_cycles   : natural;
+    variable v_continues     : boolean := false;
+    variable v_meta          : integer_vector(0 to 2);  -- tid, tdest, tuser
+    variable v_num_words     : natural;
+    variable v_user_array    : t_user_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1);
+    variable v_strb_array    : t_strb_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1);
+    variable v_id_array      : t_id_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1);
+    variable v_dest_array    : t_dest_array(0 to C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES-1);
+
+    -- The fetch procedures return the result of the last empty check in
+    -- poll_cycles_out, which is the number of cycles to wait before
+    -- polling again if the queue was empty, or 0 otherwise.
+    -- Data is fetched a beat of up to GC_BEAT_BYTES at a time.
     procedure fetch_bytes_to_transmit (
-      variable data_out      : out t_slv_array;
-      variable data_size_out : out integer)
+      variable data_out        : out t_slv_array;
+      variable data_size_out   : out integer;
+      variable poll_cycles_out : out natural)
     is
-      variable v_byte_idx : integer := 0;
+      variable v_byte_idx    : integer := 0;
+      variable v_poll_cycles : natural;
+      variable v_beat        : integer_vector(0 to GC_BEAT_BYTES-1);
+      variable v_beat_len    : integer;
+      variable v_num_bytes   : integer;
     begin
       -- Fetch bytes from cosim transmit queue
-      while uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 0 loop
+      v_poll_cycles := uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX);
+
+      while v_poll_cycles = 0 loop
 
         if vvc_status.pending_cmd_cnt >= C_CMD_QUEUE_MAX then
           -- Prevent command queue from overflowing (causes UVVM sim error)
@@ -70,50 +95,84 @@ begin
           exit;
         end if;
 
-        data_out(v_byte_idx) := std_logic_vector(to_unsigned(uvvm_cosim_foreign_transmit_byte_queue_get(C_VVC_TYPE, GC_VVC_IDX), data_out(0)'length));
+        v_beat_len := minimum(GC_BEAT_BYTES, C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES - v_byte_idx);
+
+        uvvm_cosim_foreign_transmit_byte_queue_get_beat(C_VVC_TYPE, GC_VVC_IDX,
+                                                        v_beat(0 to v_beat_len-1), v_num_bytes);
 
-        v_byte_idx := v_byte_idx + 1;
+        for i in 0 to v_num_bytes-1 loop
+          data_out(v_byte_idx+i) := std_logic_vector(to_unsigned(v_beat(i), data_out(0)'length));
+        end loop;
+
+        v_byte_idx := v_byte_idx + v_num_bytes;
 
-        if uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 1 then
+        v_poll_cycles := uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX);
+
+        if v_poll_cycles /= 0 then
           log(ID_SEQUENCER, "Transmit queue now empty for VVC index " & to_string(GC_VVC_IDX), C_SCOPE);
         end if;
       end loop;
 
-      data_size_out := v_byte_idx;
+      data_size_out   := v_byte_idx;
+      poll_cycles_out := v_poll_cycles;
 
     end procedure fetch_bytes_to_transmit;
 
+    -- The sideband signals of the packet are returned in meta_out.
+    -- Packets longer than C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES are fetched
+    -- in segments of that size, and continues_out is set for every
+    -- segment but the last.
     procedure fetch_packet_to_transmit (
-      variable data_out      : out t_slv_array;
-      variable data_size_out : out integer)
+      variable data_out        : out t_slv_array;
+      variable data_size_out   : out integer;
+      variable meta_out        : out integer_vector;
+      variable continues_out   : out boolean;
+      variable poll_cycles_out : out natural)
     is
-      variable v_byte_idx     : integer := 0;
-      variable v_eop_and_byte : std_logic_vector(8 downto 0);
-      variable v_eop          : std_logic := '0';
-      variable v_byte         : std_logic_vector(7 downto 0);
+      variable v_byte_idx    : integer := 0;
+      variable v_eop         : integer := 0;
+      variable v_poll_cycles : natural;
+      variable v_beat        : integer_vector(0 to GC_BEAT_BYTES-1);
+      variable v_beat_len    : integer;
+      variable v_num_bytes   : integer;
     begin
-      if uvvm_cosim_foreign_transmit_packet_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 0 and
-         vvc_status.pending_cmd_cnt < C_CMD_QUEUE_MAX
-      then
+      v_poll_cycles := uvvm_cosim_foreign_transmit_packet_queue_empty(C_VVC_TYPE, GC_VVC_IDX);
+
+      meta_out := (0, 0, 0);
 
-        while not v_eop loop
+      if v_poll_cycles = 0 and vvc_status.pending_cmd_cnt < C_CMD_QUEUE_MAX then
+
+        -- Must be fetched before the packet is consumed
+        uvvm_cosim_foreign_transmit_packet_queue_get_meta(C_VVC_TYPE, GC_VVC_IDX, meta_out);
+
+        while v_eop = 0 loop
           if v_byte_idx = C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES then
-            alert(TB_FAILURE, "Got max allowed bytes for packet on AXISTREAM VVC = " & to_string(GC_VVC_IDX) & " but no end-of-packet flag yet.", C_SCOPE);
+            -- Rest of packet goes in the next segment
             exit;
           end if;
 
-          v_eop_and_byte := std_logic_vector(to_unsigned(uvvm_cosim_foreign_transmit_packet_queue_get(C_VVC_TYPE, GC_VVC_IDX), v_eop_and_byte'length));
+          v_beat_len := minimum(GC_BEAT_BYTES, C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES - v_byte_idx);
+
+          uvvm_cosim_foreign_transmit_packet_queue_get_beat(C_VVC_TYPE, GC_VVC_IDX,
+                                                            v_beat(0 to v_beat_len-1), v_num_bytes, v_eop);
 
-          v_byte := v_eop_and_byte(7 downto 0);
-          v_eop  := v_eop_and_byte(8);
+          for i in 0 to v_num_bytes-1 loop
+            data_out(v_byte_idx+i) := std_logic_vector(to_unsigned(v_beat(i), data_out(0)'length));
+          end loop;
 
-          data_out(v_byte_idx) := v_byte;
-          v_byte_idx := v_byte_idx + 1;
+          v_byte_idx := v_byte_idx + v_num_bytes;
+
+          -- Should not happen since the queue had a packet
+          if v_num_bytes = 0 then
+            exit;
+          end if;
         end loop;
 
       end if;
 
-      data_size_out := v_byte_idx;
+      data_size_out   := v_byte_idx;
+      continues_out   := v_byte_idx > 0 and v_eop = 0;
+      poll_cycles_out := v_poll_cycles;
 
     end procedure fetch_packet_to_transmit;
 
@@ -137,21 +196,54 @@ begin
 
         -- Fetch packet or bytes from cosim transmit queue
         if bfm_config.check_packet_length then
-          fetch_packet_to_transmit (v_data, v_data_size);
+          fetch_packet_to_transmit (v_data, v_data_size, v_meta, v_continues, v_poll_cycles);
+
+          -- The BFM asserts tlast at the end of every transmit command,
+          -- so each segment is a separate packet on the bus
+          if v_continues and GC_SEGMENT_PACKETS then
+            log(ID_SEQUENCER, "Packet on VVC " & to_string(GC_VVC_IDX) & " exceeds " & to_string(C_AXISTREAM_VVC_CMD_DATA_MAX_BYTES) & " bytes, transmitting it as several packets", C_SCOPE);
+          elsif v_continues then
+            alert(TB_FAILURE, "Got max allowed bytes for packet on AXISTREAM VVC = " & to_string(GC_VVC_IDX) & " but no end-of-packet flag yet.", C_SCOPE);
+          end if;
         else
-          fetch_bytes_to_transmit (v_data, v_data_size);
+          fetch_bytes_to_transmit (v_data, v_data_size, v_poll_cycles);
+          v_meta := (0, 0, 0);
         end if;
 
         -- Transmit any bytes we got from cosim buffer
         if v_data_size > 0 then
           log(ID_SEQUENCER, "Got " & to_string(v_data_size) & " bytes to transmit on VVC " & to_string(GC_VVC_IDX), C_SCOPE);
-          axistream_transmit(AXISTREAM_VVCT, GC_VVC_IDX, v_data(0 to v_data_size-1),
-                             "Transmit " & to_string(v_data_size) & " bytes from uvvm_cosim_axis_vvc_ctrl");
+          if v_meta = (0, 0, 0) then
+            axistream_transmit(AXISTREAM_VVCT, GC_VVC_IDX, v_data(0 to v_data_size-1),
+                               "Transmit " & to_string(v_data_size) & " bytes from uvvm_cosim_axis_vvc_ctrl");
+          else
+            -- Sideband signals are the same for every word of the packet.
+            -- The values were checked against the sideband widths by the
+            -- cosim server.
+            v_num_words := (v_data_size + C_DATA_BYTES - 1) / C_DATA_BYTES;
+
+            for i in 0 to v_num_words-1 loop
+              v_id_array(i)   := std_logic_vector(to_unsigned(v_meta(0), v_id_array(i)'length));
+              v_dest_array(i) := std_logic_vector(to_unsigned(v_meta(1), v_dest_array(i)'length));
+              v_user_array(i) := std_logic_vector(to_unsigned(v_meta(2), v_user_array(i)'length));
+              v_strb_array(i) := (others => '1');
+            end loop;
+
+            axistream_transmit(AXISTREAM_VVCT, GC_VVC_IDX, v_data(0 to v_data_size-1),
+                               v_user_array(0 to v_num_words-1), v_strb_array(0 to v_num_words-1),
+                               v_id_array(0 to v_num_words-1), v_dest_array(0 to v_num_words-1),
+                               "Transmit " & to_string(v_data_size) & " bytes with sideband from uvvm_cosim_axis_vvc_ctrl");
+          end if;
         else
           exit; -- No more data this cycle
         end if;
       end loop;
 
+      -- Wait before polling again if the queue was empty
+      for i in 2 to v_poll_cycles loop
+        wait until rising_edge(clk);
+      end loop;
+
     end loop;
 
   end process p_transmit;
@@ -166,8 +258,10 @@ begin
     variable v_cmd_idx                 : integer;
     variable v_result_data             : bitvis_vip_axistream.vvc_cmd_pkg.t_vvc_result;
     variable v_end_of_packet_flag      : integer;
-    variable v_byte_as_int             : integer;
     variable v_start_new_transaction   : boolean := true;
+    variable v_beat                    : integer_vector(0 to GC_BEAT_BYTES-1);
+    variable v_beat_len                : integer;
+    variable v_byte_idx                : integer;
 
     impure function listen_enable (void : t_void) return boolean is
     begin
@@ -223,33 +317,48 @@ begin
           else
             log(ID_SEQUENCER, "AXISTREAM VVC " & to_string(GC_VVC_IDX) & ": Transaction completed. Data: " & to_string(v_result_data.data_array(0 to v_result_data.data_length-1), HEX), C_SCOPE);
 
+            -- Sideband signals are taken from the first word of the
+            -- packet, and are set before the packet data is put
             if bfm_config.check_packet_length then
-              -- Packet based VVC. Data needs to go in packet queue
-              -- and end of packet parameter must be set for the last
-              -- byte
-              v_end_of_packet_flag := 0;
+              uvvm_cosim_foreign_receive_packet_queue_put_meta(C_VVC_TYPE, GC_VVC_IDX,
+                (to_integer(unsigned(v_result_data.id_array(0))),
+                 to_integer(unsigned(v_result_data.dest_array(0))),
+                 to_integer(unsigned(v_result_data.user_array(0)))));
+            end if;
 
-              for byte_num in 0 to v_result_data.data_length-1 loop
-                if byte_num = v_result_data.data_length-1 then
-                  v_end_of_packet_flag := 1;
-                end if;
+            -- Put the data in the cosim receive queue a beat of up to
+            -- GC_BEAT_BYTES at a time
+            v_byte_idx := 0;
 
-                v_byte_as_int := to_integer(unsigned(v_result_data.data_array(byte_num)));
+            while v_byte_idx < v_result_data.data_length loop
+              v_beat_len := minimum(GC_BEAT_BYTES, v_result_data.data_length - v_byte_idx);
 
-                uvvm_cosim_foreign_receive_packet_queue_put(C_VVC_TYPE, GC_VVC_IDX,
-                                                            v_byte_as_int, v_end_of_packet_flag);
+              for i in 0 to v_beat_len-1 loop
+                v_beat(i) := to_integer(unsigned(v_result_data.data_array(v_byte_idx+i)));
               end loop;
 
-            else
-              -- VVC is not packet based.
-              -- Byte data can be put directly in byte queue.
-              for byte_num in 0 to v_result_data.data_length-1 loop
-                v_byte_as_int := to_integer(unsigned(v_result_data.data_array(byte_num)));
+              v_byte_idx := v_byte_idx + v_beat_len;
 
-                uvvm_cosim_foreign_receive_byte_queue_put(C_VVC_TYPE, GC_VVC_IDX,
-                                                          v_byte_as_int);
-              end loop;
-            end if;
+              if bfm_config.check_packet_length then
+                -- Packet based VVC. Data needs to go in packet queue
+                -- and end of packet parameter must be set for the last
+                -- beat
+                if v_byte_idx = v_result_data.data_length then
+                  v_end_of_packet_flag := 1;
+                else
+                  v_end_of_packet_flag := 0;
+                end if;
+
+                uvvm_cosim_foreign_receive_packet_queue_put_beat(C_VVC_TYPE, GC_VVC_IDX,
+                                                                 v_beat(0 to v_beat_len-1),
+                                                                 v_end_of_packet_flag);
+              else
+                -- VVC is not packet based.
+                -- Byte data can be put directly in byte queue.
+                uvvm_cosim_foreign_receive_byte_queue_put_beat(C_VVC_TYPE, GC_VVC_IDX,
+                                                               v_beat(0 to v_beat_len-1));
+              end if;
+            end loop;
 
           end if;
 
@@ -85,4 +85,62 @@ package body uvvm_cosim_foreign_pkg is
     report "Error: Should use foreign implementation" severity failure;
   end procedure;
 
+  procedure uvvm_cosim_foreign_transmit_byte_queue_get_beat(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable data            : out integer_vector;
+    variable num_bytes       : out integer
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
+  procedure uvvm_cosim_foreign_receive_byte_queue_put_beat(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in integer_vector
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
+  procedure uvvm_cosim_foreign_transmit_packet_queue_get_beat(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable data            : out integer_vector;
+    variable num_bytes       : out integer;
+    variable end_of_packet   : out integer
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
+  procedure uvvm_cosim_foreign_receive_packet_queue_put_beat(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in integer_vector;
+    constant end_of_packet   : in integer
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
+  procedure uvvm_cosim_foreign_transmit_packet_queue_get_meta(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable meta            : out integer_vector
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
+  procedure uvvm_cosim_foreign_receive_packet_queue_put_meta(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant meta            : in integer_vector
+    ) is
+  begin
+    report "Error: Should use foreign implementation" severity failure;
+  end procedure;
+
 end package body uvvm_cosim_foreign_pkg;
@@ -26,7 +26,9 @@ package uvvm_cosim_foreign_pkg is
     constant vvc_instance_id : in integer)
     return integer;
 
-  -- Returns bool as integer. True=1, False=0.
+  -- Returns 0 if the queue has data. Otherwise returns the number of clock
+  -- cycles to wait before checking again, which is 1 unless adaptive
+  -- polling is enabled.
   impure function uvvm_cosim_foreign_transmit_byte_queue_empty(
     constant vvc_type        : in string;
     constant vvc_instance_id : in integer) return integer;
@@ -42,6 +44,7 @@ package uvvm_cosim_foreign_pkg is
     constant vvc_instance_id : in integer;
     constant byte            : in integer);
 
+  -- Same return value as uvvm_cosim_foreign_transmit_byte_queue_empty
   impure function uvvm_cosim_foreign_transmit_packet_queue_empty(
     constant vvc_type        : in string;
     constant vvc_instance_id : in integer) return integer;
@@ -56,15 +59,64 @@ package uvvm_cosim_foreign_pkg is
     constant byte            : in integer;
     constant end_of_packet   : in integer);
 
-  attribute foreign of uvvm_cosim_foreign_start_sim                   : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_start_sim";
-  attribute foreign of uvvm_cosim_foreign_terminate_sim               : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_terminate_sim";
-  attribute foreign of uvvm_cosim_foreign_report_vvc_info             : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_report_vvc_info";
-  attribute foreign of uvvm_cosim_foreign_vvc_listen_enable           : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_vvc_listen_enable";
-  attribute foreign of uvvm_cosim_foreign_transmit_byte_queue_empty   : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_byte_queue_empty";
-  attribute foreign of uvvm_cosim_foreign_transmit_byte_queue_get     : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_byte_queue_get";
-  attribute foreign of uvvm_cosim_foreign_receive_byte_queue_put      : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_byte_queue_put";
-  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_empty : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_empty";
-  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_get   : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_get";
-  attribute foreign of uvvm_cosim_foreign_receive_packet_queue_put    : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_packet_queue_put";
+  -- Beat variants of the queue get/put calls above, which move several
+  -- bytes with one call, one byte per integer_vector element. The get
+  -- calls fill up to data'length elements and return the number of bytes
+  -- in num_bytes. Packet beats never cross the end of a packet, and
+  -- end_of_packet is set to 1 for the beat that ends a packet.
+  procedure uvvm_cosim_foreign_transmit_byte_queue_get_beat(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable data            : out integer_vector;
+    variable num_bytes       : out integer);
+
+  procedure uvvm_cosim_foreign_receive_byte_queue_put_beat(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in integer_vector);
+
+  procedure uvvm_cosim_foreign_transmit_packet_queue_get_beat(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable data            : out integer_vector;
+    variable num_bytes       : out integer;
+    variable end_of_packet   : out integer);
+
+  procedure uvvm_cosim_foreign_receive_packet_queue_put_beat(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant data            : in integer_vector;
+    constant end_of_packet   : in integer);
+
+  -- Sideband signals for a packet as (tid, tdest, tuser), moved once per
+  -- packet. get_meta returns the signals of the packet currently read
+  -- from the transmit queue, and put_meta sets the signals of the packet
+  -- currently put in the receive queue. meta should have 3 elements.
+  procedure uvvm_cosim_foreign_transmit_packet_queue_get_meta(
+    constant vvc_type        : in  string;
+    constant vvc_instance_id : in  integer;
+    variable meta            : out integer_vector);
+
+  procedure uvvm_cosim_foreign_receive_packet_queue_put_meta(
+    constant vvc_type        : in string;
+    constant vvc_instance_id : in integer;
+    constant meta            : in integer_vector);
+
+  attribute foreign of uvvm_cosim_foreign_start_sim                      : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_start_sim";
+  attribute foreign of uvvm_cosim_foreign_terminate_sim                  : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_terminate_sim";
+  attribute foreign of uvvm_cosim_foreign_report_vvc_info                : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_report_vvc_info";
+  attribute foreign of uvvm_cosim_foreign_vvc_listen_enable              : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_vvc_listen_enable";
+  attribute foreign of uvvm_cosim_foreign_transmit_byte_queue_empty      : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_byte_queue_empty";
+  attribute foreign of uvvm_cosim_foreign_transmit_byte_queue_get        : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_byte_queue_get";
+  attribute foreign of uvvm_cosim_foreign_receive_byte_queue_put         : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_byte_queue_put";
+  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_empty    : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_empty";
+  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_get      : function is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_get";
+  attribute foreign of uvvm_cosim_foreign_receive_packet_queue_put       : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_packet_queue_put";
+  attribute foreign of uvvm_cosim_foreign_transmit_byte_queue_get_beat   : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_byte_queue_get_beat";
+  attribute foreign of uvvm_cosim_foreign_receive_byte_queue_put_beat    : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_byte_queue_put_beat";
+  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_get_beat : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_get_beat";
+  attribute foreign of uvvm_cosim_foreign_receive_packet_queue_put_beat  : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_packet_queue_put_beat";
+  attribute foreign of uvvm_cosim_foreign_transmit_packet_queue_get_meta : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_transmit_packet_queue_get_meta";
+  attribute foreign of uvvm_cosim_foreign_receive_packet_queue_put_meta  : procedure is "VHPI libuvvm_cosim_vhpi.so uvvm_cosim_foreign_receive_packet_queue_put_meta";
 
 end package uvvm_cosim_foreign_pkg;
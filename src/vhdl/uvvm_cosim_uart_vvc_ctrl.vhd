@@ -37,6 +37,7 @@ begin
     alias vvc_status         : t_vvc_status is shared_uart_vvc_status(TX, GC_VVC_IDX);
     constant C_CMD_QUEUE_MAX : natural := 1000;
     variable v_data          : std_logic_vector(7 downto 0);
+    variable v_poll_cycles   : natural;
   begin
 
     wait until init_done = '1';
@@ -53,7 +54,9 @@ begin
       wait until rising_edge(clk);
 
       -- Schedule VVC transmit commands
-      while uvvm_cosim_foreign_transmit_byte_queue_empty("UART_VVC", GC_VVC_IDX) = 0 loop
+      v_poll_cycles := uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX);
+
+      while v_poll_cycles = 0 loop
 
         if vvc_status.pending_cmd_cnt >= C_CMD_QUEUE_COUNT_THRESHOLD then
           exit;
@@ -68,12 +71,19 @@ begin
         -- like we do for the AXI-Stream VVC
         uart_transmit(UART_VVCT, GC_VVC_IDX, TX, v_data, "Transmit from uvvm_cosim_uart_vvc_ctrl");
 
-        if uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX) = 1 then
+        v_poll_cycles := uvvm_cosim_foreign_transmit_byte_queue_empty(C_VVC_TYPE, GC_VVC_IDX);
+
+        if v_poll_cycles /= 0 then
           log(ID_SEQUENCER, "Transmit queue now empty for VVC index " & to_string(GC_VVC_IDX), C_SCOPE);
         end if;
 
       end loop;
 
+      -- Wait before polling again if the queue was empty
+      for i in 2 to v_poll_cycles loop
+        wait until rising_edge(clk);
+      end loop;
+
     end loop;
 
   end process p_transmit;
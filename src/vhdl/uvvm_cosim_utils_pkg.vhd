@@ -21,12 +21,25 @@ package uvvm_cosim_utils_pkg is
     constant str2 : string)
     return boolean;
 
+  -- Number of bytes in a tdata word of data_width bits. Cosim moves data
+  -- as whole bytes, so this fails with a message naming the generic if
+  -- the width isn't a multiple of 8. Used for constants, so the check is
+  -- done when the design is elaborated.
+  function axis_data_bytes(
+    constant data_width : integer;
+    constant name       : string)
+    return positive;
+
   -- bfm_cfg_to_string functions create a comma-separated string
   -- of key=val pairs for whatever config options from BFM config
   -- types that we are interested in reporting to cosim.
 
+  -- data_width is the tdata width in bits of the VVC, which is not
+  -- part of the BFM config. The max tid/tdest/tuser widths supported
+  -- by the BFM are included so cosim can check sideband values.
   function bfm_cfg_to_string(
-    constant cfg : t_axistream_bfm_config)
+    constant cfg        : t_axistream_bfm_config;
+    constant data_width : positive)
     return line;
 
   function bfm_cfg_to_string(
@@ -88,11 +101,28 @@ package body uvvm_cosim_utils_pkg is
     end if;
   end function strcmp;
 
+  function axis_data_bytes(
+    constant data_width : integer;
+    constant name       : string)
+    return positive is
+  begin
+    assert data_width mod 8 = 0 and data_width >= 8
+      report name & " must be a multiple of 8 and at least 8, but is " & integer'image(data_width)
+      severity failure;
+
+    return data_width/8;
+  end function axis_data_bytes;
+
   function bfm_cfg_to_string(
-    constant cfg : t_axistream_bfm_config)
+    constant cfg        : t_axistream_bfm_config;
+    constant data_width : positive)
     return line
   is
     variable v_line : line := new string'("");
+    -- Only used for the width of their elements
+    variable v_id   : t_id_array(0 to 0);
+    variable v_dest : t_dest_array(0 to 0);
+    variable v_user : t_user_array(0 to 0);
   begin
     write(v_line, string'("cosim_support=1,"));
 
@@ -101,6 +131,11 @@ package body uvvm_cosim_utils_pkg is
     else
       write(v_line, string'("packet_based=0,"));
     end if;
+
+    write(v_line, string'("data_width=") & integer'image(data_width) & string'(","));
+    write(v_line, string'("tid_bits=") & integer'image(v_id(0)'length) & string'(","));
+    write(v_line, string'("tdest_bits=") & integer'image(v_dest(0)'length) & string'(","));
+    write(v_line, string'("tuser_bits=") & integer'image(v_user(0)'length) & string'(","));
     return v_line;
   end function bfm_cfg_to_string;
 
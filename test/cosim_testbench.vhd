@@ -36,8 +36,9 @@ architecture sim of tb is
   constant C_CLK_PERIOD       : time    := 20 ns;
   constant C_CLK_FREQ         : natural := 50000000;
   constant C_BAUDRATE         : natural := 1000000;
+  constant C_AXIS_DATA_WIDTH  : natural := 8;
 
-  subtype t_axistream_8b is t_axistream_if(tdata(7 downto 0),
+  subtype t_axistream_8b is t_axistream_if(tdata(C_AXIS_DATA_WIDTH-1 downto 0),
                                            tkeep(0 downto 0),
                                            tuser(0 downto 0),
                                            tstrb(0 downto 0),
@@ -95,7 +96,8 @@ begin
 
   inst_uvvm_cosim: entity uvvm_cosim_lib.uvvm_cosim
     generic map (
-      GC_COSIM_EN => true)
+      GC_COSIM_EN         => true,
+      GC_AXIS_DATA_WIDTHS => (others => C_AXIS_DATA_WIDTH))
     port map (
       clk             => clk,
       vvc_config_done => vvc_config_done);
@@ -132,7 +134,7 @@ begin
   i_axistream_vvc0_byte_transmit : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => true,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
@@ -146,7 +148,7 @@ begin
   i_axistream_vvc1_byte_receive : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => false,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
@@ -160,7 +162,7 @@ begin
   i_axistream_vvc2_packet_transmit : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => true,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
@@ -174,7 +176,7 @@ begin
   i_axistream_vvc3_packet_receive : entity bitvis_vip_axistream.axistream_vvc
     generic map (
       GC_VVC_IS_MASTER => false,
-      GC_DATA_WIDTH    => 8,
+      GC_DATA_WIDTH    => C_AXIS_DATA_WIDTH,
       GC_USER_WIDTH    => 1,
       GC_ID_WIDTH      => 1,
       GC_DEST_WIDTH    => 1,
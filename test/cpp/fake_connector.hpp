@@ -0,0 +1,119 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include <jsonrpccxx/common.hpp>
+#include <jsonrpccxx/iclientconnector.hpp>
+#include "uvvm_cosim_types.hpp"
+
+namespace uvvm_cosim {
+
+// Server stand-in for the client tests. Records the requests it gets, and
+// answers them with the handler for the method. Methods without a handler
+// get a successful response with the request's params as the result.
+//
+// Handlers return the result of the call. They can throw JsonRpcException
+// to answer with a JSON-RPC error, or any other exception to fail the
+// Send() call like a broken connection would. Handlers are called without
+// the lock held, so calls from several connectors overlap, and handlers
+// must protect any state of their own that the test accesses meanwhile.
+struct FakeServer {
+  using Handler = std::function<JsonResponse(const json& params)>;
+
+  std::map<std::string, Handler> handlers;
+
+  // Time each request takes
+  std::chrono::microseconds delay{0};
+
+  // Added to the id of the responses to these methods
+  std::set<std::string> wrong_id_methods;
+
+  // Protects everything below
+  std::mutex mtx;
+  std::vector<json> requests;
+  std::set<std::thread::id> callers;
+  int in_flight = 0;
+  int max_in_flight = 0;
+
+  // Requests with a VVC type and id as their first params, by "<type><id>"
+  std::map<std::string, std::vector<json>> requests_by_vvc()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    std::map<std::string, std::vector<json>> by_vvc;
+
+    for (const json& req : requests) {
+      const json& params = req["params"];
+
+      if (params.size() >= 2 && params[0].is_string() && params[1].is_number_integer()) {
+        by_vvc[params[0].get<std::string>() + std::to_string(params[1].get<int>())].push_back(req);
+      }
+    }
+
+    return by_vvc;
+  }
+
+  size_t num_requests()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return requests.size();
+  }
+};
+
+class FakeConnector : public jsonrpccxx::IClientConnector {
+public:
+  explicit FakeConnector(FakeServer& server) : server(server) {}
+
+  std::string Send(const std::string& request) override
+  {
+    json req = json::parse(request);
+    const std::string method = req["method"];
+    FakeServer::Handler handler;
+    json id = req["id"];
+
+    {
+      std::lock_guard<std::mutex> lock(server.mtx);
+      server.requests.push_back(req);
+      server.callers.insert(std::this_thread::get_id());
+      server.in_flight++;
+      server.max_in_flight = std::max(server.max_in_flight, server.in_flight);
+
+      if (auto it = server.handlers.find(method); it != server.handlers.end()) {
+        handler = it->second;
+      }
+
+      if (server.wrong_id_methods.contains(method)) {
+        id = id.get<int>() + 1;
+      }
+    }
+
+    struct InFlight {
+      FakeServer& server;
+      ~InFlight() {
+        std::lock_guard<std::mutex> lock(server.mtx);
+        server.in_flight--;
+      }
+    } in_flight{server};
+
+    std::this_thread::sleep_for(server.delay);
+
+    try {
+      JsonResponse response = handler ? handler(req["params"]) : JsonResponse{true, req["params"]};
+      return json{{"jsonrpc", "2.0"}, {"id", id}, {"result", response}}.dump();
+    }
+    catch (const jsonrpccxx::JsonRpcException& e) {
+      return json{{"jsonrpc", "2.0"}, {"id", id},
+                  {"error", {{"code", e.Code()}, {"message", e.Message()}}}}.dump();
+    }
+  }
+
+private:
+  FakeServer& server;
+};
+
+} // namespace uvvm_cosim
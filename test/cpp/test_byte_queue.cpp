@@ -1,5 +1,8 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
 #include <vector>
+#include <unistd.h>
 #include "byte_queue.hpp"
 
 using namespace uvvm_cosim;
@@ -39,6 +42,16 @@ TEST_CASE("ByteQueue_empty_and_size")
   (void) q.get(1);
   REQUIRE(q.empty() == true);
   REQUIRE(q.size() == 0);
+
+  INFO("High-water mark is the largest size, until reset");
+  REQUIRE(q.high_water_mark() == 4);
+  q.put(ByteSpan::from_data(std::vector<uint8_t>(10)));
+  q.put(v);
+  REQUIRE(q.high_water_mark() == 14);
+  (void) q.get(12);
+  REQUIRE(q.high_water_mark() == 14);
+  q.reset_high_water_mark();
+  REQUIRE(q.high_water_mark() == 2);
 }
 
 TEST_CASE("ByteQueue_put_and_get")
@@ -102,3 +115,174 @@ TEST_CASE("ByteQueue_put_and_get")
   REQUIRE(v2.size() == 10);
   REQUIRE(v1 == v2);
 }
+
+TEST_CASE("ByteQueue_find")
+{
+  INFO("ByteQueue_find test start.");
+
+  ByteQueue q;
+
+  std::vector<uint8_t> pattern {'o', 'k', '>'};
+
+  // Nothing to find in empty queue, and empty pattern never matches
+  REQUIRE_FALSE(q.find(pattern).has_value());
+  q.put(std::vector<uint8_t>{'a', 'o', 'k'});
+  REQUIRE_FALSE(q.find(std::vector<uint8_t>()).has_value());
+
+  // Partial match at end of queue
+  REQUIRE_FALSE(q.find(pattern).has_value());
+
+  // Completed match
+  q.put('>');
+  REQUIRE(q.find(pattern).has_value());
+  REQUIRE(q.find(pattern).value() == 1);
+
+  // Search starting past the match
+  REQUIRE_FALSE(q.find(pattern, 2).has_value());
+  REQUIRE_FALSE(q.find(pattern, 100).has_value());
+
+  // Offset is relative to front of queue after get
+  (void) q.get();
+  REQUIRE(q.find(pattern).value() == 0);
+  REQUIRE(q.consumed_count() == 1);
+
+  // Candidates for first byte that don't match the rest are skipped
+  q.put(std::vector<uint8_t>{'o', 'o', 'k', 'o', 'k', '>'});
+  REQUIRE(q.find(pattern, 1).value() == 6);
+
+  // Single byte pattern
+  REQUIRE(q.find(std::vector<uint8_t>{'>'}).value() == 2);
+  REQUIRE(q.find(std::vector<uint8_t>{'>'}, 3).value() == 8);
+}
+
+TEST_CASE("ByteQueue_large_put_and_get")
+{
+  INFO("ByteQueue_large_put_and_get test start.");
+
+  ByteQueue q;
+
+  // Interleave puts and gets so consumed space at the front of the
+  // buffer is reclaimed a number of times, and check data stays in order
+  uint8_t next_put = 0;
+  uint8_t next_get = 0;
+
+  for (int i = 0; i < 100; i++) {
+    std::vector<uint8_t> v(1000);
+    for (auto &b : v) {
+      b = next_put++;
+    }
+    q.put(v);
+
+    std::vector<uint8_t> data = q.get(700);
+    REQUIRE(data.size() == 700);
+    for (auto b : data) {
+      REQUIRE(b == next_get++);
+    }
+  }
+
+  REQUIRE(q.size() == 100*300);
+  REQUIRE(q.consumed_count() == 100*700);
+
+  std::vector<uint8_t> data = q.get(0);
+  REQUIRE(data.size() == 100*300);
+  for (auto b : data) {
+    REQUIRE(b == next_get++);
+  }
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("ByteQueue_put_span")
+{
+  INFO("ByteQueue_put_span test start.");
+
+  // Write a test file larger than the window data is copied from spans in
+  std::vector<uint8_t> file_data(200000);
+  for (size_t i = 0; i < file_data.size(); i++) {
+    file_data[i] = i * 7;
+  }
+
+  char path[] = "/tmp/test_byte_queue_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  REQUIRE(write(fd, file_data.data(), file_data.size()) == (ssize_t) file_data.size());
+  close(fd);
+
+  auto file = MappedFile::open(path, 1000, 150000);
+  unlink(path);
+
+  REQUIRE(file->size() == 150000);
+  REQUIRE_THROWS(MappedFile::open("/nonexistent/file"));
+
+  ByteQueue q;
+
+  // Bytes put before and after the span must come out in order
+  std::vector<uint8_t> expected = {1, 2, 3};
+  q.put(std::vector<uint8_t>{1, 2, 3});
+  q.put(ByteSpan::from_file(file));
+  q.put(uint8_t(4));
+  q.put(std::vector<uint8_t>{5, 6});
+
+  expected.insert(expected.end(), file_data.begin() + 1000, file_data.begin() + 151000);
+  expected.insert(expected.end(), {4, 5, 6});
+
+  REQUIRE(q.size() == expected.size());
+
+  std::vector<uint8_t> data;
+  for (int i = 0; i < 10; i++) {
+    data.push_back(q.get().value());
+  }
+
+  std::vector<uint8_t> chunk = q.get(100000);
+  REQUIRE(chunk.size() == 100000);
+  data.insert(data.end(), chunk.begin(), chunk.end());
+  REQUIRE(q.size() == expected.size() - data.size());
+
+  // find() has to search data that is still in spans
+  std::vector<uint8_t> tail(expected.end() - 5, expected.end());
+  REQUIRE(q.find(tail).value() == q.size() - 5);
+
+  chunk = q.get(0);
+  data.insert(data.end(), chunk.begin(), chunk.end());
+
+  REQUIRE(data == expected);
+  REQUIRE(q.empty());
+  REQUIRE_FALSE(q.get().has_value());
+}
+
+TEST_CASE("ByteQueue_stamps")
+{
+  INFO("ByteQueue_stamps test start.");
+
+  ByteQueue q;
+
+  // Bytes put with the same stamp share a run
+  q.put(uint8_t(1), SimStamp{10, 1});
+  q.put(std::vector<uint8_t>{2, 3}, SimStamp{10, 1});
+  q.put(uint8_t(4), SimStamp{20, 2});
+  q.put(std::vector<uint8_t>{5, 6, 7}, SimStamp{30, 3});
+
+  std::vector<SimStampRun> stamps;
+
+  INFO("Get splits a run");
+  REQUIRE(q.get(2, &stamps) == std::vector<uint8_t>{1, 2});
+  REQUIRE(stamps.size() == 1);
+  REQUIRE(stamps[0].count == 2);
+  REQUIRE(stamps[0].stamp == SimStamp{10, 1});
+
+  INFO("Single byte get drops the stamp");
+  REQUIRE(q.get().value() == 3);
+
+  stamps.clear();
+  REQUIRE(q.get(3, &stamps) == std::vector<uint8_t>{4, 5, 6});
+  REQUIRE(stamps.size() == 2);
+  REQUIRE(stamps[0].count == 1);
+  REQUIRE(stamps[0].stamp == SimStamp{20, 2});
+  REQUIRE(stamps[1].count == 2);
+  REQUIRE(stamps[1].stamp == SimStamp{30, 3});
+
+  stamps.clear();
+  REQUIRE(q.get(0, &stamps) == std::vector<uint8_t>{7});
+  REQUIRE(stamps.size() == 1);
+  REQUIRE(stamps[0].count == 1);
+  REQUIRE(q.empty());
+}
@@ -0,0 +1,118 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <thread>
+#include "lock_stats.hpp"
+#include "shared_map.hpp"
+
+using namespace uvvm_cosim;
+using namespace std::chrono_literals;
+
+TEST_CASE("DurationHistogram")
+{
+  INFO("DurationHistogram test start.");
+
+  DurationHistogram h;
+  REQUIRE(h.percentile_ns(0.5) == 0);
+
+  h.add(0);
+  h.add(1);
+  h.add(2);
+  h.add(3);
+  h.add(1000);
+  h.add(uint64_t(1) << 40);
+
+  INFO("Power of two buckets, with everything too large in the last one");
+  REQUIRE(h.buckets[0] == 2);
+  REQUIRE(h.buckets[1] == 2);
+  REQUIRE(h.buckets[9] == 1);
+  REQUIRE(h.buckets[DurationHistogram::NUM_BUCKETS - 1] == 1);
+  REQUIRE(h.count == 6);
+  REQUIRE(h.total_ns == 1006 + (uint64_t(1) << 40));
+  REQUIRE(h.max_ns == uint64_t(1) << 40);
+
+  INFO("Percentiles are bucket upper bounds, capped by the max");
+  REQUIRE(h.percentile_ns(0.5) == 4);
+  REQUIRE(h.percentile_ns(0.7) == 1024);
+  REQUIRE(h.percentile_ns(1.0) == uint64_t(1) << 40);
+}
+
+TEST_CASE("InstrumentedMutex")
+{
+  INFO("InstrumentedMutex test start.");
+
+  shared_map<std::map<int, int>, InstrumentedMutex> map;
+
+  INFO("Nothing is recorded while disabled");
+  map([](auto& m) { m[0] = 0; });
+  REQUIRE(map.mutex().report(false).empty());
+
+  map.mutex().set_enabled(true);
+
+  INFO("Acquisitions are attributed to the innermost LockOp");
+  {
+    LockOp outer(LOK_RPC, "TransmitBytes");
+    map([](auto& m) { m[0]++; });
+
+    {
+      LockOp inner(LOK_FOREIGN, "receive_byte_queue_put");
+      map([](auto& m) { m[0]++; });
+      map([](auto& m) { m[0]++; });
+    }
+
+    map([](auto& m) { m[0]++; });
+  }
+  map([](auto& m) { m[0]++; });
+
+  auto report = map.mutex().report(false);
+  REQUIRE(report.size() == 3);
+  REQUIRE(report.at("TransmitBytes").kind == LOK_RPC);
+  REQUIRE(report.at("TransmitBytes").wait.count == 2);
+  REQUIRE(report.at("TransmitBytes").hold.count == 2);
+  REQUIRE(report.at("receive_byte_queue_put").kind == LOK_FOREIGN);
+  REQUIRE(report.at("receive_byte_queue_put").wait.count == 2);
+  REQUIRE(report.at("other").kind == LOK_OTHER);
+
+  INFO("Wait and hold times are recorded for the thread that waited and the thread that held the lock");
+  {
+    std::atomic<bool> locked = false;
+
+    std::thread holder([&]() {
+      LockOp op(LOK_RPC, "holder");
+      map([&](auto& m) {
+        locked = true;
+        std::this_thread::sleep_for(20ms);
+      });
+    });
+
+    while (!locked) {
+      std::this_thread::yield();
+    }
+
+    LockOp op(LOK_FOREIGN, "waiter");
+    map([](auto& m) {});
+
+    holder.join();
+  }
+
+  report = map.mutex().report(true);
+  REQUIRE(report.at("holder").hold.max_ns >= 10000000);
+  REQUIRE(report.at("waiter").wait.max_ns >= 1000000);
+
+  INFO("Reset clears the histograms");
+  report = map.mutex().report(false);
+  REQUIRE(report.at("holder").hold.count == 0);
+  REQUIRE(report.at("waiter").wait.count == 0);
+
+  INFO("wait_for works with the instrumented mutex");
+  std::thread writer([&]() {
+    std::this_thread::sleep_for(5ms);
+    map([](auto& m) { m[1] = 1; });
+    map.notify_all();
+  });
+
+  REQUIRE(map.wait_for(1s, [](auto& m) { return m.count(1) != 0; }));
+  writer.join();
+}
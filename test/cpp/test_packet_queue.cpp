@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <algorithm>
 #include <array>
 #include <cstdlib>
 #include <vector>
@@ -30,16 +31,20 @@ TEST_CASE("PacketQueue_empty_and_size")
   REQUIRE(q.empty());
   REQUIRE(q.size() == 0);
 
+  REQUIRE(q.size_bytes() == 0);
+
   INFO("Complete packet and expect queue to be not empty");
   q.put_byte(0x03, true);
   REQUIRE_FALSE(q.empty());
   REQUIRE(q.size() == 1);
+  REQUIRE(q.size_bytes() == 3);
 
   INFO("Get some bytes from packet. Queue should remain non-empty until whole packet is read out");
   (void) q.get_byte();
   (void) q.get_byte();
   REQUIRE_FALSE(q.empty());
   REQUIRE(q.size() == 1);
+  REQUIRE(q.size_bytes() == 1);
 
   INFO("Get last byte in packet. Queue should go empty.");
   (void) q.get_byte();
@@ -280,3 +285,233 @@ TEST_CASE("PacketQueue_mixed")
   REQUIRE(q.empty());
   REQUIRE(q.size() == 0);
 }
+
+TEST_CASE("PacketQueue_put_pkts")
+{
+  INFO("PacketQueue_put_pkts test start.");
+
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = i;
+  }
+
+  PacketQueue q;
+
+  q.put_pkt(std::vector<uint8_t>{0xAA});
+  q.put_pkts(ByteSpan::from_data(data), 300);
+  q.put_pkt(std::vector<uint8_t>{0xBB, 0xCC});
+  q.put_pkts(ByteSpan::from_data(data), 0);
+
+  // 1 + 4 (300, 300, 300, 100) + 1 + 1
+  REQUIRE(q.size() == 7);
+  REQUIRE(q.size_bytes() == 2003);
+
+  REQUIRE(q.get_pkt() == std::vector<uint8_t>{0xAA});
+
+  for (size_t pos = 0; pos < data.size(); pos += 300) {
+    size_t len = std::min<size_t>(300, data.size() - pos);
+    std::vector<uint8_t> expected(data.begin() + pos, data.begin() + pos + len);
+
+    // Read the first packet from the span byte by byte
+    if (pos == 0) {
+      std::vector<uint8_t> pkt;
+      bool eop = false;
+      while (!eop) {
+        auto byte = q.get_byte();
+        REQUIRE(byte.has_value());
+        pkt.push_back(byte.value().first);
+        eop = byte.value().second;
+      }
+      REQUIRE(pkt == expected);
+    } else {
+      REQUIRE(q.get_pkt() == expected);
+    }
+  }
+
+  REQUIRE(q.size() == 2);
+  REQUIRE(q.size_bytes() == 1002);
+  REQUIRE(q.get_pkt() == std::vector<uint8_t>{0xBB, 0xCC});
+  REQUIRE(q.get_pkt() == data);
+  REQUIRE(q.empty());
+  REQUIRE(q.size() == 0);
+  REQUIRE(q.size_bytes() == 0);
+}
+
+TEST_CASE("PacketQueue_stamps")
+{
+  INFO("PacketQueue_stamps test start.");
+
+  PacketQueue q;
+  PacketStamp stamp;
+
+  q.put_pkt({1, 2, 3}, SimStamp{10, 1});
+
+  // Packet put byte by byte gets the stamps of its first and last byte
+  q.put_byte(4, false, SimStamp{20, 2});
+  q.put_byte(5, false, SimStamp{30, 3});
+  q.put_byte(6, true, SimStamp{40, 4});
+
+  REQUIRE(q.get_pkt(&stamp) == std::vector<uint8_t>{1, 2, 3});
+  REQUIRE(stamp.first == SimStamp{10, 1});
+  REQUIRE(stamp.last == SimStamp{10, 1});
+
+  REQUIRE(q.get_pkt(&stamp) == std::vector<uint8_t>{4, 5, 6});
+  REQUIRE(stamp.first == SimStamp{20, 2});
+  REQUIRE(stamp.last == SimStamp{40, 4});
+
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("PacketQueue_beats")
+{
+  INFO("PacketQueue_beats test start.");
+
+  PacketQueue q;
+  bool eop = true;
+
+  REQUIRE(q.get_bytes(4, eop).empty());
+  REQUIRE_FALSE(eop);
+
+  // Packet put a beat at a time is only queued at end of packet
+  q.put_bytes({1, 2, 3, 4}, false, SimStamp{10, 1});
+  REQUIRE(q.empty());
+  q.put_bytes({5, 6}, true, SimStamp{20, 2});
+  q.put_pkt({7, 8, 9});
+  REQUIRE(q.size() == 2);
+
+  INFO("Beats don't cross the end of a packet");
+  REQUIRE(q.get_bytes(4, eop) == std::vector<uint8_t>{1, 2, 3, 4});
+  REQUIRE_FALSE(eop);
+  REQUIRE(q.get_bytes(4, eop) == std::vector<uint8_t>{5, 6});
+  REQUIRE(eop);
+  REQUIRE(q.size() == 1);
+
+  REQUIRE(q.get_bytes(0, eop).empty());
+  REQUIRE_FALSE(eop);
+
+  // Mixed with byte access
+  auto byte = q.get_byte();
+  REQUIRE(byte.value().first == 7);
+  REQUIRE_FALSE(byte.value().second);
+  REQUIRE(q.get_bytes(3, eop) == std::vector<uint8_t>{8, 9});
+  REQUIRE(eop);
+  REQUIRE(q.empty());
+
+  INFO("Beats from packets put as spans");
+  std::vector<uint8_t> data = {10, 11, 12, 13, 14};
+  q.put_pkts(ByteSpan::from_data(data), 3);
+  REQUIRE(q.get_bytes(8, eop) == std::vector<uint8_t>{10, 11, 12});
+  REQUIRE(eop);
+  REQUIRE(q.get_bytes(1, eop) == std::vector<uint8_t>{13});
+  REQUIRE_FALSE(eop);
+  REQUIRE(q.get_bytes(1, eop) == std::vector<uint8_t>{14});
+  REQUIRE(eop);
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("PacketQueue_meta")
+{
+  INFO("PacketQueue_meta test start.");
+
+  PacketQueue q;
+  PacketMeta meta;
+
+  REQUIRE(q.get_meta() == PacketMeta{});
+
+  q.put_pkt({1, 2}, SimStamp{}, PacketMeta{1, 2, 3});
+
+  // Set before or during a packet put a beat or byte at a time
+  q.put_meta(PacketMeta{4, 5, 6});
+  q.put_bytes({3, 4}, false);
+  q.put_byte(5, true);
+
+  // Reset after end of packet
+  q.put_byte(6, true);
+
+  REQUIRE(q.get_meta() == PacketMeta{1, 2, 3});
+  REQUIRE(q.get_pkt(nullptr, &meta) == std::vector<uint8_t>{1, 2});
+  REQUIRE(meta == PacketMeta{1, 2, 3});
+
+  INFO("Meta is for the packet being read");
+  bool eop;
+  REQUIRE(q.get_bytes(2, eop) == std::vector<uint8_t>{3, 4});
+  REQUIRE(q.get_meta() == PacketMeta{4, 5, 6});
+  REQUIRE(q.get_bytes(2, eop) == std::vector<uint8_t>{5});
+  REQUIRE(eop);
+
+  REQUIRE(q.get_pkt(nullptr, &meta) == std::vector<uint8_t>{6});
+  REQUIRE(meta == PacketMeta{});
+
+  INFO("Meta is kept for packets queued behind spans");
+  std::vector<uint8_t> data = {7, 8};
+  q.put_pkts(ByteSpan::from_data(data), 0);
+  q.put_pkt({9}, SimStamp{}, PacketMeta{7, 8, 9});
+  REQUIRE(q.get_meta() == PacketMeta{});
+  REQUIRE(q.get_pkt() == data);
+  REQUIRE(q.get_meta() == PacketMeta{7, 8, 9});
+  REQUIRE(q.get_pkt(nullptr, &meta) == std::vector<uint8_t>{9});
+  REQUIRE(meta == PacketMeta{7, 8, 9});
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("PacketQueue_segments")
+{
+  INFO("PacketQueue_segments test start. Jumbo packet handed out in bounded segments.");
+
+  PacketQueue q;
+  std::vector<uint8_t> jumbo(9000);
+  for (size_t i = 0; i < jumbo.size(); i++) {
+    jumbo[i] = i & 0xFF;
+  }
+
+  q.put_pkts(ByteSpan::from_data(jumbo), 0);
+  q.put_pkt({1, 2, 3});
+
+  std::vector<uint8_t> pkt;
+  bool eop = false;
+  int segments = 0;
+
+  while (!eop) {
+    auto segment = q.get_bytes(4096, eop);
+    REQUIRE(segment.size() <= 4096);
+    REQUIRE_FALSE(segment.empty());
+    pkt.insert(pkt.end(), segment.begin(), segment.end());
+    segments++;
+  }
+
+  REQUIRE(segments == 3);
+  REQUIRE(pkt == jumbo);
+
+  // Next packet starts in a new segment
+  REQUIRE(q.get_bytes(4096, eop) == std::vector<uint8_t>{1, 2, 3});
+  REQUIRE(eop);
+  REQUIRE(q.empty());
+}
+
+TEST_CASE("PacketQueue_high_water_marks")
+{
+  INFO("PacketQueue_high_water_marks test start.");
+
+  PacketQueue q;
+
+  q.put_pkt({1, 2, 3});
+  q.put_byte(4, false);
+  q.put_byte(5, true);
+  REQUIRE(q.high_water_mark() == 2);
+  REQUIRE(q.high_water_mark_bytes() == 5);
+
+  q.put_pkts(ByteSpan::from_data(std::vector<uint8_t>(100)), 10);
+  REQUIRE(q.high_water_mark() == 12);
+  REQUIRE(q.high_water_mark_bytes() == 105);
+
+  while (!q.empty()) {
+    (void) q.get_pkt();
+  }
+
+  INFO("Marks stay until reset");
+  REQUIRE(q.high_water_mark() == 12);
+  q.put_pkt({1});
+  q.reset_high_water_marks();
+  REQUIRE(q.high_water_mark() == 1);
+  REQUIRE(q.high_water_mark_bytes() == 1);
+}
@@ -0,0 +1,140 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "receive_sink.hpp"
+
+using namespace uvvm_cosim;
+
+static std::string temp_path(void)
+{
+  char path[] = "/tmp/test_receive_sink_XXXXXX";
+  int fd = mkstemp(path);
+  REQUIRE(fd >= 0);
+  close(fd);
+  return path;
+}
+
+static std::vector<uint8_t> read_file(const std::string& path)
+{
+  std::ifstream f(path, std::ios::binary);
+  return std::vector<uint8_t>(std::istreambuf_iterator<char>(f), {});
+}
+
+static uint32_t get_u32(const std::vector<uint8_t>& buf, size_t pos)
+{
+  uint32_t value;
+  std::memcpy(&value, buf.data() + pos, sizeof(value));
+  return value;
+}
+
+TEST_CASE("ReceiveSink_raw")
+{
+  INFO("ReceiveSink_raw test start.");
+
+  std::string path = temp_path();
+  std::vector<uint8_t> expected;
+
+  {
+    ReceiveSink sink(path, ReceiveSink::parse_format("raw"), false);
+
+    // Enough data for a few write batches, plus a partial chunk at the end
+    for (int i = 0; i < 1000000; i++) {
+      sink.put_byte(i, false, i);
+      expected.push_back(i);
+    }
+
+    sink.put(std::vector<uint8_t>{1, 2, 3}, false, 0);
+    expected.insert(expected.end(), {1, 2, 3});
+
+    REQUIRE(sink.bytes() == expected.size());
+    REQUIRE(sink.packets() == 0);
+
+    INFO("Nothing can be put after close");
+    sink.close();
+    REQUIRE_FALSE(sink.put_byte(4, false, 0));
+    REQUIRE_FALSE(sink.put(std::vector<uint8_t>{5}, false, 0));
+    REQUIRE(sink.bytes() == expected.size());
+  }
+
+  REQUIRE(read_file(path) == expected);
+  unlink(path.c_str());
+
+  REQUIRE_THROWS(ReceiveSink::parse_format("pcap"));
+  REQUIRE_THROWS(ReceiveSink("/nonexistent/dir/file", ReceiveSink::RSF_RAW, false));
+}
+
+TEST_CASE("ReceiveSink_pcapng")
+{
+  INFO("ReceiveSink_pcapng test start.");
+
+  REQUIRE_THROWS(ReceiveSink("/dev/null", ReceiveSink::RSF_PCAPNG, false));
+
+  std::string path = temp_path();
+
+  std::vector<std::vector<uint8_t>> packets = {
+    {0x01, 0x02, 0x03, 0x04, 0x05},
+    {0x11, 0x12, 0x13, 0x14},
+    {0x21}
+  };
+  std::vector<uint64_t> times = {100, 0x100000000ULL + 5, 12345};
+
+  ReceiveSink sink(path, ReceiveSink::RSF_PCAPNG, true, 147);
+
+  sink.put(packets[0], true, times[0]);
+
+  for (size_t i = 0; i < packets[1].size(); i++) {
+    sink.put_byte(packets[1][i], i == packets[1].size() - 1, times[1]);
+  }
+
+  sink.put_byte(packets[2][0], true, times[2]);
+
+  // Partial packet is not written
+  sink.put_byte(0xFF, false, 0);
+
+  sink.close();
+
+  REQUIRE(sink.error().empty());
+  REQUIRE(sink.packets() == 3);
+  REQUIRE(sink.bytes() == 11);
+
+  std::vector<uint8_t> data = read_file(path);
+  unlink(path.c_str());
+
+  // Section header block
+  REQUIRE(get_u32(data, 0) == 0x0A0D0D0A);
+  REQUIRE(get_u32(data, 4) == 28);
+  REQUIRE(get_u32(data, 8) == 0x1A2B3C4D);
+
+  // Interface description block with link type and ns timestamp resolution
+  size_t pos = 28;
+  REQUIRE(get_u32(data, pos) == 1);
+  REQUIRE(get_u32(data, pos + 4) == 32);
+  REQUIRE((get_u32(data, pos + 8) & 0xFFFF) == 147);
+  REQUIRE(data[pos + 20] == 9);
+  pos += 32;
+
+  // Enhanced packet blocks
+  for (size_t i = 0; i < packets.size(); i++) {
+    uint32_t block_len = get_u32(data, pos + 4);
+    REQUIRE(get_u32(data, pos) == 6);
+    REQUIRE(block_len % 4 == 0);
+    REQUIRE(get_u32(data, pos + block_len - 4) == block_len);
+
+    uint64_t ts = (uint64_t(get_u32(data, pos + 12)) << 32) | get_u32(data, pos + 16);
+    REQUIRE(ts == times[i]);
+    REQUIRE(get_u32(data, pos + 20) == packets[i].size());
+
+    std::vector<uint8_t> pkt(data.begin() + pos + 28, data.begin() + pos + 28 + packets[i].size());
+    REQUIRE(pkt == packets[i]);
+
+    pos += block_len;
+  }
+
+  REQUIRE(pos == data.size());
+}
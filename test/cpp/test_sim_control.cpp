@@ -0,0 +1,72 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "sim_control.hpp"
+
+using namespace uvvm_cosim;
+
+TEST_CASE("SimControl_free_running")
+{
+  INFO("SimControl_free_running test start.");
+
+  SimControl ctrl;
+
+  // Without lockstep mode cycle() never blocks
+  for (uint64_t t = 10; t <= 1000; t += 10) {
+    ctrl.cycle(t, t / 10);
+  }
+
+  SimControl::Progress progress = ctrl.get_progress();
+  REQUIRE(progress.sim_time_ns == 1000);
+  REQUIRE(progress.cycles == 100);
+
+  REQUIRE(ctrl.run_for(10, SimControl::SCU_CYCLES, progress) == false);
+
+  REQUIRE(SimControl::parse_unit("ns") == SimControl::SCU_NS);
+  REQUIRE(SimControl::parse_unit("cycles") == SimControl::SCU_CYCLES);
+  REQUIRE_THROWS(SimControl::parse_unit("us"));
+}
+
+TEST_CASE("SimControl_lockstep")
+{
+  INFO("SimControl_lockstep test start.");
+
+  SimControl ctrl;
+  ctrl.set_lockstep(true);
+
+  // Simulator with a 10 ns clock that runs until terminated
+  std::atomic<bool> done = false;
+  std::thread sim([&]() {
+    for (uint64_t t = 10; !done; t += 10) {
+      ctrl.cycle(t, t / 10);
+    }
+  });
+
+  SimControl::Progress progress;
+
+  INFO("Simulator stops at the first cycle");
+  REQUIRE(ctrl.run_for(0, SimControl::SCU_CYCLES, progress));
+  REQUIRE(progress.cycles == 1);
+  REQUIRE(progress.sim_time_ns == 10);
+
+  INFO("Run a number of cycles");
+  REQUIRE(ctrl.run_for(5, SimControl::SCU_CYCLES, progress));
+  REQUIRE(progress.cycles == 6);
+  REQUIRE(progress.sim_time_ns == 60);
+
+  INFO("Run for a time that is not a multiple of the clock period");
+  REQUIRE(ctrl.run_for(25, SimControl::SCU_NS, progress));
+  REQUIRE(progress.sim_time_ns == 90);
+  REQUIRE(progress.cycles == 9);
+
+  // The simulator has stopped, so progress doesn't change
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  REQUIRE(ctrl.get_progress().cycles == 9);
+
+  done = true;
+  ctrl.terminate();
+  sim.join();
+
+  REQUIRE(ctrl.run_for(1, SimControl::SCU_CYCLES, progress) == false);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include "sim_progress.hpp"
+
+using namespace uvvm_cosim;
+
+static bool near(double value, double expected, double rel)
+{
+  return std::abs(value - expected) <= rel * std::abs(expected);
+}
+
+TEST_CASE("SimProgress_rates")
+{
+  INFO("SimProgress_rates test start.");
+
+  using namespace std::chrono_literals;
+
+  SimProgress progress(100ms, 1024);
+  SimProgress::Clock::time_point t0 = SimProgress::Clock::now();
+
+  INFO("No samples yet");
+  SimProgress::Report r = progress.report({t0, 0, 0}, {1.0});
+  REQUIRE(r.rates.size() == 1);
+  REQUIRE(r.rates[0].cycles_per_s == 0.0);
+
+  // 20 s at 1000 cycles/s with a 10 ns clock, cycle() called every 10 ms,
+  // then 10 s at 500 cycles/s
+  uint64_t cycles = 0;
+  auto wall = t0;
+
+  for (int i = 0; i < 2000; i++) {
+    cycles += 10;
+    wall += 10ms;
+    progress.cycle(cycles * 10, cycles, wall);
+  }
+
+  for (int i = 0; i < 1000; i++) {
+    cycles += 5;
+    wall += 10ms;
+    progress.cycle(cycles * 10, cycles, wall);
+  }
+
+  r = progress.report({wall, cycles * 10, cycles}, {1.0, 10.0, 60.0});
+
+  REQUIRE(r.cycles == 25000);
+  REQUIRE(r.sim_time_ns == 250000);
+  REQUIRE(near(r.wall_time_s, 29.99, 0.001));
+
+  REQUIRE(r.rates.size() == 3);
+  REQUIRE(near(r.rates[0].cycles_per_s, 500.0, 0.01));
+  REQUIRE(near(r.rates[0].sim_ns_per_s, 5000.0, 0.01));
+  REQUIRE(near(r.rates[1].cycles_per_s, 500.0, 0.01));
+
+  // The history is shorter than 60 s, so the whole run is measured
+  REQUIRE(near(r.rates[2].cycles_per_s, 24990.0 / 29.99, 0.01));
+
+  INFO("Rates drop while the simulator doesn't advance");
+  r = progress.report({wall + 10s, cycles * 10, cycles}, {1.0, 20.0});
+  REQUIRE(r.rates[0].cycles_per_s < 10.0);
+  REQUIRE(near(r.rates[1].cycles_per_s, 250.0, 0.02));
+}
+
+TEST_CASE("SimProgress_ring_buffer")
+{
+  INFO("SimProgress_ring_buffer test start.");
+
+  using namespace std::chrono_literals;
+
+  // Only room for 10 samples, so older history is dropped
+  SimProgress progress(1s, 10);
+  auto wall = SimProgress::Clock::now();
+
+  for (uint64_t c = 1; c <= 100; c++) {
+    progress.cycle(c, c, wall);
+    wall += 1s;
+  }
+
+  // Oldest sample left is cycle 91, stored 10 s ago
+  SimProgress::Report r = progress.report({wall, 100, 100}, {60.0});
+  REQUIRE(near(r.rates[0].cycles_per_s, 0.9, 0.001));
+  REQUIRE(near(r.wall_time_s, 100.0, 0.001));
+}
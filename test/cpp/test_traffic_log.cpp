@@ -0,0 +1,208 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "traffic_log.hpp"
+#include "uvvm_cosim_data.hpp"
+#include "uvvm_cosim_types.hpp"
+
+using namespace uvvm_cosim;
+
+static const VvcInstanceKey uart_tx {"UART_VVC", "TX", 0};
+static const VvcInstanceKey uart_rx {"UART_VVC", "RX", 1};
+static const VvcInstanceKey axis_tx {"AXISTREAM_VVC", "NA", 2};
+static const VvcInstanceKey axis_rx {"AXISTREAM_VVC", "NA", 3};
+
+static std::string temp_log_path(const std::string& name)
+{
+  return std::string(P_tmpdir) + "/uvvm_cosim_" + name + ".log";
+}
+
+static bool same_vvc(const VvcInstanceKey& lhs, const VvcInstanceKey& rhs)
+{
+  return
+    lhs.vvc_type == rhs.vvc_type &&
+    lhs.vvc_channel == rhs.vvc_channel &&
+    lhs.vvc_instance_id == rhs.vvc_instance_id;
+}
+
+// Records a short session: Bytes from UART 0 to UART 1, and a packet
+// from AXI-Stream 2 to AXI-Stream 3
+static void write_session(const std::string& path)
+{
+  TrafficLogWriter log(path);
+
+  log.write(QID_TRANSMIT, uart_tx, 100, std::vector<uint8_t>{1, 2, 3}, 0);
+  log.write(QID_TRANSMIT, axis_tx, 100, std::vector<uint8_t>{10, 11, 12, 13}, TLF_PACKET | TLF_EOP);
+
+  // Received a byte at a time, should be coalesced per sim time
+  log.write(QID_RECEIVE, uart_rx, 200, 1, 0);
+  log.write(QID_RECEIVE, uart_rx, 200, 2, 0);
+  log.write(QID_RECEIVE, uart_rx, 300, 3, 0);
+
+  log.write(QID_RECEIVE, axis_rx, 400, 10, TLF_PACKET);
+  log.write(QID_RECEIVE, axis_rx, 400, 11, TLF_PACKET);
+  log.write(QID_RECEIVE, axis_rx, 400, 12, TLF_PACKET);
+  log.write(QID_RECEIVE, axis_rx, 400, 13, TLF_PACKET | TLF_EOP);
+}
+
+TEST_CASE("TrafficLog_write_and_read")
+{
+  INFO("TrafficLog_write_and_read test start.");
+
+  std::string path = temp_log_path("write_and_read");
+  write_session(path);
+
+  TrafficLogReader reader(path);
+
+  struct Expected {
+    QueueId qid;
+    VvcInstanceKey vvc;
+    uint64_t sim_time_ns;
+    uint8_t flags;
+    std::vector<uint8_t> data;
+  };
+
+  std::vector<Expected> expected = {
+    {QID_TRANSMIT, uart_tx, 100, 0, {1, 2, 3}},
+    {QID_TRANSMIT, axis_tx, 100, TLF_PACKET | TLF_EOP, {10, 11, 12, 13}},
+    {QID_RECEIVE, uart_rx, 200, 0, {1, 2}},
+    {QID_RECEIVE, uart_rx, 300, 0, {3}},
+    {QID_RECEIVE, axis_rx, 400, TLF_PACKET | TLF_EOP, {10, 11, 12, 13}},
+  };
+
+  for (auto &e : expected) {
+    auto rec = reader.next();
+    REQUIRE(rec.has_value());
+    REQUIRE(rec->hdr->direction == e.qid);
+    REQUIRE(same_vvc(reader.vvc(rec->hdr->vvc_handle), e.vvc));
+    REQUIRE(rec->hdr->sim_time_ns == e.sim_time_ns);
+    REQUIRE(rec->hdr->flags == e.flags);
+    REQUIRE(std::vector<uint8_t>(rec->payload, rec->payload + rec->hdr->payload_size) == e.data);
+    REQUIRE(rec->hdr->wall_time_ns > 0);
+  }
+
+  REQUIRE_FALSE(reader.next().has_value());
+  REQUIRE_THROWS(reader.vvc(100));
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("TrafficLog_invalid_file")
+{
+  INFO("TrafficLog_invalid_file test start.");
+
+  std::string path = temp_log_path("invalid_file");
+
+  REQUIRE_THROWS(TrafficLogReader(path + ".does_not_exist"));
+
+  std::FILE* f = std::fopen(path.c_str(), "wb");
+  std::fputs("This is not a traffic log", f);
+  std::fclose(f);
+
+  REQUIRE_THROWS(TrafficLogReader(path));
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("TrafficLog_write_error")
+{
+  INFO("TrafficLog_write_error test start.");
+
+  std::string path = temp_log_path("write_error");
+
+  INFO("No error for a successful capture");
+  {
+    TrafficLogWriter log(path);
+    log.write(QID_TRANSMIT, uart_tx, 100, std::vector<uint8_t>{1, 2, 3}, 0);
+    log.close();
+    REQUIRE(log.error().empty());
+
+    INFO("Writes after close are ignored");
+    log.write(QID_TRANSMIT, uart_tx, 200, std::vector<uint8_t>{4}, 0);
+    log.flush();
+  }
+  std::remove(path.c_str());
+
+  INFO("The first error is kept when the device is full");
+  TrafficLogWriter log("/dev/full");
+  log.write(QID_TRANSMIT, uart_tx, 100, std::vector<uint8_t>{1, 2, 3}, 0);
+  log.close();
+  REQUIRE(log.error().find("No space left on device") != std::string::npos);
+}
+
+TEST_CASE("TrafficReplay_transmit_and_verify")
+{
+  INFO("TrafficReplay_transmit_and_verify test start.");
+
+  std::string path = temp_log_path("replay");
+  write_session(path);
+
+  UvvmCosimData cosim_data;
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(uart_rx, {});
+  cosim_data.AddVvc(axis_tx, {{"packet_based", 1}});
+  cosim_data.AddVvc(axis_rx, {{"packet_based", 1}});
+
+  TrafficReplay replay(path, cosim_data, 1000);
+
+  INFO("Nothing transmitted before recorded sim time, receive VVCs listening");
+  REQUIRE_FALSE(replay.tick(50));
+  REQUIRE(cosim_data.byte_queue_empty(QID_TRANSMIT, uart_tx));
+  REQUIRE(cosim_data.packet_queue_empty(QID_TRANSMIT, axis_tx));
+  REQUIRE(cosim_data.GetVvcListenEnable(uart_rx));
+  REQUIRE(cosim_data.GetVvcListenEnable(axis_rx));
+
+  INFO("Transmit data fed at recorded sim time");
+  REQUIRE_FALSE(replay.tick(100));
+  REQUIRE(cosim_data.byte_queue_get(QID_TRANSMIT, uart_tx, 0) == std::vector<uint8_t>{1, 2, 3});
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_TRANSMIT, axis_tx) == std::vector<uint8_t>{10, 11, 12, 13});
+
+  INFO("Receive the recorded data");
+  for (uint8_t b : {1, 2, 3}) {
+    replay.receive(uart_rx, b, false, false);
+  }
+  REQUIRE_FALSE(replay.tick(300));
+
+  replay.receive(axis_rx, 10, false, true);
+  replay.receive(axis_rx, 11, false, true);
+  replay.receive(axis_rx, 12, false, true);
+  replay.receive(axis_rx, 13, true, true);
+
+  REQUIRE(replay.tick(400));
+  REQUIRE(replay.passed());
+
+  std::remove(path.c_str());
+}
+
+TEST_CASE("TrafficReplay_mismatch_and_timeout")
+{
+  INFO("TrafficReplay_mismatch_and_timeout test start.");
+
+  std::string path = temp_log_path("replay_mismatch");
+  write_session(path);
+
+  UvvmCosimData cosim_data;
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(uart_rx, {});
+  cosim_data.AddVvc(axis_tx, {{"packet_based", 1}});
+  cosim_data.AddVvc(axis_rx, {{"packet_based", 1}});
+
+  TrafficReplay replay(path, cosim_data, 1000);
+
+  REQUIRE_FALSE(replay.tick(100));
+
+  INFO("Wrong byte on UART, and end of packet too early on AXI-Stream");
+  replay.receive(uart_rx, 1, false, false);
+  replay.receive(uart_rx, 5, false, false);
+  replay.receive(axis_rx, 10, true, true);
+  REQUIRE_FALSE(replay.passed());
+
+  INFO("Replay ends when timeout has passed after last event in log");
+  REQUIRE_FALSE(replay.tick(1400));
+  REQUIRE(replay.tick(1401));
+  REQUIRE_FALSE(replay.passed());
+  REQUIRE(replay.summary().find("FAILED") != std::string::npos);
+
+  std::remove(path.c_str());
+}
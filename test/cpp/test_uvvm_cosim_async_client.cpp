@@ -0,0 +1,138 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fake_connector.hpp"
+#include "uvvm_cosim_async_client.hpp"
+
+using namespace uvvm_cosim;
+
+// Server that echoes the params, with errors for some methods
+static void setup_server(FakeServer& server)
+{
+  server.delay = std::chrono::milliseconds(1);
+  server.wrong_id_methods.insert("WrongId");
+
+  server.handlers["Throw"] = [](const json&) -> JsonResponse {
+    throw std::runtime_error("Connection refused");
+  };
+
+  server.handlers["Error"] = [](const json&) -> JsonResponse {
+    throw jsonrpccxx::JsonRpcException(-32601, "Method not found");
+  };
+}
+
+TEST_CASE("UvvmCosimAsyncClient_ordering")
+{
+  INFO("UvvmCosimAsyncClient_ordering test start.");
+
+  FakeServer server;
+  std::vector<std::future<JsonResponse>> futures;
+
+  setup_server(server);
+
+  {
+    UvvmCosimAsyncClient client([&]() { return std::make_unique<FakeConnector>(server); }, 4);
+
+    // Several threads sending to their own VVCs at the same time
+    std::vector<std::thread> threads;
+    std::mutex futures_mtx;
+
+    for (int vvc_id = 0; vvc_id < 8; vvc_id++) {
+      threads.emplace_back([&, vvc_id]() {
+        for (uint8_t i = 0; i < 20; i++) {
+          auto f = client.TransmitBytes("UART_VVC", vvc_id, {i});
+          std::lock_guard<std::mutex> lock(futures_mtx);
+          futures.push_back(std::move(f));
+        }
+      });
+    }
+
+    for (auto& t : threads) {
+      t.join();
+    }
+
+    INFO("Futures get the response for their own request");
+    for (auto& f : futures) {
+      JsonResponse response = f.get();
+      REQUIRE(response.success == true);
+      REQUIRE(response.result[0] == "UART_VVC");
+    }
+  }
+
+  INFO("Requests for one VVC are executed in order");
+  auto requests_by_vvc = server.requests_by_vvc();
+  REQUIRE(requests_by_vvc.size() == 8);
+  for (auto& [vvc, requests] : requests_by_vvc) {
+    REQUIRE(requests.size() == 20);
+    for (uint8_t i = 0; i < 20; i++) {
+      REQUIRE(requests[i]["params"][2] == std::vector<uint8_t>{i});
+    }
+  }
+
+  INFO("Requests for different VVCs overlap");
+  REQUIRE(server.max_in_flight > 1);
+}
+
+TEST_CASE("UvvmCosimAsyncClient_callback")
+{
+  INFO("UvvmCosimAsyncClient_callback test start.");
+
+  FakeServer server;
+  std::vector<uint8_t> received;
+  std::mutex mtx;
+
+  setup_server(server);
+
+  {
+    UvvmCosimAsyncClient client([&]() { return std::make_unique<FakeConnector>(server); }, 2);
+
+    for (uint8_t i = 0; i < 10; i++) {
+      client.CallForVvc("AXISTREAM_VVC", 1, "TransmitPacket", {"AXISTREAM_VVC", 1, std::vector<uint8_t>{i}},
+                        [&](JsonResponse response) {
+                          std::lock_guard<std::mutex> lock(mtx);
+                          received.push_back(response.result[2][0]);
+                        });
+    }
+
+    // Destructor waits for outstanding requests
+  }
+
+  REQUIRE(received.size() == 10);
+  for (uint8_t i = 0; i < 10; i++) {
+    REQUIRE(received[i] == i);
+  }
+}
+
+TEST_CASE("UvvmCosimAsyncClient_errors")
+{
+  INFO("UvvmCosimAsyncClient_errors test start.");
+
+  FakeServer server;
+  setup_server(server);
+
+  UvvmCosimAsyncClient client([&]() { return std::make_unique<FakeConnector>(server); }, 1);
+
+  INFO("Errors are thrown from the future");
+  REQUIRE_THROWS_AS(client.Call("Throw", json::array()).get(), std::runtime_error);
+  REQUIRE_THROWS_AS(client.Call("Error", json::array()).get(), jsonrpccxx::JsonRpcException);
+  REQUIRE_THROWS_AS(client.Call("WrongId", json::array()).get(), jsonrpccxx::JsonRpcException);
+
+  INFO("Errors are passed to callbacks as unsuccessful responses");
+  std::promise<JsonResponse> promise;
+  client.Call("Error", json::array(), [&](JsonResponse response) { promise.set_value(response); });
+  JsonResponse response = promise.get_future().get();
+  REQUIRE(response.success == false);
+  REQUIRE(response.result["error"] == "Method not found");
+
+  INFO("The connection still works after an error");
+  REQUIRE(client.GetVvcList().get().success == true);
+
+  REQUIRE_THROWS(UvvmCosimAsyncClient([&]() { return std::make_unique<FakeConnector>(server); }, 0));
+}
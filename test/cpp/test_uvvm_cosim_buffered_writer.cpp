@@ -0,0 +1,131 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fake_connector.hpp"
+#include "uvvm_cosim_buffered_writer.hpp"
+
+using namespace uvvm_cosim;
+
+// Fails transmits to unknown VVC types, and throws like a broken
+// connection while disconnected is set.
+static void setup_server(FakeServer& server, bool& disconnected)
+{
+  server.handlers["TransmitBytes"] = [&](const json& params) {
+    if (disconnected) {
+      throw std::runtime_error("client connector error");
+    }
+    if (params[0] == "NO_SUCH_VVC") {
+      return JsonResponse{false, json{{"error", "VVC does not exist."}}};
+    }
+    return JsonResponse{true, json::object()};
+  };
+
+  server.handlers["TransmitPacket"] = [](const json&) {
+    return JsonResponse{true, json::object()};
+  };
+
+  server.handlers["ReceiveBytes"] = [](const json&) {
+    return JsonResponse{true, json{{"data", std::vector<uint8_t>()}}};
+  };
+}
+
+TEST_CASE("UvvmCosimBufferedWriter_coalescing")
+{
+  INFO("UvvmCosimBufferedWriter_coalescing test start.");
+
+  FakeServer server;
+  bool disconnected = false;
+  setup_server(server, disconnected);
+
+  FakeConnector connector(server);
+  UvvmCosimClient client(connector);
+  UvvmCosimBufferedWriter writer(client, {.flush_bytes = 8, .flush_delay = std::chrono::hours(1)});
+
+  INFO("Small writes are buffered until the threshold");
+  writer.TransmitBytes("UART_VVC", 1, {100});
+  writer.TransmitBytes("UART_VVC", 0, {1, 2, 3});
+  writer.TransmitBytes("UART_VVC", 0, {4, 5, 6});
+  REQUIRE(server.requests.empty());
+  REQUIRE(writer.buffered_bytes() == 7);
+
+  INFO("Older buffers for other VVCs are flushed first");
+  writer.TransmitBytes("UART_VVC", 0, {7, 8});
+  REQUIRE(server.requests.size() == 2);
+  REQUIRE(server.requests[0]["method"] == "TransmitBytes");
+  REQUIRE(server.requests[0]["params"][1] == 1);
+  REQUIRE(server.requests[0]["params"][2] == std::vector<uint8_t>{100});
+  REQUIRE(server.requests[1]["params"][1] == 0);
+  REQUIRE(server.requests[1]["params"][2] == std::vector<uint8_t>{1, 2, 3, 4, 5, 6, 7, 8});
+  REQUIRE(writer.buffered_bytes() == 0);
+
+  INFO("Newer buffers for other VVCs are left alone");
+  writer.TransmitBytes("UART_VVC", 0, {1, 2, 3, 4, 5, 6, 7});
+  writer.TransmitBytes("UART_VVC", 1, {101});
+  writer.TransmitBytes("UART_VVC", 0, {8});
+  REQUIRE(server.requests.size() == 3);
+  REQUIRE(server.requests[2]["params"][1] == 0);
+  REQUIRE(writer.buffered_bytes() == 1);
+
+  INFO("Buffered data is flushed before a packet");
+  writer.TransmitBytes("UART_VVC", 0, {9});
+  writer.TransmitPacket("AXISTREAM_VVC", 0, {10, 11});
+  REQUIRE(server.requests.size() == 6);
+  REQUIRE(server.requests[3]["params"][2] == std::vector<uint8_t>{101});
+  REQUIRE(server.requests[4]["params"][2] == std::vector<uint8_t>{9});
+  REQUIRE(server.requests[5]["method"] == "TransmitPacket");
+  REQUIRE(writer.buffered_bytes() == 0);
+
+  INFO("Buffered data is flushed before a receive");
+  writer.TransmitBytes("UART_VVC", 0, {12});
+  writer.ReceiveBytes("UART_VVC", 1, 1, false);
+  REQUIRE(server.requests.size() == 8);
+  REQUIRE(server.requests[6]["params"][2] == std::vector<uint8_t>{12});
+  REQUIRE(server.requests[7]["method"] == "ReceiveBytes");
+
+  INFO("Flush sends everything");
+  writer.TransmitBytes("UART_VVC", 0, {13});
+  writer.Flush();
+  writer.Flush();
+  REQUIRE(server.requests.size() == 9);
+}
+
+TEST_CASE("UvvmCosimBufferedWriter_deadline")
+{
+  INFO("UvvmCosimBufferedWriter_deadline test start.");
+
+  FakeServer server;
+  bool disconnected = false;
+  setup_server(server, disconnected);
+
+  FakeConnector connector(server);
+  UvvmCosimClient client(connector);
+  UvvmCosimBufferedWriter writer(client, {.flush_bytes = 4096, .flush_delay = std::chrono::milliseconds(10)});
+
+  writer.TransmitBytes("UART_VVC", 0, {1});
+  writer.Poll();
+  REQUIRE(server.requests.empty());
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  writer.Poll();
+  REQUIRE(server.requests.size() == 1);
+
+  INFO("Rejected data is discarded, and the error is thrown from the flushing call");
+  writer.TransmitBytes("NO_SUCH_VVC", 0, {1});
+  REQUIRE_THROWS_AS(writer.Flush(), std::runtime_error);
+  REQUIRE(writer.buffered_bytes() == 0);
+
+  INFO("Data that couldn't be sent stays buffered");
+  writer.TransmitBytes("UART_VVC", 0, {2, 3});
+  disconnected = true;
+  REQUIRE_THROWS(writer.Flush());
+  REQUIRE(writer.buffered_bytes() == 2);
+
+  disconnected = false;
+  writer.Flush();
+  REQUIRE(server.requests.back()["params"][2] == std::vector<uint8_t>{2, 3});
+  REQUIRE(writer.buffered_bytes() == 0);
+}
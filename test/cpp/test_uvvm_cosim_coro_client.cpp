@@ -0,0 +1,141 @@
+#include <catch2/catch_test_macros.hpp>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fake_connector.hpp"
+#include "uvvm_cosim_coro_client.hpp"
+
+using namespace uvvm_cosim;
+
+// Loopback per VVC. Data transmitted to a VVC can be received from it
+// after it has been polled a few times.
+struct Loopback {
+  std::map<int, std::deque<std::vector<uint8_t>>> queues;
+  std::map<int, int> polls;
+};
+
+static void setup_loopback(FakeServer& server, Loopback& loopback)
+{
+  server.handlers["TransmitPacket"] = [&](const json& params) {
+    if (params[0] != "AXISTREAM_VVC") {
+      return JsonResponse{false, json{{"error", "VVC does not exist."}}};
+    }
+
+    loopback.queues[params[1]].push_back(params[2]);
+    return JsonResponse{true, json::object()};
+  };
+
+  server.handlers["ReceivePacket"] = [&](const json& params) {
+    auto& queue = loopback.queues[params[1]];
+    std::vector<uint8_t> pkt;
+
+    if (!queue.empty() && ++loopback.polls[params[1]] % 3 == 0) {
+      pkt = queue.front();
+      queue.pop_front();
+    }
+
+    return JsonResponse{true, json{{"data", pkt}}};
+  };
+}
+
+static UvvmCosimCoroClient::Sequence echo(UvvmCosimCoroClient& client, int vvc_id, int& received)
+{
+  for (uint8_t i = 0; i < 5; i++) {
+    std::vector<uint8_t> pkt = {uint8_t(vvc_id), i};
+
+    co_await client.TransmitPacket("AXISTREAM_VVC", vvc_id, pkt);
+    JsonResponse response = co_await client.ReceivePacket("AXISTREAM_VVC", vvc_id);
+
+    if (response.result["data"] == pkt) {
+      received++;
+    }
+  }
+}
+
+TEST_CASE("UvvmCosimCoroClient_sequences")
+{
+  INFO("UvvmCosimCoroClient_sequences test start.");
+
+  FakeServer server;
+  Loopback loopback;
+  setup_loopback(server, loopback);
+
+  FakeConnector connector(server);
+  UvvmCosimClient client(connector);
+  UvvmCosimCoroClient coro(client, std::chrono::microseconds(10));
+
+  std::vector<int> received(200);
+
+  for (int vvc_id = 0; vvc_id < 200; vvc_id++) {
+    coro.Spawn(echo(coro, vvc_id, received[vvc_id]));
+  }
+
+  coro.Run();
+
+  INFO("All sequences ran to completion on this thread");
+  for (int n : received) {
+    REQUIRE(n == 5);
+  }
+  REQUIRE(server.callers == std::set<std::thread::id>{std::this_thread::get_id()});
+
+  INFO("Receives were polled until data arrived");
+  REQUIRE(server.requests.size() > 200 * 5 * 2);
+}
+
+static UvvmCosimCoroClient::Sequence transmit_bad_vvc(UvvmCosimCoroClient& client)
+{
+  std::vector<uint8_t> pkt(1);
+  co_await client.TransmitPacket("NO_SUCH_VVC", 0, pkt);
+}
+
+static UvvmCosimCoroClient::Sequence nested(UvvmCosimCoroClient& client, bool& caught)
+{
+  try {
+    co_await transmit_bad_vvc(client);
+  }
+  catch (const std::runtime_error& e) {
+    caught = std::string(e.what()) == "VVC does not exist.";
+  }
+
+  co_await client.Sleep(std::chrono::milliseconds(2));
+}
+
+TEST_CASE("UvvmCosimCoroClient_errors")
+{
+  INFO("UvvmCosimCoroClient_errors test start.");
+
+  FakeServer server;
+  Loopback loopback;
+  setup_loopback(server, loopback);
+
+  FakeConnector connector(server);
+  UvvmCosimClient client(connector);
+
+  INFO("Errors are thrown in the sequence, and can be caught by an awaiting sequence");
+  {
+    UvvmCosimCoroClient coro(client);
+    bool caught = false;
+
+    coro.Spawn(nested(coro, caught));
+    coro.Run();
+
+    REQUIRE(caught == true);
+  }
+
+  INFO("Uncaught errors are thrown from Run()");
+  {
+    UvvmCosimCoroClient coro(client);
+    int received = 0;
+
+    coro.Spawn(echo(coro, 0, received));
+    coro.Spawn(transmit_bad_vvc(coro));
+
+    REQUIRE_THROWS_AS(coro.Run(), std::runtime_error);
+  }
+}
@@ -1,6 +1,7 @@
 #include <catch2/catch_test_macros.hpp>
 #include <map>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 #include "uvvm_cosim_data.hpp"
 #include "uvvm_cosim_types.hpp"
@@ -304,6 +305,237 @@ TEST_CASE("UvvmCosimData_byte_queues")
   }
 }
 
+TEST_CASE("UvvmCosimData_byte_queue_wait_for_pattern")
+{
+  INFO("UvvmCosimData_byte_queue_wait_for_pattern test start.");
+
+  using namespace std::chrono_literals;
+
+  UvvmCosimData cosim_data;
+
+  for (int i = 0; i < 5; i++) {
+    cosim_data.AddVvc(vk[i], vc[i].bfm_cfg);
+  }
+
+  std::vector<uint8_t> pattern {0xDE, 0xAD};
+
+  INFO("Empty pattern and non-existing VVC should throw");
+  REQUIRE_THROWS(cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], {}, 0ms, false));
+  REQUIRE_THROWS(cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, VvcInstanceKey{"AXISTREAM_VVC", "NA", 113}, pattern, 0ms, false));
+
+  INFO("Timeout when pattern is not in queue");
+  cosim_data.byte_queue_put(QID_RECEIVE, vk[0], std::vector<uint8_t>{0x01, 0xDE});
+  REQUIRE_FALSE(cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 0ms, false).has_value());
+  REQUIRE_FALSE(cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 10ms, false).has_value());
+
+  INFO("Find pattern without consuming");
+  cosim_data.byte_queue_put(QID_RECEIVE, vk[0], std::vector<uint8_t>{0xAD, 0x02});
+  auto match = cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 0ms, false);
+  REQUIRE(match.has_value());
+  REQUIRE(match->length == 3);
+  REQUIRE(match->data.empty());
+  REQUIRE(cosim_data.byte_queue_size(QID_RECEIVE, vk[0]) == 4);
+
+  INFO("Find pattern and consume bytes up to and including it");
+  match = cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 0ms, true);
+  REQUIRE(match.has_value());
+  REQUIRE(match->data == std::vector<uint8_t>{0x01, 0xDE, 0xAD});
+  REQUIRE(cosim_data.byte_queue_size(QID_RECEIVE, vk[0]) == 1);
+
+  INFO("Wait for pattern that arrives split over several puts from another thread");
+  std::thread producer([&]() {
+    for (uint8_t b : {0x10, 0x11, 0xDE, 0x12, 0xDE, 0xAD, 0x13}) {
+      std::this_thread::sleep_for(2ms);
+      cosim_data.byte_queue_put(QID_RECEIVE, vk[0], b);
+    }
+  });
+
+  match = cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 5000ms, true);
+  producer.join();
+
+  REQUIRE(match.has_value());
+  REQUIRE(match->data == std::vector<uint8_t>{0x02, 0x10, 0x11, 0xDE, 0x12, 0xDE, 0xAD});
+  REQUIRE(cosim_data.byte_queue_get(QID_RECEIVE, vk[0], 0) == std::vector<uint8_t>{0x13});
+
+  INFO("Terminating simulation wakes up waiting thread");
+  std::thread terminator([&]() {
+    std::this_thread::sleep_for(10ms);
+    cosim_data.setTerminateSim(true);
+  });
+
+  auto start = std::chrono::steady_clock::now();
+  match = cosim_data.byte_queue_wait_for_pattern(QID_RECEIVE, vk[0], pattern, 5000ms, true);
+  terminator.join();
+
+  REQUIRE_FALSE(match.has_value());
+  REQUIRE(std::chrono::steady_clock::now() - start < 4000ms);
+}
+
+TEST_CASE("UvvmCosimData_wait_for_any")
+{
+  INFO("UvvmCosimData_wait_for_any test start.");
+
+  using namespace std::chrono_literals;
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart_rx = {"UART_VVC", "RX", 0};
+  VvcInstanceKey uart_tx = {"UART_VVC", "TX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 1};
+
+  cosim_data.AddVvc(uart_rx, {});
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  INFO("Non-existing VVC should throw");
+  REQUIRE_THROWS(cosim_data.wait_for_any({VvcInstanceKey{"UART_VVC", "RX", 7}}, {}, 0, 0ms));
+
+  INFO("Timeout when no receive queue has data");
+  REQUIRE(cosim_data.wait_for_any({uart_rx, axis}, {}, 0, 10ms).empty());
+
+  INFO("Receive queues with data are ready, with byte and complete packet counts");
+  cosim_data.byte_queue_put(QID_RECEIVE, uart_rx, std::vector<uint8_t>{1, 2, 3});
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {1, 2});
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {3, 4, 5});
+  cosim_data.packet_queue_put_bytes(QID_RECEIVE, axis, {6}, false);
+
+  auto ready = cosim_data.wait_for_any({uart_rx, axis}, {}, 0, 0ms);
+  REQUIRE(ready.size() == 2);
+  REQUIRE(ready[0].vvc.vvc_channel == "RX");
+  REQUIRE(ready[0].qid == QID_RECEIVE);
+  REQUIRE(ready[0].bytes == 3);
+  REQUIRE(ready[0].packets == 0);
+  REQUIRE(ready[1].vvc.vvc_instance_id == 1);
+  REQUIRE(ready[1].bytes == 5);
+  REQUIRE(ready[1].packets == 2);
+
+  INFO("Wait for data put from another thread");
+  (void) cosim_data.byte_queue_get(QID_RECEIVE, uart_rx, 0);
+  (void) cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis);
+  (void) cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis);
+
+  std::thread producer([&]() {
+    std::this_thread::sleep_for(10ms);
+    cosim_data.byte_queue_put(QID_RECEIVE, uart_rx, 0x55);
+  });
+
+  ready = cosim_data.wait_for_any({uart_rx, axis}, {}, 0, 5000ms);
+  producer.join();
+
+  REQUIRE(ready.size() == 1);
+  REQUIRE(ready[0].vvc.vvc_type == "UART_VVC");
+
+  INFO("Wait for transmit queue to drain below threshold from another thread");
+  cosim_data.byte_queue_put(QID_TRANSMIT, uart_tx, std::vector<uint8_t>(10));
+  REQUIRE(cosim_data.wait_for_any({}, {uart_tx}, 8, 0ms).empty());
+
+  std::thread consumer([&]() {
+    for (int i = 0; i < 4; i++) {
+      std::this_thread::sleep_for(2ms);
+      (void) cosim_data.byte_queue_get(QID_TRANSMIT, uart_tx);
+    }
+  });
+
+  ready = cosim_data.wait_for_any({}, {uart_tx}, 8, 5000ms);
+  consumer.join();
+
+  REQUIRE(ready.size() == 1);
+  REQUIRE(ready[0].qid == QID_TRANSMIT);
+  REQUIRE(ready[0].bytes < 8);
+}
+
+TEST_CASE("UvvmCosimData_GetQueueStatus")
+{
+  INFO("UvvmCosimData_GetQueueStatus test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart_tx = {"UART_VVC", "TX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 1};
+
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  cosim_data.byte_queue_put(QID_TRANSMIT, uart_tx, std::vector<uint8_t>(20));
+  (void) cosim_data.byte_queue_get(QID_TRANSMIT, uart_tx, 15);
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {1, 2, 3});
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {4});
+
+  INFO("Status of both queues for all VVCs, in GetVvcList order");
+  auto status = cosim_data.GetQueueStatus(true);
+  REQUIRE(status.size() == 2);
+
+  REQUIRE(status[0].vvc.vvc_type == "AXISTREAM_VVC");
+  REQUIRE(status[0].packet_based == true);
+  REQUIRE(status[0].queues[QID_TRANSMIT].bytes == 0);
+  REQUIRE(status[0].queues[QID_RECEIVE].bytes == 4);
+  REQUIRE(status[0].queues[QID_RECEIVE].packets == 2);
+  REQUIRE(status[0].queues[QID_RECEIVE].high_water_packets == 2);
+
+  REQUIRE(status[1].vvc.vvc_type == "UART_VVC");
+  REQUIRE(status[1].packet_based == false);
+  REQUIRE(status[1].queues[QID_TRANSMIT].bytes == 5);
+  REQUIRE(status[1].queues[QID_TRANSMIT].packets == 0);
+  REQUIRE(status[1].queues[QID_TRANSMIT].high_water_bytes == 20);
+
+  INFO("High-water marks were reset by the previous call");
+  status = cosim_data.GetQueueStatus(false);
+  REQUIRE(status[1].queues[QID_TRANSMIT].high_water_bytes == 5);
+  REQUIRE(status[0].queues[QID_RECEIVE].high_water_bytes == 4);
+}
+
+TEST_CASE("UvvmCosimData_multi")
+{
+  INFO("UvvmCosimData_multi test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart_tx = {"UART_VVC", "TX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 1};
+  VvcInstanceKey missing = {"AXISTREAM_VVC", "NA", 2};
+
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  INFO("Data is put as bytes or packets depending on the VVC");
+  auto packet_based = cosim_data.queue_put_multi(QID_TRANSMIT, {
+    {uart_tx, {1, 2, 3}, {}},
+    {axis, {4, 5}, {}},
+    {axis, {6}, PacketMeta{1, 2, 3}},
+    {uart_tx, {7}, {}}
+  });
+  REQUIRE(packet_based == std::vector<bool>{false, true, true, false});
+  REQUIRE(cosim_data.byte_queue_size(QID_TRANSMIT, uart_tx) == 4);
+  REQUIRE(cosim_data.packet_queue_size(QID_TRANSMIT, axis) == 2);
+
+  INFO("Nothing is put if any entry is invalid");
+  REQUIRE_THROWS(cosim_data.queue_put_multi(QID_TRANSMIT, {{uart_tx, {8}, {}}, {missing, {9}, {}}}));
+  REQUIRE_THROWS(cosim_data.queue_put_multi(QID_TRANSMIT, {{uart_tx, {8}, PacketMeta{1, 0, 0}}}));
+  REQUIRE(cosim_data.byte_queue_size(QID_TRANSMIT, uart_tx) == 4);
+
+  INFO("Results are returned in entry order, limited per entry");
+  auto results = cosim_data.queue_get_multi(QID_TRANSMIT, {{axis, 1}, {uart_tx, 2}, {axis, 0}, {uart_tx, 0}});
+  REQUIRE(results.size() == 4);
+
+  REQUIRE(results[0].packet_based == true);
+  REQUIRE(results[0].packets.size() == 1);
+  REQUIRE(results[0].packets[0].data == std::vector<uint8_t>{4, 5});
+  REQUIRE(results[0].packets[0].meta == PacketMeta{});
+
+  REQUIRE(results[1].packet_based == false);
+  REQUIRE(results[1].data == std::vector<uint8_t>{1, 2});
+
+  REQUIRE(results[2].packets.size() == 1);
+  REQUIRE(results[2].packets[0].data == std::vector<uint8_t>{6});
+  REQUIRE(results[2].packets[0].meta == PacketMeta{1, 2, 3});
+
+  REQUIRE(results[3].data == std::vector<uint8_t>{3, 7});
+
+  INFO("Empty queues give empty results");
+  results = cosim_data.queue_get_multi(QID_TRANSMIT, {{uart_tx, 0}, {axis, 0}});
+  REQUIRE(results[0].data.empty());
+  REQUIRE(results[1].packets.empty());
+
+  REQUIRE_THROWS(cosim_data.queue_get_multi(QID_RECEIVE, {{missing, 0}}));
+}
+
 TEST_CASE("UvvmCosimData_packet_queues")
 {
   INFO("TODO: Not implemented yet");
@@ -311,9 +543,336 @@ TEST_CASE("UvvmCosimData_packet_queues")
 
 TEST_CASE("UvvmCosimData_packet_based_queue_access")
 {
-  INFO("TODO: Not implemented yet");
+  INFO("UvvmCosimData_packet_based_queue_access test start.");
 
   // Check that only packet queue methods can be used for
   // VVCs with packet_based flag set, and only byte queue
   // methods for those without the flag.
+  UvvmCosimData cosim_data;
+  VvcInstanceKey bytes = {"AXISTREAM_VVC", "NA", 0};
+  VvcInstanceKey packets = {"AXISTREAM_VVC", "NA", 1};
+  bool eop;
+
+  cosim_data.AddVvc(bytes, {{"packet_based", 0}});
+  cosim_data.AddVvc(packets, {{"packet_based", 1}});
+
+  for (auto qid : {QID_TRANSMIT, QID_RECEIVE}) {
+    REQUIRE_NOTHROW(cosim_data.byte_queue_put(qid, bytes, 1));
+    REQUIRE(cosim_data.byte_queue_size(qid, bytes) == 1);
+    REQUIRE_THROWS(cosim_data.packet_queue_empty(qid, bytes));
+    REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(qid, bytes, {1}));
+    REQUIRE_THROWS(cosim_data.packet_queue_get_bytes(qid, bytes, 1, eop));
+
+    REQUIRE_NOTHROW(cosim_data.packet_queue_put_pkt(qid, packets, {1}));
+    REQUIRE(cosim_data.packet_queue_size(qid, packets) == 1);
+    REQUIRE_THROWS(cosim_data.byte_queue_empty(qid, packets));
+    REQUIRE_THROWS(cosim_data.byte_queue_put(qid, packets, 1));
+    REQUIRE_THROWS(cosim_data.byte_queue_get(qid, packets));
+  }
+
+  INFO("Polling dispatches to the queue kind of the VVC");
+  REQUIRE(cosim_data.byte_queue_poll(QID_TRANSMIT, bytes) == 0);
+  REQUIRE(cosim_data.packet_queue_poll(QID_TRANSMIT, packets) == 0);
+}
+
+TEST_CASE("UvvmCosimData_receive_sink")
+{
+  INFO("UvvmCosimData_receive_sink test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey vvc = {"AXISTREAM_VVC", "NA", 0};
+
+  cosim_data.AddVvc(vvc, {{"packet_based", 1}});
+
+  REQUIRE_THROWS(cosim_data.DetachReceiveSink(vvc));
+  REQUIRE_THROWS(cosim_data.AttachReceiveSink(vk[0], "/dev/null", ReceiveSink::RSF_RAW, 0));
+
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, vvc, {1, 2, 3});
+  cosim_data.AttachReceiveSink(vvc, "/dev/null", ReceiveSink::RSF_PCAPNG, C_LINKTYPE_ETHERNET);
+  REQUIRE_THROWS(cosim_data.AttachReceiveSink(vvc, "/dev/null", ReceiveSink::RSF_RAW, 0));
+
+  INFO("Received data bypasses the queue while sink is attached");
+  cosim_data.packet_queue_put_byte(QID_RECEIVE, vvc, 4, false);
+  cosim_data.packet_queue_put_byte(QID_RECEIVE, vvc, 5, true);
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, vvc, {6, 7});
+  REQUIRE(cosim_data.packet_queue_size(QID_RECEIVE, vvc) == 1);
+
+  INFO("Transmit queue is not affected");
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, vvc, {8});
+  REQUIRE(cosim_data.packet_queue_size(QID_TRANSMIT, vvc) == 1);
+
+  auto sink = cosim_data.DetachReceiveSink(vvc);
+  REQUIRE(sink->packets() == 2);
+  REQUIRE(sink->bytes() == 4);
+
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, vvc, {9});
+  REQUIRE(cosim_data.packet_queue_size(QID_RECEIVE, vvc) == 2);
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, vvc) == std::vector<uint8_t>{1, 2, 3});
+}
+
+TEST_CASE("UvvmCosimData_sim_stamps")
+{
+  INFO("UvvmCosimData_sim_stamps test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart = {"UART_VVC", "RX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+
+  cosim_data.AddVvc(uart, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  INFO("Received data is stamped with the time of the current cycle");
+  cosim_data.setSimTime(100, 10);
+  cosim_data.byte_queue_put(QID_RECEIVE, uart, 0xAA);
+  cosim_data.packet_queue_put_byte(QID_RECEIVE, axis, 1, false);
+
+  cosim_data.setSimTime(110, 11);
+  REQUIRE(cosim_data.getSimTime() == 110);
+  REQUIRE(cosim_data.getSimCycles() == 11);
+  cosim_data.byte_queue_put(QID_RECEIVE, uart, {0xBB, 0xCC});
+  cosim_data.packet_queue_put_byte(QID_RECEIVE, axis, 2, true);
+
+  std::vector<SimStampRun> stamps;
+  REQUIRE(cosim_data.byte_queue_get(QID_RECEIVE, uart, 3, &stamps) == std::vector<uint8_t>{0xAA, 0xBB, 0xCC});
+  REQUIRE(stamps.size() == 2);
+  REQUIRE(stamps[0].count == 1);
+  REQUIRE(stamps[0].stamp == SimStamp{100, 10});
+  REQUIRE(stamps[1].count == 2);
+  REQUIRE(stamps[1].stamp == SimStamp{110, 11});
+
+  PacketStamp stamp;
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis, &stamp) == std::vector<uint8_t>{1, 2});
+  REQUIRE(stamp.first == SimStamp{100, 10});
+  REQUIRE(stamp.last == SimStamp{110, 11});
+}
+
+TEST_CASE("UvvmCosimData_put_hook")
+{
+  INFO("UvvmCosimData_put_hook test start.");
+
+  struct HookCall {
+    QueueId qid;
+    VvcInstanceKey vvc;
+    uint64_t sim_time_ns;
+    std::vector<uint8_t> data;
+    bool packet;
+    bool eop;
+  };
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart = {"UART_VVC", "TX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+  std::vector<HookCall> calls;
+
+  cosim_data.AddVvc(uart, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}, {"tid_bits", 4}});
+
+  cosim_data.setPutHook([&](QueueId qid, const VvcInstanceKey& vvc, uint64_t sim_time_ns,
+                            const uint8_t* data, size_t size, bool packet, bool eop) {
+    calls.push_back(HookCall{qid, vvc, sim_time_ns, std::vector<uint8_t>(data, data + size), packet, eop});
+  });
+
+  cosim_data.setSimTime(100, 10);
+  cosim_data.byte_queue_put(QID_TRANSMIT, uart, {1, 2});
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {3});
+  cosim_data.setSimTime(110, 11);
+  cosim_data.packet_queue_put_byte(QID_RECEIVE, axis, 4, true);
+  cosim_data.queue_put_multi(QID_TRANSMIT, {{uart, {5}, {}}, {axis, {6, 7}, {}}});
+
+  INFO("Invalid puts are not passed to the hook");
+  REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {8}, PacketMeta{16, 0, 0}));
+
+  REQUIRE(calls.size() == 5);
+  REQUIRE(calls[0].qid == QID_TRANSMIT);
+  REQUIRE(to_string(calls[0].vvc) == to_string(uart));
+  REQUIRE(calls[0].sim_time_ns == 100);
+  REQUIRE(calls[0].data == std::vector<uint8_t>{1, 2});
+  REQUIRE_FALSE(calls[0].packet);
+  REQUIRE(to_string(calls[1].vvc) == to_string(axis));
+  REQUIRE(calls[1].packet);
+  REQUIRE(calls[1].eop);
+  REQUIRE(calls[2].qid == QID_RECEIVE);
+  REQUIRE(calls[2].sim_time_ns == 110);
+  REQUIRE(calls[2].data == std::vector<uint8_t>{4});
+  REQUIRE(calls[3].data == std::vector<uint8_t>{5});
+  REQUIRE(calls[4].data == std::vector<uint8_t>{6, 7});
+  REQUIRE(calls[4].eop);
+}
+
+TEST_CASE("UvvmCosimData_beats")
+{
+  INFO("UvvmCosimData_beats test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+  bool eop = false;
+
+  cosim_data.AddVvc(axis, {{"packet_based", 1}, {"data_width", 32}});
+
+  INFO("data_width is reported as part of the BFM config");
+  REQUIRE(cosim_data.GetVvcList()[0].bfm_cfg.at("data_width") == 32);
+
+  cosim_data.setSimTime(100, 10);
+  cosim_data.packet_queue_put_bytes(QID_RECEIVE, axis, {1, 2, 3, 4}, false);
+  REQUIRE(cosim_data.packet_queue_size(QID_RECEIVE, axis) == 0);
+  cosim_data.setSimTime(110, 11);
+  cosim_data.packet_queue_put_bytes(QID_RECEIVE, axis, {5}, true);
+  REQUIRE(cosim_data.packet_queue_size(QID_RECEIVE, axis) == 1);
+
+  PacketStamp stamp;
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis, &stamp) == std::vector<uint8_t>{1, 2, 3, 4, 5});
+  REQUIRE(stamp.first == SimStamp{100, 10});
+  REQUIRE(stamp.last == SimStamp{110, 11});
+
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {6, 7, 8, 9, 10, 11});
+  REQUIRE(cosim_data.packet_queue_get_bytes(QID_TRANSMIT, axis, 4, eop) == std::vector<uint8_t>{6, 7, 8, 9});
+  REQUIRE_FALSE(eop);
+  REQUIRE(cosim_data.packet_queue_get_bytes(QID_TRANSMIT, axis, 4, eop) == std::vector<uint8_t>{10, 11});
+  REQUIRE(eop);
+  REQUIRE(cosim_data.packet_queue_get_bytes(QID_TRANSMIT, axis, 4, eop).empty());
+
+  REQUIRE_THROWS(cosim_data.packet_queue_get_bytes(QID_TRANSMIT, vk[2], 4, eop));
+}
+
+TEST_CASE("UvvmCosimData_packet_meta")
+{
+  INFO("UvvmCosimData_packet_meta test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+  PacketMeta meta;
+
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {1, 2}, PacketMeta{1, 2, 3});
+  REQUIRE(cosim_data.packet_queue_get_meta(QID_TRANSMIT, axis) == PacketMeta{1, 2, 3});
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_TRANSMIT, axis, nullptr, &meta) == std::vector<uint8_t>{1, 2});
+  REQUIRE(meta == PacketMeta{1, 2, 3});
+
+  cosim_data.packet_queue_put_meta(QID_RECEIVE, axis, PacketMeta{4, 5, 6});
+  cosim_data.packet_queue_put_bytes(QID_RECEIVE, axis, {3, 4}, true);
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis, nullptr, &meta) == std::vector<uint8_t>{3, 4});
+  REQUIRE(meta == PacketMeta{4, 5, 6});
+
+  INFO("Ignored while a receive sink is attached");
+  cosim_data.AttachReceiveSink(axis, "/dev/null", ReceiveSink::RSF_RAW, 0);
+  cosim_data.packet_queue_put_meta(QID_RECEIVE, axis, PacketMeta{7, 8, 9});
+  cosim_data.packet_queue_put_bytes(QID_RECEIVE, axis, {5}, true);
+  cosim_data.DetachReceiveSink(axis);
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {6});
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, axis, nullptr, &meta) == std::vector<uint8_t>{6});
+  REQUIRE(meta == PacketMeta{});
+
+  REQUIRE_THROWS(cosim_data.packet_queue_get_meta(QID_TRANSMIT, vk[2]));
+}
+
+TEST_CASE("UvvmCosimData_packet_meta_widths")
+{
+  INFO("UvvmCosimData_packet_meta_widths test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+  VvcInstanceKey axis_no_widths = {"AXISTREAM_VVC", "NA", 1};
+
+  cosim_data.AddVvc(axis, {{"packet_based", 1}, {"tid_bits", 8}, {"tdest_bits", 4}, {"tuser_bits", 8}});
+  cosim_data.AddVvc(axis_no_widths, {{"packet_based", 1}});
+
+  INFO("Values within the reported widths are accepted");
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {1}, PacketMeta{255, 15, 255});
+  REQUIRE(cosim_data.packet_queue_size(QID_TRANSMIT, axis) == 1);
+
+  INFO("Values wider than the reported widths are rejected");
+  REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {2}, PacketMeta{256, 0, 0}));
+  REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {2}, PacketMeta{0, 16, 0}));
+  REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {2}, PacketMeta{0, 0, 256}));
+  REQUIRE_THROWS(cosim_data.queue_put_multi(QID_TRANSMIT, {{axis, {2}, {}}, {axis, {3}, PacketMeta{0, 16, 0}}}));
+  REQUIRE(cosim_data.packet_queue_size(QID_TRANSMIT, axis) == 1);
+
+  INFO("Values must fit in a VHDL integer when no widths are reported");
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis_no_widths, {1}, PacketMeta{0x7fffffff, 0, 0});
+  REQUIRE_THROWS(cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis_no_widths, {2}, PacketMeta{0x80000000, 0, 0}));
+  REQUIRE(cosim_data.packet_queue_size(QID_TRANSMIT, axis_no_widths) == 1);
+}
+
+TEST_CASE("UvvmCosimData_poll_backoff")
+{
+  INFO("UvvmCosimData_poll_backoff test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart = {"UART_VVC", "TX", 0};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+
+  cosim_data.AddVvc(uart, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  INFO("Adaptive polling is disabled by default");
+  for (int i = 0; i < 1000; i++) {
+    REQUIRE(cosim_data.byte_queue_poll(QID_TRANSMIT, uart) == 1);
+  }
+
+  cosim_data.setPollConfig(PollConfig{.idle_cycles = 4, .max_cycles = 16});
+
+  INFO("Backs off exponentially after idle cycles, up to max");
+  std::vector<int> expected = {1, 1, 1, 2, 4, 8, 16, 16};
+  for (int cycles : expected) {
+    REQUIRE(cosim_data.packet_queue_poll(QID_TRANSMIT, axis) == cycles);
+  }
+
+  INFO("Resets when data is found");
+  cosim_data.packet_queue_put_pkt(QID_TRANSMIT, axis, {1, 2});
+  REQUIRE(cosim_data.packet_queue_poll(QID_TRANSMIT, axis) == 0);
+  (void) cosim_data.packet_queue_get_pkt(QID_TRANSMIT, axis);
+  REQUIRE(cosim_data.packet_queue_poll(QID_TRANSMIT, axis) == 1);
+
+  INFO("State is kept per VVC");
+  cosim_data.byte_queue_put(QID_TRANSMIT, uart, 0x55);
+  REQUIRE(cosim_data.byte_queue_poll(QID_TRANSMIT, uart) == 0);
+
+  REQUIRE_THROWS(cosim_data.byte_queue_poll(QID_TRANSMIT, axis));
+  REQUIRE_THROWS(cosim_data.byte_queue_poll(QID_TRANSMIT, {"UART_VVC", "TX", 5}));
+}
+
+TEST_CASE("UvvmCosimData_handles")
+{
+  INFO("UvvmCosimData_handles test start.");
+
+  UvvmCosimData cosim_data;
+  VvcInstanceKey uart_tx = {"UART_VVC", "TX", 1};
+  VvcInstanceKey uart_rx = {"UART_VVC", "RX", 1};
+  VvcInstanceKey axis = {"AXISTREAM_VVC", "NA", 0};
+
+  cosim_data.AddVvc(uart_tx, {});
+  cosim_data.AddVvc(uart_rx, {});
+  cosim_data.AddVvc(axis, {{"packet_based", 1}});
+
+  VvcHandle tx = cosim_data.ResolveVvc(uart_tx);
+  VvcHandle rx = cosim_data.ResolveVvc(uart_rx);
+  VvcHandle ax = cosim_data.ResolveVvc(axis);
+
+  REQUIRE(tx != rx);
+  REQUIRE(cosim_data.GetVvcKey(rx).vvc_channel == "RX");
+  REQUIRE(cosim_data.GetVvcKey(ax).vvc_type == "AXISTREAM_VVC");
+
+  INFO("Handle and key access the same queues");
+  cosim_data.byte_queue_put(QID_TRANSMIT, tx, {1, 2, 3});
+  REQUIRE(cosim_data.byte_queue_size(QID_TRANSMIT, uart_tx) == 3);
+  REQUIRE(cosim_data.byte_queue_empty(QID_TRANSMIT, rx));
+
+  cosim_data.byte_queue_put(QID_RECEIVE, uart_rx, {4, 5});
+  REQUIRE(cosim_data.byte_queue_size(QID_RECEIVE, rx) == 2);
+  REQUIRE(cosim_data.byte_queue_get(QID_RECEIVE, rx, 2) == std::vector<uint8_t>{4, 5});
+
+  cosim_data.packet_queue_put_pkt(QID_RECEIVE, axis, {6, 7}, PacketMeta{.tid = 1});
+  REQUIRE_FALSE(cosim_data.packet_queue_empty(QID_RECEIVE, ax));
+
+  PacketMeta meta;
+  REQUIRE(cosim_data.packet_queue_get_pkt(QID_RECEIVE, ax, nullptr, &meta) == std::vector<uint8_t>{6, 7});
+  REQUIRE(meta.tid == 1);
+
+  INFO("Unknown VVCs and handles, and wrong queue kind");
+  REQUIRE_THROWS(cosim_data.ResolveVvc({"UART_VVC", "TX", 2}));
+  REQUIRE_THROWS(cosim_data.GetVvcKey(3));
+  REQUIRE_THROWS(cosim_data.byte_queue_put(QID_TRANSMIT, VvcHandle(3), {1}));
+  REQUIRE_THROWS(cosim_data.byte_queue_empty(QID_TRANSMIT, ax));
+  REQUIRE_THROWS(cosim_data.packet_queue_empty(QID_TRANSMIT, tx));
 }
@@ -0,0 +1,159 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "fake_connector.hpp"
+#include "uvvm_cosim_receive_stream.hpp"
+
+using namespace uvvm_cosim;
+using namespace std::chrono_literals;
+
+// Receive queue of a VVC on the server, filled by the test
+struct FakeReceiveQueue {
+  std::mutex mtx;
+  std::deque<std::vector<uint8_t>> chunks;
+  std::atomic<int> polls = 0;
+  bool fail = false;
+
+  // Sent instead of the queued data if set
+  std::optional<JsonResponse> reply;
+
+  void put(std::vector<uint8_t> chunk)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    chunks.push_back(std::move(chunk));
+  }
+};
+
+// Answers the receive calls from the queue
+static void setup_server(FakeServer& server, FakeReceiveQueue& queue)
+{
+  FakeServer::Handler receive = [&](const json&) {
+    JsonResponse response{true, json{{"data", std::vector<uint8_t>()}}};
+
+    queue.polls++;
+
+    std::lock_guard<std::mutex> lock(queue.mtx);
+
+    if (queue.reply) {
+      response = *queue.reply;
+    } else if (queue.fail) {
+      response = JsonResponse{false, json{{"error", "VVC does not exist."}}};
+    } else if (!queue.chunks.empty()) {
+      response.result["data"] = queue.chunks.front();
+      queue.chunks.pop_front();
+    }
+
+    return response;
+  };
+
+  server.handlers["ReceiveBytes"] = receive;
+  server.handlers["ReceivePacket"] = receive;
+}
+
+TEST_CASE("UvvmCosimReceiveStream_bytes")
+{
+  INFO("UvvmCosimReceiveStream_bytes test start.");
+
+  FakeServer server;
+  FakeReceiveQueue queue;
+  setup_server(server, queue);
+  UvvmCosimReceiveStream stream(std::make_unique<FakeConnector>(server), "UART_VVC", 1,
+                                UvvmCosimReceiveStream::RSM_BYTES);
+
+  queue.put({1, 2, 3});
+  queue.put({4, 5});
+
+  INFO("Data received in several calls is read in order");
+  auto data = stream.read(4, 1s);
+  REQUIRE(data.has_value());
+  REQUIRE(*data == std::vector<uint8_t>{1, 2, 3, 4});
+
+  INFO("Timeout leaves the buffered data alone");
+  REQUIRE(stream.read(2, 20ms).has_value() == false);
+  REQUIRE(stream.buffered_bytes() == 1);
+  REQUIRE(stream.read_some(10, 1s) == std::vector<uint8_t>{5});
+  REQUIRE(stream.read_some(10, 20ms).empty());
+
+  INFO("The poll rate backs off while the queue is empty");
+  int polls = queue.polls;
+  std::this_thread::sleep_for(100ms);
+  REQUIRE(queue.polls - polls < 30);
+
+  INFO("Receive errors are thrown from the read calls");
+  {
+    std::lock_guard<std::mutex> lock(queue.mtx);
+    queue.fail = true;
+  }
+  REQUIRE_THROWS_AS(stream.read(1, 1s), std::runtime_error);
+}
+
+TEST_CASE("UvvmCosimReceiveStream_packets")
+{
+  INFO("UvvmCosimReceiveStream_packets test start.");
+
+  FakeServer server;
+  FakeReceiveQueue queue;
+  setup_server(server, queue);
+  UvvmCosimReceiveStream::Config cfg;
+  cfg.max_buffered_bytes = 4;
+
+  UvvmCosimReceiveStream stream(std::make_unique<FakeConnector>(server), "AXISTREAM_VVC", 0,
+                                UvvmCosimReceiveStream::RSM_PACKETS, cfg);
+
+  for (uint8_t i = 0; i < 10; i++) {
+    queue.put({i, i});
+  }
+
+  INFO("Polling pauses when the buffer is full");
+  std::this_thread::sleep_for(50ms);
+  REQUIRE(stream.buffered_bytes() == 4);
+
+  std::vector<std::vector<uint8_t>> received;
+  for (const std::vector<uint8_t>& pkt : stream.packets(200ms)) {
+    received.push_back(pkt);
+  }
+
+  REQUIRE(received.size() == 10);
+  for (uint8_t i = 0; i < 10; i++) {
+    REQUIRE(received[i] == std::vector<uint8_t>{i, i});
+  }
+}
+
+TEST_CASE("UvvmCosimReceiveStream_bad_response")
+{
+  INFO("UvvmCosimReceiveStream_bad_response test start.");
+
+  INFO("A failure without an error message still stops the stream");
+  {
+    FakeServer server;
+  FakeReceiveQueue queue;
+  setup_server(server, queue);
+    queue.reply = JsonResponse{false, json{{"error", ""}}};
+
+    UvvmCosimReceiveStream stream(std::make_unique<FakeConnector>(server), "UART_VVC", 1,
+                                  UvvmCosimReceiveStream::RSM_BYTES);
+
+    REQUIRE_THROWS_AS(stream.read(1, 10s), std::runtime_error);
+  }
+
+  INFO("A response without data is a receive error");
+  {
+    FakeServer server;
+  FakeReceiveQueue queue;
+  setup_server(server, queue);
+    queue.reply = JsonResponse{true, json::object()};
+
+    UvvmCosimReceiveStream stream(std::make_unique<FakeConnector>(server), "UART_VVC", 1,
+                                  UvvmCosimReceiveStream::RSM_BYTES);
+
+    REQUIRE_THROWS_AS(stream.read(1, 10s), std::runtime_error);
+  }
+}
@@ -115,3 +115,21 @@ TEST_CASE("VvcInstance_from_json")
     }
   }
 }
+
+TEST_CASE("PacketMeta_json")
+{
+  INFO("PacketMeta_json test start. Checks conversion of PacketMeta to and from json.");
+
+  PacketMeta meta{.tid = 1, .tdest = 2, .tuser = 0xAB};
+  nlohmann::json j = meta;
+
+  REQUIRE(j["tid"] == 1);
+  REQUIRE(j["tdest"] == 2);
+  REQUIRE(j["tuser"] == 0xAB);
+  REQUIRE(j.get<PacketMeta>() == meta);
+
+  INFO("Fields left out are zero");
+  PacketMeta partial = nlohmann::json{{"tdest", 3}};
+  REQUIRE(partial == PacketMeta{.tid = 0, .tdest = 3, .tuser = 0});
+  REQUIRE(nlohmann::json::object().get<PacketMeta>() == PacketMeta{});
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "uvvm_cosim_types.hpp"
+#include "vvc_registry.hpp"
+
+using namespace uvvm_cosim;
+
+TEST_CASE("VvcRegistry_lookup")
+{
+  INFO("VvcRegistry_lookup test start.");
+
+  VvcRegistry<int> reg;
+
+  INFO("Empty registry");
+  REQUIRE(reg.empty());
+  REQUIRE(reg.find({"UART_VVC", "TX", 0}) == reg.end());
+  REQUIRE_FALSE(reg.find_handle({"UART_VVC", "TX", 0}).has_value());
+  REQUIRE_THROWS_AS(reg.resolve({"UART_VVC", "TX", 0}), std::runtime_error);
+  REQUIRE_THROWS_AS(reg.entry(0), std::runtime_error);
+
+  INFO("Add enough VVCs to grow the table a few times");
+  std::vector<VvcInstanceKey> keys;
+
+  for (int i = 0; i < 200; i++) {
+    keys.push_back({"UART_VVC", "TX", i});
+    keys.push_back({"UART_VVC", "RX", i});
+    keys.push_back({"AXISTREAM_VVC", "NA", i});
+  }
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto [it, added] = reg.emplace(keys[i], int(i));
+    REQUIRE(added);
+    REQUIRE(it->second == int(i));
+  }
+
+  REQUIRE(reg.size() == keys.size());
+
+  INFO("Handles are assigned in the order VVCs were added");
+  for (size_t i = 0; i < keys.size(); i++) {
+    VvcHandle handle = reg.resolve(keys[i]);
+    REQUIRE(handle == i);
+    REQUIRE(reg.entry(handle).first.vvc_channel == keys[i].vvc_channel);
+    REQUIRE(reg.entry(handle).second == int(i));
+    REQUIRE(reg.find(keys[i])->second == int(i));
+  }
+
+  INFO("Iteration is in the same order");
+  int n = 0;
+  for (auto& [key, value] : reg) {
+    REQUIRE(value == n++);
+  }
+
+  INFO("Adding a VVC twice keeps the first one");
+  auto [it, added] = reg.emplace(keys[5], -1);
+  REQUIRE_FALSE(added);
+  REQUIRE(it->second == 5);
+  REQUIRE(reg.size() == keys.size());
+
+  INFO("Unknown type, channel or instance");
+  REQUIRE(reg.find({"AVALON_ST_VVC", "NA", 0}) == reg.end());
+  REQUIRE(reg.find({"AXISTREAM_VVC", "TX", 0}) == reg.end());
+  REQUIRE(reg.find({"AXISTREAM_VVC", "NA", 200}) == reg.end());
+  REQUIRE(reg.find({"AXISTREAM_VVC", "NA", -1}) == reg.end());
+  REQUIRE_THROWS_AS(reg.entry(VvcHandle(keys.size())), std::runtime_error);
+}